@@ -0,0 +1,129 @@
+/**
+ * @file alphabet.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the word alphabet object
+ *
+ * The alphabet is compiled from its specification into tables indexed by
+ * the byte value, so classifying, case folding and indexing a character
+ * each cost a single load
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+
+/**
+ * @brief   compile an alphabet specification into its tables
+ * @details the specification lists the letters, "x-y" standing for every
+ *          byte from x to y;  A '-' first or last stands for itself.  Upper
+ *          case letters which are not listed fold onto their lower case
+ *          letter when it is listed
+ * @param   spec the specification, for example "a-z0-9_'"
+ * @param   alphabet the compiled alphabet
+ * @return  0 - success, -1 - invalid specification
+ */
+int
+alphabetParse(const char* spec,
+              Alphabet* alphabet)
+{
+
+    bool member[256] = { false };
+
+    if (*spec == '\0') {
+        return (-1);
+    }
+
+    for (const unsigned char* s = (const unsigned char*) spec; *s != '\0'; ) {
+
+        unsigned int first = s[0];
+        unsigned int last = s[0];
+
+        if (s[1] == '-' && s[2] != '\0') {
+            last = s[2];
+            s += 3;
+        }
+        else {
+            s++;
+        }
+
+        if (first > last) {
+            return (-1);
+        }
+
+        for (unsigned int c = first; c <= last; c++) {
+            member[c] = true;
+        }
+
+    }
+
+    /* The newline delimits the words between the jobs. */
+    if (member['\n']) {
+        return (-1);
+    }
+
+    Alphabet compiled = { .size = 0 };
+
+    memset(compiled.index, ALPHABET_NONE, sizeof(compiled.index));
+
+    for (unsigned int c = 1; c < 256; c++) {
+        if (member[c]) {
+            compiled.fold[c] = c;
+            compiled.index[c] = compiled.size;
+            compiled.letter[compiled.size++] = c;
+        }
+    }
+
+    for (unsigned int c = 'A'; c <= 'Z'; c++) {
+        if (!member[c] && member[c - 'A' + 'a']) {
+            compiled.fold[c] = c - 'A' + 'a';
+            compiled.index[c] = compiled.index[c - 'A' + 'a'];
+        }
+    }
+
+    *alphabet = compiled;
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,113 @@
+/**
+ * @file alphabet.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the word alphabet object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+/**
+ * @brief   the alphabet of the words unless one is given on the command line
+ */
+#define ALPHABET_DEFAULT    "a-z"
+
+enum {
+    ALPHABET_NONE = 0xff,                   /** index of a byte not a letter */
+    ALPHABET_SIZE = 254,                    /** maximum number of letters,
+                                                every byte but '\0' and '\n' */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Alphabet Alphabet;
+
+/**
+ * @brief   object representing the letters words are made of
+ * @details the letters are numbered in ascending byte order, so walking the
+ *          children of a node by index visits the words in byte order
+ */
+struct Alphabet {
+    uint32_t size;                          /** number of letters, the
+                                                fan-out of a trie node */
+    uint8_t fold[256];                      /** letter of each byte after
+                                                case folding, 0 if none */
+    uint8_t index[256];                     /** child index of each byte,
+                                                ALPHABET_NONE if none */
+    char letter[ALPHABET_SIZE];             /** letter of each child index */
+};
+
+/**
+ * @brief   the alphabet selected on the command line - Global
+ */
+extern Alphabet alphabet;
+
+/**
+ * @brief   the letters of the alphabet selected on the command line, for
+ *          the contexts of the library - Global
+ */
+extern const char* alphabetLetters;
+
+/**
+ * @brief   map a character of a word to its child index
+ * @param   alphabet the alphabet of the word
+ * @param   c the character
+ * @return  the child index, ALPHABET_NONE if the character is not a letter
+ */
+static inline uint32_t
+alphabetIndex(const Alphabet* alphabet,
+              char c)
+{
+
+    return (alphabet->index[(unsigned char) c]);
+
+}
+
+/**
+ * @brief   function prototype
+ */
+int
+alphabetParse(const char* spec,
+              Alphabet* alphabet);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
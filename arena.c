@@ -0,0 +1,168 @@
+/**
+ * @file arena.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for string arena object
+ *
+ * Strings are referenced by their offset into the arena rather than by
+ * pointer so that the storage can grow with realloc();  Offset zero is
+ * reserved to mean "no string"
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <arena.h>
+
+/**
+ * @brief   append a copy of a string to the arena
+ * @param   arena the arena receiving the string
+ * @param   string the string to be copied
+ * @param   length the length of the string, excluding the terminator
+ * @return  the offset of the copy within the arena, 0 if the arena could
+ *          not grow
+ */
+uint32_t
+arenaAppend(Arena* arena,
+            const char* string,
+            size_t length)
+{
+
+    /* Offsets are 32 bits wide to keep the referencing objects small. */
+    if (arena->used + length + 1 > UINT32_MAX) {
+        return (0);
+    }
+
+    /* Grow the storage geometrically to keep appends amortized O(1). */
+    if (arena->used + length + 1 > arena->size) {
+
+        size_t size = arena->size;
+
+        while (arena->used + length + 1 > size) {
+            size *= 2;
+        }
+
+        char* base = realloc(arena->base, size);
+
+        if (!base) {
+            return (0);
+        }
+
+        arena->base = base;
+        arena->size = size;
+
+    }
+
+    uint32_t offset = arena->used;
+
+    memcpy(arena->base + offset, string, length);
+    arena->base[offset + length] = '\0';
+    arena->used += length + 1;
+
+    return (offset);
+
+}
+
+/**
+ * @brief   release an arena object and its string storage
+ * @param   arena the arena to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+arenaFree(Arena* arena)
+{
+
+    free(arena->base);
+    free(arena);
+
+    return (0);
+
+}
+
+/**
+ * @brief   allocate a new arena object
+ * @param   size the initial size of the string storage
+ * @return  a pointer to the newly allocated arena object, NULL if memory
+ *          could not be allocated
+ */
+Arena*
+arenaNew(size_t size)
+{
+
+    Arena* arena;
+
+    arena = calloc(1, sizeof(*arena));
+    if (!arena) {
+        return (NULL);
+    }
+
+    arena->size = (size > 1) ? size : 2;
+    arena->base = malloc(arena->size);
+
+    if (!arena->base) {
+        free(arena);
+        return (NULL);
+    }
+
+    /* Reserve offset zero as the "no string" reference. */
+    arena->base[0] = '\0';
+    arena->used = 1;
+
+    return (arena);
+
+}
+
+/**
+ * @brief   discard every string of an arena, keeping its storage
+ * @param   arena the arena to be emptied
+ * @return  0 - success, -1 - failure
+ */
+int
+arenaReset(Arena* arena)
+{
+
+    arena->used = 1;
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,475 @@
+/**
+ * @file compare.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for comparing the words of two inputs
+ *
+ * Both inputs are counted in this process, each into a trie of its own on a
+ * thread of its own when there is more than one processor.  The tries share
+ * the alphabet and so the layout of their nodes, which lets one walk visit
+ * them in lockstep:  Each word is seen once with its count in either input,
+ * and is offered to the heap of the changes or to the heap of the words
+ * unique to its input, without writing out or sorting any text.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <compare.h>
+#include <count.h>
+#include <counter.h>
+#include <heap.h>
+#include <input.h>
+#include <page.h>
+#include <trie.h>
+
+/*
+ * forward declarations
+ */
+typedef struct Compare Compare;
+typedef struct CompareSide CompareSide;
+
+/**
+ * @brief   object representing one of the inputs being compared
+ */
+struct CompareSide {
+    const char* name;   /** name of the input, "-" for standard input */
+    uint32_t worker;    /** number of the worker counting the input */
+    int node;           /** NUMA node of the worker, -1 if not bound */
+    Trie* trie;         /** words of the input */
+    uint64_t words;     /** words counted */
+    double elapsed;     /** milliseconds spent counting */
+    int status;         /** 0 - counted, -1 - failure */
+};
+
+/**
+ * @brief   object representing the comparison of two inputs
+ */
+struct Compare {
+    CompareSide side[2];    /** the inputs, the earlier one first */
+    Heap* change;           /** the largest changes of the words in both */
+    Heap* only[2];          /** the most frequent words of one input only */
+    double rate[2];         /** occurrences per million words, per
+                                occurrence in each input */
+};
+
+/**
+ * @brief   the comparison selected on the command line - Global
+ */
+CompareMode compareMode = COMPARE_NONE;
+
+/*
+ * function prototypes
+ */
+static int
+compareDump(Compare* compare,
+            FILE* ofp);
+
+static TriePairFunc compareOffer;
+
+static int
+compareRead(CompareSide* side);
+
+static void*
+compareThread(void* argument);
+
+/**
+ * @brief   count two inputs and display how their words changed
+ * @details the changes come first, as the change, the count in the first
+ *          and in the second input, then the word;  Relative changes and
+ *          counts are per million words of each input.  An empty line
+ *          follows, then the words only found in the first input, another
+ *          empty line and the words only found in the second input
+ * @param   first the name of the earlier input, "-" for standard input
+ * @param   second the name of the later input, "-" for standard input
+ * @param   ofp the output stream for the changes and the words
+ * @return  0 - success, -1 - failure
+ */
+int
+compareCount(const char* first,
+             const char* second,
+             FILE* ofp)
+{
+
+    Compare compare = {
+        .side = {
+            { .name = first, .worker = 0, .node = -1 },
+            { .name = second, .worker = 1, .node = -1 },
+        },
+        .change = heapNew(frequencyCount),
+        .only = { heapNew(frequencyCount), heapNew(frequencyCount) },
+    };
+
+    assert(compare.change && compare.only[0] && compare.only[1]);
+
+    /*
+     * The first input is counted by a thread of its own when another
+     * processor can run it, and by this thread otherwise.
+     */
+    pthread_t thread;
+    bool threaded = sysconf(_SC_NPROCESSORS_ONLN) > 1
+                    && pthread_create(&thread, NULL, compareThread,
+                                      &compare.side[0]) == 0;
+
+    if (!threaded) {
+        compareThread(&compare.side[0]);
+    }
+
+    compareThread(&compare.side[1]);
+
+    if (threaded) {
+        pthread_join(thread, NULL);
+    }
+
+    int status = (compare.side[0].status == 0
+                  && compare.side[1].status == 0) ? 0 : -1;
+
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (uint32_t i = 0; i < 2; i++) {
+        compare.rate[i] = compare.side[i].words ? 1e6 / compare.side[i].words
+                                                : 0;
+    }
+
+    if (status == 0) {
+        status = trieWalkPair(compare.side[0].trie, compare.side[1].trie,
+                              compareOffer, &compare);
+    }
+
+    if (status == 0) {
+        status = compareDump(&compare, ofp);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (countStats) {
+
+        for (uint32_t i = 0; i < 2; i++) {
+            fprintf(stderr, "wf: %s: %" PRIu64 " words, %zu trie nodes,"
+                    " counted in %.1f ms%s", compare.side[i].name,
+                    compare.side[i].words, compare.side[i].trie->nodes,
+                    compare.side[i].elapsed,
+                    threaded ? ", concurrently" : "");
+
+            if (compare.side[i].node != -1) {
+                fprintf(stderr, " on NUMA node %d", compare.side[i].node);
+            }
+
+            fprintf(stderr, "\n");
+        }
+
+        fprintf(stderr, "wf: compared in %.1f ms\n",
+                (end.tv_sec - start.tv_sec) * 1e3
+                + (end.tv_nsec - start.tv_nsec) / 1e6);
+
+    }
+
+    /*
+     * Since this is a filter the tries and the heaps are left to the
+     * operating system to clean up upon process termination.
+     */
+    return (status);
+
+}
+
+/**
+ * @brief   display the changes and the words unique to either input
+ * @param   compare the comparison
+ * @param   ofp the output stream for the changes and the words
+ * @return  0 - success, -1 - failure
+ */
+static int
+compareDump(Compare* compare,
+            FILE* ofp)
+{
+
+    heapSort(compare->change);
+
+    /* The heap only keeps the size of a change, its counts are found again. */
+    for (uint32_t i = 0; i < compare->change->count; i++) {
+
+        const char* word = compare->change->words->base
+                           + compare->change->vector[i].word;
+        uint64_t frequency[2];
+
+        for (uint32_t j = 0; j < 2; j++) {
+            Trie* trie = compare->side[j].trie;
+            TrieNode* node = trieFind(trie, word);
+            frequency[j] = node ? counterValue(&trie->wide, node->frequency)
+                                : 0;
+        }
+
+        if (compareMode == COMPARE_RELATIVE) {
+            fprintf(ofp, "%+.3f %.3f %.3f %s\n",
+                    frequency[1] * compare->rate[1]
+                    - frequency[0] * compare->rate[0],
+                    frequency[0] * compare->rate[0],
+                    frequency[1] * compare->rate[1], word);
+        }
+        else {
+            fprintf(ofp, "%+" PRId64 " %" PRIu64 " %" PRIu64 " %s\n",
+                    (int64_t) (frequency[1] - frequency[0]), frequency[0],
+                    frequency[1], word);
+        }
+
+    }
+
+    for (uint32_t i = 0; i < 2; i++) {
+        fprintf(ofp, "\n");
+        heapSort(compare->only[i]);
+        heapDump(compare->only[i], ofp);
+    }
+
+    return (ferror(ofp) ? -1 : 0);
+
+}
+
+/**
+ * @brief   convert a comparison name into its mode
+ * @param   name one of "absolute" or "relative"
+ * @param   mode the converted mode
+ * @return  0 - success, -1 - unknown name
+ */
+int
+compareModeParse(const char* name,
+                 CompareMode* mode)
+{
+
+    static const struct {
+        const char* name;
+        CompareMode mode;
+    } modeVector[] = {
+        { "absolute", COMPARE_ABSOLUTE },
+        { "relative", COMPARE_RELATIVE },
+    };
+
+    for (size_t i = 0; i < sizeof(modeVector) / sizeof(modeVector[0]); i++) {
+        if (strcmp(name, modeVector[i].name) == 0) {
+            *mode = modeVector[i].mode;
+            return (0);
+        }
+    }
+
+    return (-1);
+
+}
+
+/**
+ * @brief   offer a word seen in either input to the changes or to the words
+ *          of one input only
+ * @param   argument the comparison
+ * @param   word the word
+ * @param   first the frequency of the word in the first input, 0 if none
+ * @param   second the frequency of the word in the second input, 0 if none
+ * @return  0 - success, -1 - failure
+ */
+static int
+compareOffer(void* argument,
+             const char* word,
+             uint64_t first,
+             uint64_t second)
+{
+
+    Compare* compare = argument;
+
+    /* Only words with the prefix are displayed. */
+    if (frequencyPrefix
+        && strncmp(word, frequencyPrefix, strlen(frequencyPrefix)) != 0) {
+        return (0);
+    }
+
+    if (second == 0) {
+        return (heapOffer(compare->only[0], word, first));
+    }
+
+    if (first == 0) {
+        return (heapOffer(compare->only[1], word, second));
+    }
+
+    /* A relative change is kept in thousandths of an occurrence. */
+    uint64_t change;
+
+    if (compareMode == COMPARE_RELATIVE) {
+        change = llround(fabs(second * compare->rate[1]
+                              - first * compare->rate[0]) * 1000);
+    }
+    else {
+        change = (first > second) ? first - second : second - first;
+    }
+
+    /* A word used as often in both inputs has not changed. */
+    if (change == 0) {
+        return (0);
+    }
+
+    return (heapOffer(compare->change, word, change));
+
+}
+
+/**
+ * @brief   count the words of one input into its trie
+ * @param   side the input
+ * @return  0 - success, -1 - failure
+ */
+static int
+compareRead(CompareSide* side)
+{
+
+    int fd = (strcmp(side->name, "-") == 0) ? STDIN_FILENO
+                                            : open(side->name, O_RDONLY);
+
+    if (fd == -1) {
+        fprintf(stderr, "wf: cannot open %s: %s\n", side->name,
+                strerror(errno));
+        return (-1);
+    }
+
+    Input* input = inputNew(fd, inputMode);
+    InputBuffer* buffer;
+
+    /* A word may span the boundary between two read buffers. */
+    size_t size = 64;
+    char* word = malloc(size);
+    size_t length = 0;
+
+    assert(input && word);
+
+    int status = 0;
+
+    while ((buffer = inputNext(input)) != NULL) {
+
+        for (size_t i = 0; i < buffer->length && status == 0; i++) {
+
+            unsigned char letter = alphabet.fold[(unsigned char)
+                                                 buffer->data[i]];
+
+            if (letter != 0) {
+
+                /* Leave room for the terminator of the word. */
+                if (length + 1 >= size) {
+                    size *= 2;
+                    word = realloc(word, size);
+                    assert(word);
+                }
+
+                word[length++] = letter;
+
+            }
+
+            else if (length != 0) {
+                word[length] = '\0';
+                status = trieInsert(side->trie, word) ? 0 : -1;
+                side->words++;
+                length = 0;
+            }
+
+        }
+
+        inputRelease(input, buffer);
+
+    }
+
+    /* If a valid word was in process count it as well. */
+    if (status == 0 && length != 0) {
+        word[length] = '\0';
+        status = trieInsert(side->trie, word) ? 0 : -1;
+        side->words++;
+    }
+
+    if (inputFree(input) == -1) {
+        fprintf(stderr, "wf: cannot read %s: %s\n", side->name,
+                strerror(errno));
+        status = -1;
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    free(word);
+
+    return (status);
+
+}
+
+/**
+ * @brief   entry point of the thread counting one input
+ * @details the trie of the input is allocated by the thread counting it, so
+ *          that its nodes are first touched there;  With huge pages the
+ *          thread is bound to a NUMA node of its own first, which then
+ *          holds the nodes
+ * @param   argument the input
+ * @return  NULL
+ */
+static void*
+compareThread(void* argument)
+{
+
+    CompareSide* side = argument;
+
+    if (countHugePages) {
+        side->node = pageBind(side->worker);
+    }
+
+    side->trie = countTrieNew();
+    assert(side->trie);
+
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    side->status = compareRead(side);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    side->elapsed = (end.tv_sec - start.tv_sec) * 1e3
+                    + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    return (NULL);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
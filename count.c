@@ -44,9 +44,749 @@
 
 #include <wf.h>
 
+#include <alphabet.h>
+#include <arena.h>
 #include <count.h>
+#include <document.h>
+#include <hapax.h>
 #include <heap.h>
+#include <packed.h>
+#include <radix.h>
+#include <rank.h>
+#include <spill.h>
+#include <stem.h>
+#include <trace.h>
 #include <trie.h>
+#include <window.h>
+
+/**
+ * @brief   object representing the profile of the words counted so far by
+ *          the automatic engine
+ */
+typedef struct CountProfile {
+    uint64_t words;                     /** words counted */
+    uint64_t bytes;                     /** letters of the words counted */
+    uint64_t distinct;                  /** distinct words counted */
+    uint64_t lastWords;                 /** words at the last profile */
+    uint64_t lastDistinct;              /** distinct words at the last
+                                            profile */
+    uint64_t probeBytes;                /** letters of the next profile */
+    size_t probeNodes;                  /** trie nodes of the next profile */
+    uint32_t longest;                   /** length of the longest word */
+    uint32_t letters;                   /** distinct letters seen */
+    bool seen[ALPHABET_SIZE];           /** letters seen by child index */
+} CountProfile;
+
+/**
+ * @brief   the number of words inserted into the trie together, 1 for one
+ *          at a time - Global
+ */
+uint32_t countBatch = 1;
+
+/**
+ * @brief   the counting structure selected on the command line - Global
+ */
+CountEngine countEngine = COUNT_TRIE;
+
+/**
+ * @brief   keep the words seen once out of the trie - Global
+ */
+bool countHapax = false;
+
+/**
+ * @brief   take the trie nodes from huge pages - Global
+ */
+bool countHugePages = false;
+
+/**
+ * @brief   the number of words after which the trie is re-laid out, 0 for
+ *          never - Global
+ */
+uint64_t countRelayoutAfter = 0;
+
+/**
+ * @brief   the order of the trie nodes after the re-layout - Global
+ */
+TrieOrder countRelayoutOrder = TRIE_HOT;
+
+/**
+ * @brief   report the counting statistics on standard error - Global
+ */
+bool countStats = false;
+
+/*
+ * function prototypes
+ */
+static int
+countAuto(FILE* ifp,
+          FILE* ofp);
+
+static int
+countBatchInsert(Trie* trie,
+                 Heap* heap,
+                 Arena* pending,
+                 const uint32_t* offset,
+                 uint32_t count);
+
+static int
+countDocuments(FILE* ifp,
+               FILE* ofp);
+
+static TrieTopFunc countDump;
+
+static TrieTopFunc countMigrate;
+
+static TrieTopFunc countOffer;
+
+static int
+countPacked(FILE* ifp,
+            FILE* ofp);
+
+static void
+countProfileWord(CountProfile* profile,
+                 const char* word,
+                 size_t length);
+
+static int
+countRank(Trie* trie,
+          Radix* radix,
+          Spill* spill,
+          Hapax* hapax,
+          FILE* ofp);
+
+static TrieTopFunc countRankAdd;
+
+static int
+countSpill(FILE* ifp,
+           FILE* ofp);
+
+static int
+countSpillWrite(Spill* spill,
+                Trie* trie,
+                Radix* radix);
+
+static int
+countStem(FILE* ifp,
+          FILE* ofp);
+
+static int
+countWindow(FILE* ifp,
+            FILE* ofp);
+
+/**
+ * @brief   process a stream of words with the engine suiting the input
+ * @details words are counted by the trie while the input is profiled: the
+ *          length of the words, the rate new words appear at and the
+ *          letters they use.  Whenever the letters counted or the trie
+ *          nodes have doubled the profile is looked at again.  A trie
+ *          spending many nodes on each word, as with long identifiers or
+ *          binary input, moves its words into a radix tree and counting
+ *          carries on there.  Once words mostly repeat the heap stops
+ *          following every count and the top words are found best first
+ *          in the trie at the end
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countAuto(FILE* ifp,
+          FILE* ofp)
+{
+
+    Heap* heap = heapNew(frequencyCount);
+    Trie* trie = countTrieNew();
+    Radix* radix = NULL;
+
+    assert(heap && trie);
+
+    CountProfile profile = {
+        .probeBytes = COUNT_PROBE_BYTES,
+        .probeNodes = COUNT_PROBE_NODES,
+    };
+
+    /* Prefix queries and the full ranking are answered at the end. */
+    bool stream = !frequencyPrefix && !frequencyAll;
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    int status = 0;
+
+    while (status == 0 && getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        size_t length = strlen(buffer) - 1;
+
+        /* Eat the newline. */
+        buffer[length] = '\0';
+
+        profile.words++;
+        profile.bytes += length;
+
+        if (radix) {
+            status = radixInsert(radix, buffer);
+            continue;
+        }
+
+        TrieNode* node = trieInsert(trie, buffer);
+        assert(node);
+
+        uint64_t frequency = counterValue(&trie->wide, node->frequency);
+
+        if (frequency == 1) {
+            countProfileWord(&profile, buffer, length);
+        }
+
+        if (stream) {
+            heapInsert(heap, node, buffer, frequency);
+        }
+
+        if (profile.bytes < profile.probeBytes
+            && trie->nodes < profile.probeNodes) {
+            continue;
+        }
+
+        struct timespec start;
+        struct timespec end;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        /* The new words since the last profile give the growth rate. */
+        uint64_t words = profile.words - profile.lastWords;
+        uint64_t fresh = profile.distinct - profile.lastDistinct;
+        size_t nodes = trie->nodes;
+        const char* choice = stream ? "trie, streamed heap"
+                                    : "trie, best first";
+
+        if (nodes >= COUNT_AUTO_NODES * profile.distinct) {
+
+            radix = radixNew();
+            assert(radix);
+
+            status = trieWalk(trie, countMigrate, radix);
+
+            trieFree(trie);
+            trie = NULL;
+
+            heapReset(heap);
+            stream = false;
+            choice = "radix";
+
+        }
+        else if (stream && fresh * COUNT_AUTO_REPEAT < words) {
+            heapReset(heap);
+            stream = false;
+            choice = "trie, best first";
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if (countStats) {
+            fprintf(stderr, "wf: after %" PRIu64 " words, %.1f letters per"
+                    " word, %" PRIu32 " at most, %" PRIu32 " of %" PRIu32
+                    " letters, %.1f%% new words, %.1f trie nodes per word:"
+                    " %s in %.1f ms\n", profile.words,
+                    (double) profile.bytes / profile.words, profile.longest,
+                    profile.letters, alphabet.size, 100.0 * fresh / words,
+                    (double) nodes / profile.distinct, choice,
+                    (end.tv_sec - start.tv_sec) * 1e3
+                    + (end.tv_nsec - start.tv_nsec) / 1e6);
+        }
+
+        /* Look again once the input or the trie has doubled. */
+        profile.lastWords = profile.words;
+        profile.lastDistinct = profile.distinct;
+        profile.probeBytes = 2 * profile.bytes;
+        profile.probeNodes = 2 * nodes;
+
+    }
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        status = -1;
+    }
+
+    if (countStats && radix) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu radix nodes of %zu bytes,"
+                " %zu label bytes\n", profile.words, radix->nodes,
+                radix->nodeSize, radix->labels->used);
+    }
+    else if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu trie nodes of %zu bytes\n",
+                profile.words, trie->nodes, trie->nodeSize);
+    }
+
+    /* Rank every word, or offer each word of the radix tree to the heap. */
+    if (status == 0 && frequencyAll) {
+        status = countRank(trie, radix, NULL, NULL, ofp);
+    }
+    else if (status == 0 && radix) {
+        status = radixWalk(radix, countOffer, heap);
+    }
+
+    /* Find the top words, with the prefix if any, best first. */
+    else if (status == 0 && !stream) {
+        status = trieTop(trie, frequencyPrefix ? frequencyPrefix : "",
+                         frequencyCount, countDump, ofp);
+    }
+
+    /* Only sort and display if every word was counted. */
+    if (status == 0 && !frequencyAll && (radix || stream)) {
+        heapSort(heap);
+        heapDump(heap, ofp);
+    }
+
+    if (radix) {
+        radixFree(radix);
+    }
+    else {
+        trieFree(trie);
+    }
+
+    heapFree(heap);
+
+    return (status);
+
+}
+
+/**
+ * @brief   insert a batch of pending words into the trie and the heap
+ * @details the words enter the heap with their frequency after the whole
+ *          batch was counted, every word counted in the batch is offered
+ *          again so the heap ends up the same as one word at a time
+ * @param   trie the trie
+ * @param   heap the heap
+ * @param   pending the text of the pending words, emptied
+ * @param   offset the offsets of the pending words within the text
+ * @param   count the number of pending words
+ * @return  0 - success, -1 - failure
+ */
+static int
+countBatchInsert(Trie* trie,
+                 Heap* heap,
+                 Arena* pending,
+                 const uint32_t* offset,
+                 uint32_t count)
+{
+
+    const char* words[TRIE_BATCH_MAX] = { NULL };
+    TrieNode* nodes[TRIE_BATCH_MAX];
+
+    for (uint32_t i = 0; i < count; i++) {
+        words[i] = pending->base + offset[i];
+    }
+
+    if (trieInsertBatch(trie, words, count, nodes) == -1) {
+        return (-1);
+    }
+
+    /*
+     * Prefix queries and the full ranking are answered from the trie
+     * once it is complete.
+     */
+    for (uint32_t i = 0; i < count && !frequencyPrefix && !frequencyAll; i++) {
+        heapInsert(heap, nodes[i], words[i],
+                   counterValue(&trie->wide, nodes[i]->frequency));
+    }
+
+    arenaReset(pending);
+
+    return (0);
+
+}
+
+/**
+ * @brief   process a stream of documents ranking the words across them
+ * @details the documents are separated by an empty line;  Each word counts
+ *          once per document containing it, or its occurrences are weighted
+ *          by its rarity, and the term counts of each document are streamed
+ *          out as the document ends
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countDocuments(FILE* ifp,
+               FILE* ofp)
+{
+
+    FILE* terms = NULL;
+
+    if (documentTerms) {
+        terms = fopen(documentTerms, "w");
+        if (!terms) {
+            fprintf(stderr, "wf: cannot create %s: %s\n", documentTerms,
+                    strerror(errno));
+            return (-1);
+        }
+    }
+
+    Heap* heap = heapNew(frequencyCount);
+    Document* document = documentNew(terms);
+
+    assert(heap);
+    assert(document);
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    uint64_t words = 0;
+    int status = 0;
+
+    while (status == 0 && getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        /* Eat the newline, an empty line ends the document. */
+        buffer[strlen(buffer)-1] = '\0';
+
+        if (buffer[0] == '\0') {
+            status = documentEnd(document);
+            continue;
+        }
+
+        words++;
+        status = documentInsert(document, buffer);
+
+    }
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        status = -1;
+    }
+
+    /* A document without the trailing empty line still counts. */
+    if (status == 0 && document->seenCount != 0) {
+        status = documentEnd(document);
+    }
+
+    if (terms && fclose(terms) != 0) {
+        status = -1;
+    }
+
+    if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %" PRIu32 " documents, %"
+                PRIu32 " terms, %zu trie nodes of %zu bytes\n", words,
+                document->current, document->terms - 1,
+                document->trie->nodes, document->trie->nodeSize);
+    }
+
+    if (status == -1) {
+        fprintf(stderr, "wf: counting the documents failed: %s\n",
+                strerror(errno));
+    }
+
+    /* Rank by the occurrences weighted by the rarity. */
+    else if (documentRank == DOCUMENT_TFIDF) {
+        status = documentScore(document, heap, ofp);
+    }
+
+    /* Rank by the number of documents, the trie holds them as frequency. */
+    else if (frequencyAll) {
+        status = countRank(document->trie, NULL, NULL, NULL, ofp);
+    }
+    else if (frequencyPrefix) {
+        status = trieTop(document->trie, frequencyPrefix, frequencyCount,
+                         countDump, ofp);
+    }
+    else {
+        status = trieWalk(document->trie, countOffer, heap);
+        if (status == 0) {
+            heapSort(heap);
+            heapDump(heap, ofp);
+        }
+    }
+
+    documentFree(document);
+    heapFree(heap);
+
+    return (status);
+
+}
+
+/**
+ * @brief   display the frequency count and word of a query result
+ * @param   argument the output file stream
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+countDump(void* argument,
+          const char* word,
+          uint64_t frequency)
+{
+
+    FILE* ofp = argument;
+
+    fprintf(ofp, "%" PRIu64 " %s\n", frequency, word);
+
+    return (0);
+
+}
+
+/**
+ * @brief   convert a counting structure name into its engine
+ * @param   name one of "trie", "radix", "auto" or "packed"
+ * @param   engine the converted engine
+ * @return  0 - success, -1 - unknown name
+ */
+int
+countEngineParse(const char* name,
+                 CountEngine* engine)
+{
+
+    static const struct {
+        const char* name;
+        CountEngine engine;
+    } engineVector[] = {
+        { "trie",   COUNT_TRIE },
+        { "radix",  COUNT_RADIX },
+        { "auto",   COUNT_AUTO },
+        { "packed", COUNT_PACKED },
+    };
+
+    for (size_t i = 0; i < sizeof(engineVector) / sizeof(engineVector[0]);
+         i++) {
+        if (strcmp(name, engineVector[i].name) == 0) {
+            *engine = engineVector[i].engine;
+            return (0);
+        }
+    }
+
+    return (-1);
+
+}
+
+/**
+ * @brief   add a word with its count so far to the radix tree taking over
+ *          from the trie
+ * @param   argument the radix tree
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+countMigrate(void* argument,
+             const char* word,
+             uint64_t frequency)
+{
+
+    return (radixAdd(argument, word, frequency));
+
+}
+
+/**
+ * @brief   convert a trie node order name into its order
+ * @param   name one of "bfs" or "hot"
+ * @param   order the converted order
+ * @return  0 - success, -1 - unknown name
+ */
+int
+countOrderParse(const char* name,
+                TrieOrder* order)
+{
+
+    static const struct {
+        const char* name;
+        TrieOrder order;
+    } orderVector[] = {
+        { "bfs", TRIE_BREADTH },
+        { "hot", TRIE_HOT },
+    };
+
+    for (size_t i = 0; i < sizeof(orderVector) / sizeof(orderVector[0]); i++) {
+        if (strcmp(name, orderVector[i].name) == 0) {
+            *order = orderVector[i].order;
+            return (0);
+        }
+    }
+
+    return (-1);
+
+}
+
+/**
+ * @brief   offer a word with its final count to the heap
+ * @param   argument the heap
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+countOffer(void* argument,
+           const char* word,
+           uint64_t frequency)
+{
+
+    /* Only words with the prefix are displayed. */
+    if (frequencyPrefix
+        && strncmp(word, frequencyPrefix, strlen(frequencyPrefix)) != 0) {
+        return (0);
+    }
+
+    return (heapOffer(argument, word, frequency));
+
+}
+
+/**
+ * @brief   process a stream of words counting the short ones by packed key
+ * @details a word of up to PACKED_LETTERS letters is packed into an integer
+ *          and counted by a hash table, with one hash and no pointer chase;
+ *          Only the longer words are counted by the trie.  The top words of
+ *          either are offered to the heap at the end, those of the table
+ *          selected by integer compares, and the full ranking merges the
+ *          two in byte order
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countPacked(FILE* ifp,
+            FILE* ofp)
+{
+
+    Packed* packed = packedNew();
+    Trie* trie = countTrieNew();
+
+    assert(packed && trie);
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    uint64_t words = 0;
+    uint64_t longer = 0;
+    int status = 0;
+
+    uint64_t span = traceStart();
+
+    while (status == 0 && getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        /* Eat the newline. */
+        buffer[strlen(buffer)-1] = '\0';
+
+        if (++words % TRACE_WORDS == 0) {
+            traceSpan("insert", span);
+            span = traceStart();
+        }
+
+        uint64_t key;
+
+        if (packedEncode(buffer, &key)) {
+            status = packedInsert(packed, key);
+        }
+        else {
+            status = trieInsert(trie, buffer) ? 0 : -1;
+            longer++;
+        }
+
+    }
+
+    traceSpan("insert", span);
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        status = -1;
+    }
+
+    if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %" PRIu32 " packed words in"
+                " %" PRIu32 " slots, %" PRIu64 " longer words in %zu trie"
+                " nodes of %zu bytes\n", words, packed->count, packed->size,
+                longer, trie->nodes, trie->nodeSize);
+    }
+
+    uint64_t start = traceStart();
+
+    /* Rank every word, merging the packed words into the trie walk. */
+    if (status == 0 && frequencyAll) {
+
+        Rank* rank = rankNew();
+        assert(rank);
+
+        status = packedMerge(packed, trie, countRankAdd, rank);
+
+        /* The ranking bypasses the stream, write out anything before it. */
+        if (status == 0 && fflush(ofp) == 0) {
+            status = rankDump(rank, fileno(ofp));
+        }
+
+        rankFree(rank);
+
+    }
+
+    /* Only the top words of either can make the top words of both. */
+    else if (status == 0) {
+
+        Heap* heap = heapNew(frequencyCount);
+        assert(heap);
+
+        status = trieTop(trie, frequencyPrefix ? frequencyPrefix : "",
+                         frequencyCount, countOffer, heap);
+
+        if (status == 0) {
+            status = packedTop(packed, frequencyPrefix, frequencyCount,
+                               countOffer, heap);
+        }
+
+        if (status == 0) {
+            heapSort(heap);
+            heapDump(heap, ofp);
+        }
+
+        heapFree(heap);
+
+    }
+
+    traceSpan("rank", start);
+
+    packedFree(packed);
+    trieFree(trie);
+
+    return (status);
+
+}
+
+/**
+ * @brief   add a word seen for the first time to the profile of the input
+ * @param   profile the profile
+ * @param   word the word
+ * @param   length the length of the word
+ * @return  none
+ */
+static void
+countProfileWord(CountProfile* profile,
+                 const char* word,
+                 size_t length)
+{
+
+    profile->distinct++;
+
+    if (length > profile->longest) {
+        profile->longest = length;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+
+        uint32_t index = alphabetIndex(&alphabet, word[i]);
+
+        if (!profile->seen[index]) {
+            profile->seen[index] = true;
+            profile->letters++;
+        }
+
+    }
+
+}
 
 /**
  * @brief   process a stream of words and determine each word's frequency
@@ -59,9 +799,48 @@ count(FILE* ifp,
       FILE* ofp)
 {
 
+    /* Counts across documents are kept by the document object. */
+    if (documentRank != DOCUMENT_NONE) {
+        return (countDocuments(ifp, ofp));
+    }
+
+    /* Counts by stem are kept by the stem object. */
+    if (stemEnabled) {
+        return (countStem(ifp, ofp));
+    }
+
+    /* Counts over a sliding window are kept by the window object. */
+    if (windowSpan.length != 0) {
+        return (countWindow(ifp, ofp));
+    }
+
+    /*
+     * Counts beyond the memory budget are spilled to disk, and the radix
+     * tree is ranked once it is complete, as is a spilled trie.
+     */
+    if (spillBudget != 0 || countEngine == COUNT_RADIX) {
+        return (countSpill(ifp, ofp));
+    }
+
+    /* The engine is chosen, and changed, as the input is counted. */
+    if (countEngine == COUNT_AUTO) {
+        return (countAuto(ifp, ofp));
+    }
+
+    /* The short words are counted by packed key, the long ones by trie. */
+    if (countEngine == COUNT_PACKED) {
+        return (countPacked(ifp, ofp));
+    }
+
     /* Create a new trie and a new heap */
     Heap* heap = heapNew(frequencyCount);
-    TrieNode* trie = trieNodeNew();
+    Trie* trie = countTrieNew();
+    Hapax* hapax = NULL;
+
+    if (countHapax) {
+        hapax = hapaxNew();
+        assert(hapax);
+    }
 
     /*
      * Process each newline delimited word in the input stream and insert
@@ -69,16 +848,108 @@ count(FILE* ifp,
      */
     char* buffer = NULL;
     size_t buffer_size = 0;
+    uint64_t words = 0;
+    double relayout = -1;
 
-    while (getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+    /* Words waiting to be inserted together, copied out of the buffer. */
+    Arena* pending = NULL;
+    uint32_t offset[TRIE_BATCH_MAX];
+    uint32_t batched = 0;
+
+    if (countBatch > 1) {
+        pending = arenaNew(4096);
+        assert(pending);
+    }
+
+    /*
+     * The words are traced a span of TRACE_WORDS at a time, and a read
+     * which took long enough to have waited on the pipe on its own.
+     */
+    uint64_t span = traceStart();
+    uint64_t wait;
+
+    while ((wait = traceStart(), getdelim(&buffer, &buffer_size, '\n',
+                                          ifp)) != -1) {
+
+        if (traceEnabled && traceClock() - wait >= TRACE_STALL_NS) {
+            traceSpan("pipe read", wait);
+        }
 
         /* Eat the newline. */
         buffer[strlen(buffer)-1] = '\0';
 
-        TrieNode* node = trieInsert(trie, buffer);
+        /*
+         * Once warmed up the nodes are moved so that the frequent words
+         * share cache lines, and counting continues on the copy.
+         */
+        if (++words == countRelayoutAfter) {
+
+            struct timespec start;
+            struct timespec end;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+
+            if (trieRelayout(trie, countRelayoutOrder, heapMove, heap) == 0) {
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                relayout = (end.tv_sec - start.tv_sec) * 1e3
+                           + (end.tv_nsec - start.tv_nsec) / 1e6;
+            }
+
+        }
+
+        if (words % TRACE_WORDS == 0) {
+            traceSpan("insert", span);
+            span = traceStart();
+        }
+
+        if (pending) {
+
+            offset[batched] = arenaAppend(pending, buffer, strlen(buffer));
+            assert(offset[batched] != 0);
+
+            if (++batched == countBatch) {
+                int status = countBatchInsert(trie, heap, pending, offset,
+                                              batched);
+                assert(status != -1);
+                batched = 0;
+            }
+
+            continue;
+
+        }
+
+        TrieNode* node = hapax ? trieInsertFound(trie, buffer)
+                               : trieInsert(trie, buffer);
+
+        /*
+         * A word new to the trie is only remembered on its first sighting,
+         * and counted twice once it is seen again.
+         */
+        if (!node) {
+
+            int seen = hapaxInsert(hapax, buffer);
+            assert(seen != -1);
+
+            if (seen == 0) {
+                continue;
+            }
+
+            node = trieInsert(trie, buffer);
+            assert(node);
+            node = trieInsert(trie, buffer);
+
+        }
+
         assert(node);
 
-        heapInsert(heap, node, buffer);
+        /*
+         * Prefix queries and the full ranking are answered from the trie
+         * once it is complete.
+         */
+        if (!frequencyPrefix && !frequencyAll) {
+            heapInsert(heap, node, buffer,
+                       counterValue(&trie->wide, node->frequency));
+        }
 
     }
 
@@ -87,6 +958,15 @@ count(FILE* ifp,
         free(buffer);
     }
 
+    /* Insert the words left over from the last batch. */
+    if (pending) {
+        int status = countBatchInsert(trie, heap, pending, offset, batched);
+        assert(status != -1);
+        arenaFree(pending);
+    }
+
+    traceSpan("insert", span);
+
     int status = 0;
 
     /* End of input reached, report success. */
@@ -98,17 +978,456 @@ count(FILE* ifp,
         status = -1;
     }
 
+    if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu trie nodes of %zu bytes\n",
+                words, trie->nodes, trie->nodeSize);
+        if (hapax) {
+            fprintf(stderr, "wf: %" PRIu32 " words seen once in %zu bytes\n",
+                    hapax->count, hapax->size * sizeof(HapaxSlot)
+                                  + hapax->words->used);
+        }
+        if (relayout >= 0) {
+            fprintf(stderr, "wf: trie re-laid out after %" PRIu64
+                    " words in %.1f ms\n", countRelayoutAfter, relayout);
+        }
+    }
+
+    /* Rank every word straight from the trie. */
+    if (status == 0 && frequencyAll) {
+        uint64_t start = traceStart();
+        status = countRank(trie, NULL, NULL, hapax, ofp);
+        traceSpan("rank", start);
+    }
+
+    /*
+     * The words seen once rank below every word of the trie, they only
+     * fill up the top words left over.
+     */
+    else if (status == 0 && hapax) {
+
+        if (frequencyPrefix) {
+            status = trieTop(trie, frequencyPrefix, frequencyCount,
+                             countOffer, heap);
+        }
+
+        if (status == 0) {
+            status = hapaxWalk(hapax, false, countOffer, heap);
+        }
+
+        if (status == 0) {
+            heapSort(heap);
+            heapDump(heap, ofp);
+        }
+
+    }
+
+    /* Report the top words with the prefix straight from the trie. */
+    else if (status == 0 && frequencyPrefix) {
+        status = trieTop(trie, frequencyPrefix, frequencyCount,
+                         countDump, ofp);
+    }
+
     /* Only sort and display if the input stream ended cleanly. */
-    if (status == 0) {
+    else if (status == 0) {
 
         /* Sort the heap. */
+        uint64_t start = traceStart();
         heapSort(heap);
+        traceSpan("heapSort", start);
 
         /* Display the frequency of the top word counts. */
+        start = traceStart();
+        heapDump(heap, ofp);
+        traceSpan("heapDump", start);
+
+    }
+
+    return (status);
+
+}
+
+/**
+ * @brief   display every word with its frequency in ranked order
+ * @param   trie the trie holding the counted words
+ * @param   radix the radix tree holding the counted words, NULL to use the
+ *          trie
+ * @param   spill the runs holding the counted words, NULL to use the trie
+ *          or the radix tree
+ * @param   hapax the words seen once which the trie does not hold, NULL
+ *          for none
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countRank(Trie* trie,
+          Radix* radix,
+          Spill* spill,
+          Hapax* hapax,
+          FILE* ofp)
+{
+
+    Rank* rank = rankNew();
+    assert(rank);
+
+    int status;
+
+    if (spill) {
+        status = spillMerge(spill, countRankAdd, rank);
+    }
+    else if (radix) {
+        status = radixWalk(radix, countRankAdd, rank);
+    }
+    else {
+        status = trieWalk(trie, countRankAdd, rank);
+    }
+
+    if (status == 0 && hapax) {
+        status = hapaxWalk(hapax, true, countRankAdd, rank);
+    }
+
+    /* The ranking bypasses the stream, write out anything before it. */
+    if (status == 0 && fflush(ofp) == 0) {
+        status = rankDump(rank, fileno(ofp));
+    }
+
+    rankFree(rank);
+
+    return (status);
+
+}
+
+/**
+ * @brief   add a word with its final count to the full ranking
+ * @param   argument the rank object
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+countRankAdd(void* argument,
+             const char* word,
+             uint64_t frequency)
+{
+
+    /* Only words with the prefix are displayed. */
+    if (frequencyPrefix
+        && strncmp(word, frequencyPrefix, strlen(frequencyPrefix)) != 0) {
+        return (0);
+    }
+
+    return (rankAdd(argument, word, frequency));
+
+}
+
+/**
+ * @brief   process a stream of words keeping the trie within the budget
+ * @details when the trie reaches the memory budget its words are spilled
+ *          to disk as a sorted run and the trie starts over;  At the end
+ *          the runs are merged and each word is offered to the heap with
+ *          its total count, so the result is exact.  The radix tree engine
+ *          counts here as well, with or without a budget
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countSpill(FILE* ifp,
+           FILE* ofp)
+{
+
+    Heap* heap = heapNew(frequencyCount);
+    Trie* trie = NULL;
+    Radix* radix = NULL;
+    Spill* spill = NULL;
+
+    if (countEngine == COUNT_RADIX) {
+        radix = radixNew();
+        assert(radix);
+    }
+    else {
+        trie = countTrieNew();
+        assert(trie);
+    }
+
+    assert(heap);
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    uint64_t words = 0;
+    int status = 0;
+
+    while (status == 0 && getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        /* Eat the newline. */
+        buffer[strlen(buffer)-1] = '\0';
+        words++;
+
+        size_t size;
+
+        if (radix) {
+            status = radixInsert(radix, buffer);
+            assert(status != -1);
+            size = radix->nodes * radix->nodeSize + radix->labels->used;
+        }
+        else {
+            TrieNode* node = trieInsert(trie, buffer);
+            assert(node);
+            size = trie->nodes * trie->nodeSize;
+        }
+
+        if (spillBudget == 0 || size < spillBudget) {
+            continue;
+        }
+
+        /* The temporary directory is only created once it is needed. */
+        if (!spill) {
+            spill = spillNew();
+            if (!spill) {
+                fprintf(stderr, "wf: cannot create spill file: %s\n",
+                        strerror(errno));
+                status = -1;
+                break;
+            }
+        }
+
+        status = countSpillWrite(spill, trie, radix);
+
+    }
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        status = -1;
+    }
+
+    if (countStats && radix) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu radix nodes of %zu bytes,"
+                " %zu label bytes\n", words, radix->nodes, radix->nodeSize,
+                radix->labels->used);
+    }
+    else if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu trie nodes of %zu bytes\n",
+                words, trie->nodes, trie->nodeSize);
+    }
+
+    /* The words still in memory join the runs. */
+    if (status == 0 && spill) {
+        status = countSpillWrite(spill, trie, radix);
+    }
+
+    /* Rank every word, or offer each word to the heap. */
+    if (status == 0 && frequencyAll) {
+        status = countRank(trie, radix, spill, NULL, ofp);
+    }
+    else if (status == 0 && spill) {
+        status = spillMerge(spill, countOffer, heap);
+    }
+    else if (status == 0 && radix) {
+        status = radixWalk(radix, countOffer, heap);
+    }
+    else if (status == 0) {
+        status = trieWalk(trie, countOffer, heap);
+    }
+
+    if (spill && spillFree(spill) == -1) {
+        status = -1;
+    }
+
+    if (status == -1) {
+        fprintf(stderr, "wf: spilling to disk failed: %s\n", strerror(errno));
+    }
+
+    /* Only sort and display if every word was counted. */
+    else if (!frequencyAll) {
+        heapSort(heap);
         heapDump(heap, ofp);
+    }
+
+    if (radix) {
+        radixFree(radix);
+    }
+    else {
+        trieFree(trie);
+    }
+
+    heapFree(heap);
+
+    return (status);
+
+}
+
+/**
+ * @brief   spill the words in memory as a sorted run and start over
+ * @param   spill the spill object
+ * @param   trie the trie holding the counted words, NULL if unused
+ * @param   radix the radix tree holding the counted words, NULL if unused
+ * @return  0 - success, -1 - failure
+ */
+static int
+countSpillWrite(Spill* spill,
+                Trie* trie,
+                Radix* radix)
+{
+
+    int status;
+
+    if (radix) {
+        status = spillWriteRadix(spill, radix);
+        radixReset(radix);
+    }
+    else {
+        status = spillWrite(spill, trie);
+        trieReset(trie);
+    }
+
+    return (status);
+
+}
+
+/**
+ * @brief   process a stream of words counting each word by its stem
+ * @details the surface words are counted, then stemmed once each into a
+ *          trie of the stems which is ranked like the words would be
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countStem(FILE* ifp,
+          FILE* ofp)
+{
+
+    Trie* trie = countTrieNew();
+    assert(trie);
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
+    uint64_t words = 0;
+
+    while (getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        /* Eat the newline. */
+        buffer[strlen(buffer)-1] = '\0';
+        words++;
+
+        TrieNode* node = trieInsert(trie, buffer);
+        assert(node);
+
+    }
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        trieFree(trie);
+        return (-1);
+    }
+
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Trie* stems = stemTrie(trie);
+    assert(stems);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " words, %zu trie nodes of %zu bytes,"
+                " %zu stem trie nodes built in %.1f ms\n", words,
+                trie->nodes, trie->nodeSize, stems->nodes,
+                (end.tv_sec - start.tv_sec) * 1e3
+                + (end.tv_nsec - start.tv_nsec) / 1e6);
+    }
+
+    int status;
+
+    /* Rank every stem, or report the top stems straight from the trie. */
+    if (frequencyAll) {
+        status = countRank(stems, NULL, NULL, NULL, ofp);
+    }
+    else {
+        status = trieTop(stems, frequencyPrefix ? frequencyPrefix : "",
+                         frequencyCount, countDump, ofp);
+    }
+
+    trieFree(stems);
+    trieFree(trie);
+
+    return (status);
+
+}
+
+/**
+ * @brief   allocate a trie for the words of the command line
+ * @details the trie counts the letters of the alphabet selected, and takes
+ *          its nodes from huge pages when asked to
+ * @param   none
+ * @return  a pointer to the new trie, NULL if memory could not be allocated
+ */
+Trie*
+countTrieNew(void)
+{
+
+    return (countHugePages ? trieNewPooled(&alphabet, true)
+                           : trieNew(&alphabet));
+
+}
+
+/**
+ * @brief   process a stream of words counting only the most recent words
+ * @details a timed window also reports its words at the end of each
+ *          interval, separated by an empty line
+ * @param   ifp the input stream containing newline delimited valid words
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+countWindow(FILE* ifp,
+            FILE* ofp)
+{
+
+    Window* window = windowNew(&windowSpan, frequencyCount,
+                               windowSpan.time ? ofp : NULL);
+    assert(window);
+
+    char* buffer = NULL;
+    size_t buffer_size = 0;
 
+    while (getdelim(&buffer, &buffer_size, '\n', ifp) != -1) {
+
+        /* Eat the newline. */
+        buffer[strlen(buffer)-1] = '\0';
+
+        int status = windowInsert(window, buffer);
+        assert(status != -1);
+
+    }
+
+    /* Free the buffer allocated by getdelim(). */
+    if (buffer) {
+        free(buffer);
+    }
+
+    /* An input error occurred, report failure. */
+    if (ferror(ifp)) {
+        windowFree(window);
+        return (-1);
     }
 
+    /* Display the words of the window as of the end of the input. */
+    int status = windowDump(window, ofp);
+
+    windowFree(window);
+
     return (status);
 
 }
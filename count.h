@@ -44,6 +44,67 @@
 
 #pragma once 
 
+#include <trie.h>
+
+enum {
+    COUNT_AUTO_NODES = 3,                   /** trie nodes per distinct word
+                                                moving to the radix tree */
+    COUNT_AUTO_REPEAT = 16,                 /** words per new word ending
+                                                the streamed heap */
+    COUNT_PROBE_BYTES = 1 << 20,            /** letters counted before the
+                                                first profile */
+    COUNT_PROBE_NODES = 1 << 16,            /** trie nodes allocated before
+                                                the first profile */
+    COUNT_RELAYOUT_AFTER = 1000000,         /** default re-layout point */
+};
+
+/**
+ * @brief   the structure counting the words
+ */
+typedef enum {
+    COUNT_TRIE = 0,     /** one node per letter */
+    COUNT_RADIX,        /** path-compressed, one node per branch */
+    COUNT_AUTO,         /** chosen from a profile of the input */
+    COUNT_PACKED,       /** short words by packed key, long ones by trie */
+} CountEngine;
+
+/**
+ * @brief   the number of words inserted into the trie together, 1 for one
+ *          at a time - Global
+ */
+extern uint32_t countBatch;
+
+/**
+ * @brief   the counting structure selected on the command line - Global
+ */
+extern CountEngine countEngine;
+
+/**
+ * @brief   keep the words seen once out of the trie - Global
+ */
+extern bool countHapax;
+
+/**
+ * @brief   the number of words after which the trie is re-laid out, 0 for
+ *          never - Global
+ */
+extern uint64_t countRelayoutAfter;
+
+/**
+ * @brief   the order of the trie nodes after the re-layout - Global
+ */
+extern TrieOrder countRelayoutOrder;
+
+/**
+ * @brief   take the trie nodes from huge pages - Global
+ */
+extern bool countHugePages;
+
+/**
+ * @brief   report the counting statistics on standard error - Global
+ */
+extern bool countStats;
+
 /**
  * @brief   function prototype
  */
@@ -51,6 +112,26 @@ int
 count(FILE* ifp,
       FILE* ofp);
 
+/**
+ * @brief   function prototype
+ */
+int
+countEngineParse(const char* name,
+                 CountEngine* engine);
+
+/**
+ * @brief   function prototype
+ */
+int
+countOrderParse(const char* name,
+                TrieOrder* order);
+
+/**
+ * @brief   function prototype
+ */
+Trie*
+countTrieNew(void);
+
 /*
  * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
  */
@@ -0,0 +1,173 @@
+/**
+ * @file counter.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the width-adaptive counter object
+ *
+ * Promotion is the slow path, taken once per count which passes 2^31;  A
+ * count stays promoted until the side table is reset, unless it is brought
+ * back to zero, which is always held inline.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <counter.h>
+
+/**
+ * @brief   add to a count, promoting it to the side table when it no
+ *          longer fits inline
+ * @param   counter the side table
+ * @param   slot the inline count
+ * @param   delta the amount to be added
+ * @return  0 - success, -1 - failure, the side table could not grow and the
+ *          count is unchanged
+ */
+int
+counterAdd(Counter* counter,
+           uint32_t* slot,
+           uint64_t delta)
+{
+
+    if (*slot >= COUNTER_WIDE) {
+        counter->vector[*slot - COUNTER_WIDE] += delta;
+        return (0);
+    }
+
+    if (*slot + delta < COUNTER_WIDE) {
+        *slot += delta;
+        return (0);
+    }
+
+    /* The side table is indexed by the inline values above the flag. */
+    if (counter->count > UINT32_MAX - COUNTER_WIDE) {
+        errno = EOVERFLOW;
+        return (-1);
+    }
+
+    if (counter->count == counter->size) {
+
+        uint32_t size = counter->size ? 2 * counter->size : 64;
+        uint64_t* vector = realloc(counter->vector, size * sizeof(*vector));
+
+        if (!vector) {
+            return (-1);
+        }
+
+        counter->vector = vector;
+        counter->size = size;
+
+    }
+
+    counter->vector[counter->count] = *slot + delta;
+    *slot = COUNTER_WIDE + counter->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   release the side table of a counter object
+ * @param   counter the side table, which is embedded in its owner
+ * @return  0 - success, -1 - failure
+ */
+int
+counterFree(Counter* counter)
+{
+
+    free(counter->vector);
+
+    counter->vector = NULL;
+    counter->count = 0;
+    counter->size = 0;
+
+    return (0);
+
+}
+
+/**
+ * @brief   discard every promoted count, keeping the side table storage
+ * @details the owner must have reset its inline counts first
+ * @param   counter the side table
+ * @return  0 - success, -1 - failure
+ */
+int
+counterReset(Counter* counter)
+{
+
+    counter->count = 0;
+
+    return (0);
+
+}
+
+/**
+ * @brief   subtract from an inline count or its promoted count
+ * @param   counter the side table
+ * @param   slot the inline count
+ * @param   delta the amount to be subtracted, at most the count
+ * @return  0 - success, -1 - failure
+ */
+int
+counterSubtract(Counter* counter,
+                uint32_t* slot,
+                uint64_t delta)
+{
+
+    if (*slot >= COUNTER_WIDE) {
+
+        counter->vector[*slot - COUNTER_WIDE] -= delta;
+
+        /* A count of zero is always inline, owners test it directly. */
+        if (counter->vector[*slot - COUNTER_WIDE] == 0) {
+            *slot = 0;
+        }
+
+    }
+    else {
+        *slot -= delta;
+    }
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,140 @@
+/**
+ * @file counter.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the width-adaptive counter object
+ *
+ * A count is held in 32 bits inline in its owner until it reaches
+ * COUNTER_WIDE;  It is then promoted to a 64 bit slot of a side table and
+ * the inline value becomes the flagged index of that slot.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+enum {
+    COUNTER_WIDE = 0x80000000u,             /** flag of a promoted count */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Counter Counter;
+
+/**
+ * @brief   object representing the side table of promoted counts
+ */
+struct Counter {
+    uint64_t* vector;   /** dynamically allocated vector of promoted counts */
+    uint32_t count;     /** number of promoted counts */
+    uint32_t size;      /** allocated size of the vector */
+};
+
+/**
+ * @brief   function prototype
+ */
+int
+counterAdd(Counter* counter,
+           uint32_t* slot,
+           uint64_t delta);
+
+/**
+ * @brief   function prototype
+ */
+int
+counterFree(Counter* counter);
+
+/**
+ * @brief   add one to an inline count or its promoted count
+ * @details the common case is a single compare and increment, promotion
+ *          and promoted counts are left to counterAdd()
+ * @param   counter the side table
+ * @param   slot the inline count
+ * @return  0 - success, -1 - failure, the side table could not grow
+ */
+static inline int
+counterIncrement(Counter* counter,
+                 uint32_t* slot)
+{
+
+    if (__builtin_expect(*slot < COUNTER_WIDE - 1, 1)) {
+        (*slot)++;
+        return (0);
+    }
+
+    return (counterAdd(counter, slot, 1));
+
+}
+
+/**
+ * @brief   function prototype
+ */
+int
+counterReset(Counter* counter);
+
+/**
+ * @brief   function prototype
+ */
+int
+counterSubtract(Counter* counter,
+                uint32_t* slot,
+                uint64_t delta);
+
+/**
+ * @brief   get the value of an inline count or its promoted count
+ * @param   counter the side table
+ * @param   slot the inline count
+ * @return  the count
+ */
+static inline uint64_t
+counterValue(const Counter* counter,
+             uint32_t slot)
+{
+
+    if (__builtin_expect(slot < COUNTER_WIDE, 1)) {
+        return (slot);
+    }
+
+    return (counter->vector[slot - COUNTER_WIDE]);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
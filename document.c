@@ -0,0 +1,359 @@
+/**
+ * @file document.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the document frequency object
+ *
+ * Each word is counted at most once per document:  Its trie node remembers
+ * the last document it was seen in, so the document frequency costs no
+ * memory per occurrence.  Every word also gets a term number on its first
+ * sighting, indexing its total occurrences over all documents.  A document
+ * only lists the terms it has seen with their totals before it started, so
+ * its term counts are the difference and are written out as it ends
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <arena.h>
+#include <count.h>
+#include <counter.h>
+#include <document.h>
+#include <heap.h>
+#include <trie.h>
+
+/**
+ * @brief   the ranking across documents selected on the command line - Global
+ */
+DocumentRank documentRank = DOCUMENT_NONE;
+
+/**
+ * @brief   the names of the documents, in input order - Global
+ */
+char** documentNames = NULL;
+
+/**
+ * @brief   the number of document names, 0 for standard input - Global
+ */
+uint32_t documentNameCount = 0;
+
+/**
+ * @brief   the file receiving the term counts of each document, NULL for
+ *          none - Global
+ */
+const char* documentTerms = NULL;
+
+/*
+ * function prototypes
+ */
+static int
+documentTermNew(Document* document,
+                TrieNode* node,
+                const char* word);
+
+/**
+ * @brief   finish the current document and write out its term counts
+ * @details the term counts are written as one line per document, the name
+ *          of the document followed by a tab and the space separated
+ *          "word:count" of each term in order of first appearance
+ * @param   document the document object
+ * @return  0 - success, -1 - failure
+ */
+int
+documentEnd(Document* document)
+{
+
+    /* The last stamp is the one carried by nodes never stamped. */
+    if (document->current == UINT32_MAX - 1) {
+        errno = EOVERFLOW;
+        return (-1);
+    }
+
+    if (document->stream) {
+
+        const char* name = (document->current < documentNameCount)
+                           ? documentNames[document->current] : "-";
+
+        fprintf(document->stream, "%s\t", name);
+
+        for (uint32_t i = 0; i < document->seenCount; i++) {
+
+            uint32_t term = document->seen[i].term;
+
+            fprintf(document->stream, "%s%s:%" PRIu64, (i != 0) ? " " : "",
+                    document->words->base + document->word[term],
+                    document->total[term] - document->seen[i].base);
+
+        }
+
+        fputc('\n', document->stream);
+
+    }
+
+    document->seenCount = 0;
+    document->current++;
+
+    if (document->stream && ferror(document->stream)) {
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a document object and everything it counted
+ * @param   document the document object to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+documentFree(Document* document)
+{
+
+    if (document->trie) {
+        trieFree(document->trie);
+    }
+
+    if (document->words) {
+        arenaFree(document->words);
+    }
+
+    free(document->total);
+    free(document->word);
+    free(document->seen);
+    free(document);
+
+    return (0);
+
+}
+
+/**
+ * @brief   count a word of the current document
+ * @param   document the document object
+ * @param   word the word
+ * @return  0 - success, -1 - failure
+ */
+int
+documentInsert(Document* document,
+               const char* word)
+{
+
+    bool counted;
+    TrieNode* node = trieInsertOnce(document->trie, word, document->current,
+                                    &counted);
+
+    if (!node) {
+        return (-1);
+    }
+
+    if (node->term == 0 && documentTermNew(document, node, word) == -1) {
+        return (-1);
+    }
+
+    /* The first sighting within the document remembers the total so far. */
+    if (counted) {
+
+        if (document->seenCount == document->seenSize) {
+
+            uint32_t size = document->seenSize ? 2 * document->seenSize : 1024;
+            DocumentTerm* seen = realloc(document->seen, size * sizeof(*seen));
+
+            if (!seen) {
+                return (-1);
+            }
+
+            document->seen = seen;
+            document->seenSize = size;
+
+        }
+
+        document->seen[document->seenCount++] = (DocumentTerm) {
+            .term = node->term,
+            .base = document->total[node->term],
+        };
+
+    }
+
+    document->total[node->term]++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   allocate a new, empty document object
+ * @param   stream the stream for the term counts of each document, NULL for
+ *          none
+ * @return  a pointer to the newly allocated document object, NULL if memory
+ *          could not be allocated
+ */
+Document*
+documentNew(FILE* stream)
+{
+
+    Document* document = calloc(1, sizeof(*document));
+
+    if (!document) {
+        return (NULL);
+    }
+
+    document->terms = 1;
+    document->stream = stream;
+    document->trie = countTrieNew();
+    document->words = arenaNew(4096);
+
+    if (!document->trie || !document->words) {
+        documentFree(document);
+        return (NULL);
+    }
+
+    return (document);
+
+}
+
+/**
+ * @brief   rank the words by their occurrences weighted by their rarity
+ * @details the score of a word is its total occurrences multiplied by the
+ *          natural logarithm of the number of documents over the number of
+ *          documents containing it;  The scores are kept in thousandths
+ *          within the heap and displayed with three decimals
+ * @param   document the document object, every document has ended
+ * @param   heap the heap collecting the top words
+ * @param   ofp the output stream for the score and word display
+ * @return  0 - success, -1 - failure
+ */
+int
+documentScore(Document* document,
+              Heap* heap,
+              FILE* ofp)
+{
+
+    double documents = document->current;
+
+    for (uint32_t term = 1; term < document->terms; term++) {
+
+        const char* word = document->words->base + document->word[term];
+
+        /* Only words with the prefix are displayed. */
+        if (frequencyPrefix
+            && strncmp(word, frequencyPrefix, strlen(frequencyPrefix)) != 0) {
+            continue;
+        }
+
+        TrieNode* node = trieFind(document->trie, word);
+        double frequency = counterValue(&document->trie->wide,
+                                        node->frequency);
+        double score = document->total[term] * log(documents / frequency);
+
+        if (heapOffer(heap, word, llround(score * 1000)) == -1) {
+            return (-1);
+        }
+
+    }
+
+    heapSort(heap);
+
+    for (uint32_t i = 0; i < heap->count; i++) {
+        fprintf(ofp, "%.3f %s\n", heap->vector[i].frequency / 1000.0,
+                heap->words->base + heap->vector[i].word);
+    }
+
+    return (ferror(ofp) ? -1 : 0);
+
+}
+
+/**
+ * @brief   give a word seen for the first time its term number
+ * @param   document the document object
+ * @param   node the trie node of the word
+ * @param   word the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+documentTermNew(Document* document,
+                TrieNode* node,
+                const char* word)
+{
+
+    if (document->terms == UINT32_MAX) {
+        errno = EOVERFLOW;
+        return (-1);
+    }
+
+    if (document->terms >= document->size) {
+
+        uint32_t size = document->size ? 2 * document->size : 4096;
+        uint64_t* total = realloc(document->total, size * sizeof(*total));
+
+        if (!total) {
+            return (-1);
+        }
+
+        document->total = total;
+
+        uint32_t* offset = realloc(document->word, size * sizeof(*offset));
+
+        if (!offset) {
+            return (-1);
+        }
+
+        document->word = offset;
+        document->size = size;
+
+    }
+
+    uint32_t term = document->terms;
+
+    document->word[term] = arenaAppend(document->words, word, strlen(word));
+
+    if (document->word[term] == 0) {
+        return (-1);
+    }
+
+    document->total[term] = 0;
+    document->terms++;
+    node->term = term;
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
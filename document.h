@@ -0,0 +1,147 @@
+/**
+ * @file document.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the document frequency object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+#include <heap.h>
+#include <trie.h>
+
+/*
+ * forward declarations
+ */
+typedef struct Document Document;
+typedef struct DocumentTerm DocumentTerm;
+
+/**
+ * @brief   the ranking of the words across documents
+ */
+typedef enum {
+    DOCUMENT_NONE = 0,      /** the input is one stream of words */
+    DOCUMENT_FREQUENCY,     /** the number of documents containing the word */
+    DOCUMENT_TFIDF,         /** the occurrences weighted by the rarity */
+} DocumentRank;
+
+/**
+ * @brief   object representing a term seen within the current document
+ */
+struct DocumentTerm {
+    uint32_t term;          /** term number of the word */
+    uint64_t base;          /** total of the term before the document */
+};
+
+/**
+ * @brief   object representing word frequencies across documents
+ */
+struct Document {
+    Trie* trie;             /** number of documents containing each word */
+    uint32_t current;       /** number of the document being counted */
+    uint64_t* total;        /** occurrences of each term in every document */
+    uint32_t* word;         /** offset of each term's word in the arena */
+    uint32_t terms;         /** number of terms, term 0 is unused */
+    uint32_t size;          /** allocated size of the term vectors */
+    Arena* words;           /** text of the terms */
+    DocumentTerm* seen;     /** terms seen within the current document */
+    uint32_t seenCount;     /** number of terms seen */
+    uint32_t seenSize;      /** allocated size of the seen vector */
+    FILE* stream;           /** stream for the term counts, NULL if none */
+};
+
+/**
+ * @brief   the ranking across documents selected on the command line - Global
+ */
+extern DocumentRank documentRank;
+
+/**
+ * @brief   the names of the documents, in input order - Global
+ */
+extern char** documentNames;
+
+/**
+ * @brief   the number of document names, 0 for standard input - Global
+ */
+extern uint32_t documentNameCount;
+
+/**
+ * @brief   the file receiving the term counts of each document, NULL for
+ *          none - Global
+ */
+extern const char* documentTerms;
+
+/**
+ * @brief   function prototype
+ */
+int
+documentEnd(Document* document);
+
+/**
+ * @brief   function prototype
+ */
+int
+documentFree(Document* document);
+
+/**
+ * @brief   function prototype
+ */
+int
+documentInsert(Document* document,
+               const char* word);
+
+/**
+ * @brief   function prototype
+ */
+Document*
+documentNew(FILE* stream);
+
+/**
+ * @brief   function prototype
+ */
+int
+documentScore(Document* document,
+              Heap* heap,
+              FILE* ofp);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,340 @@
+/**
+ * @file hapax.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the hapax (seen once) word set object
+ *
+ * About half of the distinct words of a text occur only once, and each of
+ * them would cost the trie a chain of nodes of its own.  The first sighting
+ * of a word is instead kept in a compact hash set holding just the text of
+ * the word;  The second sighting takes the word out of the set so it can be
+ * counted by the trie from then on.  The set is exact, so every count stays
+ * exact
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <arena.h>
+#include <hapax.h>
+#include <trie.h>
+
+/*
+ * function prototypes
+ */
+static int
+hapaxCompare(const void* a,
+             const void* b);
+
+static uint32_t
+hapaxHash(const char* word,
+          size_t length);
+
+static int
+hapaxRebuild(Hapax* hapax);
+
+/**
+ * @brief   compare two words for sorting in byte order
+ * @param   a pointer to the first word
+ * @param   b pointer to the second word
+ * @return  less than, equal to or greater than zero as the first word
+ *          sorts before, with or after the second
+ */
+static int
+hapaxCompare(const void* a,
+             const void* b)
+{
+
+    return (strcmp(*(const char* const*) a, *(const char* const*) b));
+
+}
+
+/**
+ * @brief   release a hapax set object and the words it holds
+ * @param   hapax the hapax set to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+hapaxFree(Hapax* hapax)
+{
+
+    if (hapax->words) {
+        arenaFree(hapax->words);
+    }
+
+    free(hapax->slot);
+    free(hapax);
+
+    return (0);
+
+}
+
+/**
+ * @brief   compute the hash of a word (FNV-1a)
+ * @param   word the word
+ * @param   length the length of the word
+ * @return  the hash
+ */
+static uint32_t
+hapaxHash(const char* word,
+          size_t length)
+{
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) word[i];
+        hash *= 16777619u;
+    }
+
+    return (hash);
+
+}
+
+/**
+ * @brief   record a sighting of a word which the trie does not count
+ * @details a word seen for the first time is added to the set;  A word
+ *          seen before is taken out of the set, its slot is marked so the
+ *          probes of the other words still pass it
+ * @param   hapax the hapax set
+ * @param   word the word
+ * @return  0 - first sighting, the word was added, 1 - second sighting,
+ *          the word was taken out, -1 - failure
+ */
+int
+hapaxInsert(Hapax* hapax,
+            const char* word)
+{
+
+    /* Keep at least half of the slots empty so that probes stay short. */
+    if (2 * (hapax->used + 1) > hapax->size && hapaxRebuild(hapax) == -1) {
+        return (-1);
+    }
+
+    size_t length = strlen(word);
+    uint32_t hash = hapaxHash(word, length);
+    uint32_t i = hash & (hapax->size - 1);
+
+    for (;; i = (i + 1) & (hapax->size - 1)) {
+
+        HapaxSlot* slot = &hapax->slot[i];
+
+        if (slot->word == 0) {
+            break;
+        }
+
+        if (slot->word != HAPAX_PROMOTED && slot->hash == hash
+            && strcmp(hapax->words->base + slot->word, word) == 0) {
+            slot->word = HAPAX_PROMOTED;
+            hapax->count--;
+            return (1);
+        }
+
+    }
+
+    uint32_t offset = arenaAppend(hapax->words, word, length);
+
+    if (offset == 0) {
+        return (-1);
+    }
+
+    hapax->slot[i] = (HapaxSlot) { .hash = hash, .word = offset };
+    hapax->used++;
+    hapax->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   allocate a new, empty hapax set object
+ * @param   none
+ * @return  a pointer to the newly allocated hapax set object, NULL if
+ *          memory could not be allocated
+ */
+Hapax*
+hapaxNew(void)
+{
+
+    Hapax* hapax = calloc(1, sizeof(*hapax));
+
+    if (!hapax) {
+        return (NULL);
+    }
+
+    hapax->size = 4096;
+    hapax->slot = calloc(hapax->size, sizeof(*hapax->slot));
+    hapax->words = arenaNew(65536);
+
+    if (!hapax->slot || !hapax->words) {
+        hapaxFree(hapax);
+        return (NULL);
+    }
+
+    return (hapax);
+
+}
+
+/**
+ * @brief   rebuild the hash table without the promoted words, doubling it
+ *          unless they took up most of it
+ * @details the text of the words still in the set is copied into a new
+ *          arena, so the text of the promoted words is released as well
+ * @param   hapax the hapax set
+ * @return  0 - success, -1 - failure
+ */
+static int
+hapaxRebuild(Hapax* hapax)
+{
+
+    /* Mostly promoted words are only dropped, the size is kept. */
+    uint32_t size = (4 * hapax->count > hapax->size) ? 2 * hapax->size
+                                                     : hapax->size;
+    HapaxSlot* slot = calloc(size, sizeof(*slot));
+    Arena* words = arenaNew(hapax->words->used);
+
+    if (!slot || !words) {
+        free(slot);
+        if (words) {
+            arenaFree(words);
+        }
+        return (-1);
+    }
+
+    for (uint32_t i = 0; i < hapax->size; i++) {
+
+        HapaxSlot* from = &hapax->slot[i];
+
+        if (from->word == 0 || from->word == HAPAX_PROMOTED) {
+            continue;
+        }
+
+        uint32_t j = from->hash & (size - 1);
+
+        while (slot[j].word != 0) {
+            j = (j + 1) & (size - 1);
+        }
+
+        const char* word = hapax->words->base + from->word;
+
+        slot[j].hash = from->hash;
+        slot[j].word = arenaAppend(words, word, strlen(word));
+
+        assert(slot[j].word != 0);
+
+    }
+
+    free(hapax->slot);
+    arenaFree(hapax->words);
+
+    hapax->slot = slot;
+    hapax->words = words;
+    hapax->size = size;
+    hapax->used = hapax->count;
+
+    return (0);
+
+}
+
+/**
+ * @brief   report every word seen exactly once
+ * @param   hapax the hapax set
+ * @param   sorted true - report the words in byte order, as walking a trie
+ *          does, false - in no particular order
+ * @param   func the function called with each word and a frequency of one
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+int
+hapaxWalk(Hapax* hapax,
+          bool sorted,
+          TrieTopFunc* func,
+          void* argument)
+{
+
+    const char** words = NULL;
+    uint32_t count = 0;
+
+    if (sorted) {
+        words = malloc((hapax->count ? hapax->count : 1) * sizeof(*words));
+        if (!words) {
+            return (-1);
+        }
+    }
+
+    for (uint32_t i = 0; i < hapax->size; i++) {
+
+        HapaxSlot* slot = &hapax->slot[i];
+
+        if (slot->word == 0 || slot->word == HAPAX_PROMOTED) {
+            continue;
+        }
+
+        const char* word = hapax->words->base + slot->word;
+
+        if (sorted) {
+            words[count++] = word;
+        }
+        else if (func(argument, word, 1) == -1) {
+            return (-1);
+        }
+
+    }
+
+    int status = 0;
+
+    if (sorted) {
+
+        qsort(words, count, sizeof(*words), hapaxCompare);
+
+        for (uint32_t i = 0; i < count && status == 0; i++) {
+            status = func(argument, words[i], 1);
+        }
+
+        free(words);
+
+    }
+
+    return (status);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
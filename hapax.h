@@ -0,0 +1,110 @@
+/**
+ * @file hapax.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the hapax (seen once) word set object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+#include <trie.h>
+
+enum {
+    HAPAX_PROMOTED = UINT32_MAX,            /** word left the set */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Hapax Hapax;
+typedef struct HapaxSlot HapaxSlot;
+
+/**
+ * @brief   object representing a slot of the hapax hash table
+ */
+struct HapaxSlot {
+    uint32_t hash;          /** hash of the word */
+    uint32_t word;          /** offset of the word in the arena, 0 if empty,
+                                HAPAX_PROMOTED once seen again */
+};
+
+/**
+ * @brief   object representing the words seen exactly once
+ */
+struct Hapax {
+    HapaxSlot* slot;        /** open addressed hash table of the words */
+    uint32_t size;          /** number of slots, a power of two */
+    uint32_t used;          /** slots holding a word or a promoted word */
+    uint32_t count;         /** words seen exactly once */
+    Arena* words;           /** text of the words */
+};
+
+/**
+ * @brief   function prototype
+ */
+int
+hapaxFree(Hapax* hapax);
+
+/**
+ * @brief   function prototype
+ */
+int
+hapaxInsert(Hapax* hapax,
+            const char* word);
+
+/**
+ * @brief   function prototype
+ */
+Hapax*
+hapaxNew(void);
+
+/**
+ * @brief   function prototype
+ */
+int
+hapaxWalk(Hapax* hapax,
+          bool sorted,
+          TrieTopFunc* func,
+          void* argument);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -49,6 +49,12 @@
 /*
  * function prototypes
  */
+static bool
+heapAbove(const Heap* heap,
+          uint64_t frequency,
+          uint64_t key,
+          const char* word);
+
 static int
 heapBuild(Heap* heap);
 
@@ -57,6 +63,51 @@ heapHeapify(Heap* heap,
             uint32_t index,
             uint32_t count);
 
+static uint64_t
+heapKey(const char* word);
+
+static bool
+heapLess(const Heap* heap,
+         const HeapNode* a,
+         const HeapNode* b);
+
+static int
+heapNodeSet(Heap* heap,
+            HeapNode* entry,
+            TrieNode* node,
+            const char* word,
+            uint64_t frequency,
+            uint64_t key);
+
+/**
+ * @brief   determine if a word ranks above the root of a full heap
+ * @param   heap the heap
+ * @param   frequency the frequency of the word
+ * @param   key the tie-break key of the word
+ * @param   word the word, which need not be interned in the heap
+ * @return  true - the word ranks above the root, false - otherwise
+ */
+static bool
+heapAbove(const Heap* heap,
+          uint64_t frequency,
+          uint64_t key,
+          const char* word)
+{
+
+    const HeapNode* root = &heap->vector[0];
+
+    if (frequency != root->frequency) {
+        return (frequency > root->frequency);
+    }
+
+    if (key != root->key) {
+        return (key > root->key);
+    }
+
+    return (strcmp(word, heap->words->base + root->word) > 0);
+
+}
+
 /**
  * @brief
  * @param   the heap to be built
@@ -96,9 +147,9 @@ heapDump(Heap* heap,
 
     for (uint32_t i = 0; i < heap->count; i++) {
 
-        fprintf(ofp, "%d %s\n",
+        fprintf(ofp, "%" PRIu64 " %s\n",
                 heap->vector[i].frequency,
-                heap->vector[i].word);
+                heap->words->base + heap->vector[i].word);
 
     }
 
@@ -123,31 +174,25 @@ heapHeapify(Heap* heap,
     uint32_t right = left + 1;
     uint32_t minimum = index;
 
-    if (left < count) {
-        if (heap->vector[left].frequency < heap->vector[minimum].frequency) {
-            minimum = left;
-        }
-        else if (heap->vector[left].frequency == heap->vector[minimum].frequency
-                 && strcmp(heap->vector[left].word, heap->vector[minimum].word) < 0) {
-            minimum = left;
-        }
+    if (left < count
+        && heapLess(heap, &heap->vector[left], &heap->vector[minimum])) {
+        minimum = left;
     }
 
-    if (right < count) {
-        if (heap->vector[right].frequency < heap->vector[minimum].frequency) {
-            minimum = right;
-        }
-        else if (heap->vector[right].frequency == heap->vector[minimum].frequency
-                 && strcmp(heap->vector[right].word, heap->vector[minimum].word) < 0) {
-            minimum = right;
-        }
+    if (right < count
+        && heapLess(heap, &heap->vector[right], &heap->vector[minimum])) {
+        minimum = right;
     }
 
     if (minimum != index) {
 
         /* Update the trie index into the heap. */
-        heap->vector[minimum].node->index = index;
-        heap->vector[index].node->index = minimum;
+        if (heap->vector[minimum].node) {
+            heap->vector[minimum].node->index = index;
+        }
+        if (heap->vector[index].node) {
+            heap->vector[index].node->index = minimum;
+        }
 
         /* Swap the nodes. */
         HeapNode node = heap->vector[minimum];
@@ -164,21 +209,26 @@ heapHeapify(Heap* heap,
 
 /**
  * @brief   insert a word into the trie and possibly the heap
+ * @details the word is copied into the heap word arena only the first time
+ *          its trie node enters the heap;  Nodes which churn in and out of
+ *          the heap afterwards reuse that copy so no memory is allocated
  * @param   heap the heap to have an item inserted
  * @param   node a pointer to the corresponding trie node
  * @param   word the word to be inserted into the heap
- * @return  0 - success, 1 - failure
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
  */
 int
 heapInsert(Heap* heap,
            TrieNode* node,
-           const char* word)
+           const char* word,
+           uint64_t frequency)
 {
 
-    /* The word is already present in the heap, increase its frequency. */
+    /* The word is already present in the heap, update its frequency. */
     if (node->index != -1) {
 
-        heap->vector[node->index].frequency++;
+        heap->vector[node->index].frequency = frequency;
 
         heapHeapify(heap, node->index, heap->count);
 
@@ -189,11 +239,12 @@ heapInsert(Heap* heap,
 
         uint32_t count = heap->count;
 
-        heap->vector[count].frequency = node->frequency;
-        heap->vector[count].word = strdup(word);
+        if (heapNodeSet(heap, &heap->vector[count], node, word, frequency,
+                        heapKey(word)) == -1) {
+            return (-1);
+        }
 
-        heap->vector[count].node = node;
-        node->index = heap->count;
+        node->index = count;
 
         heap->count++;
 
@@ -203,26 +254,30 @@ heapInsert(Heap* heap,
 
     /*
      * The word is not present in the heap and the heap is full.  Replace the
-     * root with the new node.
+     * root with the new node if the new node ranks above it.
      */
-    else if (
-             (node->frequency > heap->vector[0].frequency)
-             ||
-             ((node->frequency == heap->vector[0].frequency)
-              && (strcmp(word, heap->vector[0].word) > 0))
-            )
-    {
-
-        heap->vector[0].node->index = -1;
-        heap->vector[0].node = node;
-        heap->vector[0].node->index = 0;
-        heap->vector[0].frequency = node->frequency;
-
-        /* Delete word no longer in the top frequency count. */
-        free(heap->vector[0].word);
-        heap->vector[0].word = strdup(word);
+    else {
 
-        heapHeapify(heap, 0, heap->count);
+        uint64_t key = heapKey(word);
+
+        /* The word may not be interned yet, compare against the input. */
+        if (heapAbove(heap, frequency, key, word)) {
+
+            TrieNode* evicted = heap->vector[0].node;
+
+            if (heapNodeSet(heap, &heap->vector[0], node, word, frequency,
+                            key) == -1) {
+                return (-1);
+            }
+
+            if (evicted) {
+                evicted->index = -1;
+            }
+            node->index = 0;
+
+            heapHeapify(heap, 0, heap->count);
+
+        }
 
     }
 
@@ -230,10 +285,102 @@ heapInsert(Heap* heap,
 
 }
 
+/**
+ * @brief   compute the tie-break key of a word
+ * @details the key holds the first eight bytes of the word in big endian
+ *          order, padded with zero bytes, so comparing two keys orders the
+ *          words lexicographically unless their first eight bytes match
+ * @param   word the null terminated word
+ * @return  the tie-break key
+ */
+static uint64_t
+heapKey(const char* word)
+{
+
+    uint64_t key = 0;
+
+    for (uint32_t i = 0; i < sizeof(key); i++) {
+
+        key <<= 8;
+
+        if (*word != '\0') {
+            key |= (unsigned char)*word++;
+        }
+
+    }
+
+    return (key);
+
+}
+
+/**
+ * @brief   determine if one heap node ranks below another
+ * @param   heap the heap containing the nodes
+ * @param   a the first heap node
+ * @param   b the second heap node
+ * @return  true - a has a lower frequency, or the same frequency and a
+ *          lexicographically smaller word, false - otherwise
+ */
+static bool
+heapLess(const Heap* heap,
+         const HeapNode* a,
+         const HeapNode* b)
+{
+
+    if (a->frequency != b->frequency) {
+        return (a->frequency < b->frequency);
+    }
+
+    if (a->key != b->key) {
+        return (a->key < b->key);
+    }
+
+    /* Only words sharing their first eight bytes need a string compare. */
+    return (strcmp(heap->words->base + a->word,
+                   heap->words->base + b->word) < 0);
+
+}
+
+/**
+ * @brief   release a heap object
+ * @param   heap the heap to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+heapFree(Heap* heap)
+{
+
+    arenaFree(heap->words);
+    free(heap->vector);
+    free(heap);
+
+    return (0);
+
+}
+
+/**
+ * @brief   follow a trie node which moved to a new address
+ * @details called for each node in the heap when the trie is re-laid out
+ * @param   argument the heap
+ * @param   node the trie node at its new address
+ * @return  none
+ */
+void
+heapMove(void* argument,
+         TrieNode* node)
+{
+
+    Heap* heap = argument;
+
+    heap->vector[node->index].node = node;
+
+}
+
 /**
  * @brief   allocate a new heap object of a given size
  * @param   size the size of the heap
- * @return  a pointer to the newly allocated heap object
+ * @return  a pointer to the newly allocated heap object, NULL if memory
+ *          could not be allocated
  */
 Heap*
 heapNew(uint32_t size)
@@ -242,16 +389,128 @@ heapNew(uint32_t size)
     Heap* heap;
 
     heap = calloc(1, sizeof(*heap));
+    if (!heap) {
+        return (NULL);
+    }
 
     heap->size = size;
     heap->count = 0;
 
     heap->vector = calloc(heap->size, sizeof(*heap->vector));
+    heap->words = arenaNew(4096);
+
+    if (!heap->vector || !heap->words) {
+        free(heap->vector);
+        if (heap->words) {
+            arenaFree(heap->words);
+        }
+        free(heap);
+        return (NULL);
+    }
 
     return (heap);
 
 }
 
+/**
+ * @brief   fill a heap node from a trie node
+ * @param   heap the heap owning the word arena
+ * @param   entry the heap node to be filled
+ * @param   node the trie node entering the heap
+ * @param   word the word of the trie node
+ * @param   frequency the frequency of the word
+ * @param   key the tie-break key of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+heapNodeSet(Heap* heap,
+            HeapNode* entry,
+            TrieNode* node,
+            const char* word,
+            uint64_t frequency,
+            uint64_t key)
+{
+
+    /* Copy the word only the first time the trie node enters the heap. */
+    if (node->word == 0) {
+        node->word = arenaAppend(heap->words, word, strlen(word));
+        if (node->word == 0) {
+            return (-1);
+        }
+    }
+
+    entry->node = node;
+    entry->frequency = frequency;
+    entry->word = node->word;
+    entry->key = key;
+
+    return (0);
+
+}
+
+/**
+ * @brief   offer a counted word to the heap without a trie node
+ * @details used when the words are counted elsewhere, such as by merging
+ *          spilled runs;  Each word must be offered only once
+ * @param   heap the heap
+ * @param   word the word
+ * @param   frequency the final frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+int
+heapOffer(Heap* heap,
+          const char* word,
+          uint64_t frequency)
+{
+
+    uint64_t key = heapKey(word);
+    bool fill = (heap->count < heap->size);
+
+    /* Once the heap is full a word must outrank the root to enter. */
+    if (!fill && !heapAbove(heap, frequency, key, word)) {
+        return (0);
+    }
+
+    HeapNode* entry = fill ? &heap->vector[heap->count] : &heap->vector[0];
+
+    entry->node = NULL;
+    entry->frequency = frequency;
+    entry->word = arenaAppend(heap->words, word, strlen(word));
+    entry->key = key;
+
+    if (entry->word == 0) {
+        return (-1);
+    }
+
+    /* The heap is built once, when the last free slot is filled. */
+    if (fill) {
+        if (++heap->count == heap->size) {
+            heapBuild(heap);
+        }
+    }
+    else {
+        heapHeapify(heap, 0, heap->count);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   empty a heap in constant time so it can rank new words
+ * @param   heap the heap to be emptied
+ * @return  0 - success, -1 - failure
+ */
+int
+heapReset(Heap* heap)
+{
+
+    heap->count = 0;
+
+    return (arenaReset(heap->words));
+
+}
+
 /**
  * @brief   sort the given heap
  * @param   heap the heap to be sorted
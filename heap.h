@@ -42,6 +42,7 @@
  * ===========================================================================
  */
 
+#include <arena.h>
 #include <trie.h>
 
 #pragma once
@@ -59,6 +60,7 @@ struct Heap {
     uint32_t count;     /* number of nodes within the heap */
     uint32_t size;      /* maximum size of the heap */
     HeapNode* vector;   /* dynamically allocated vector of heap nodes */
+    Arena* words;       /* words of every trie node which entered the heap */
 };
 
 /**
@@ -66,8 +68,9 @@ struct Heap {
  */
 struct HeapNode {
     TrieNode* node;     /* pointer to associate trie and heap node */
-    uint32_t frequency; /* word frequency */
-    char* word;         /* dynamically allocatd null terminated word string */
+    uint64_t frequency; /* word frequency */
+    uint32_t word;      /* offset of the word within the heap word arena */
+    uint64_t key;       /* leading word bytes for integer tie-breaks */
 };
 
 /**
@@ -77,6 +80,19 @@ int
 heapDump(Heap* heap,
          FILE* ofp);
 
+/**
+ * @brief   function prototype
+ */
+int
+heapFree(Heap* heap);
+
+/**
+ * @brief   function prototype
+ */
+void
+heapMove(void* argument,
+         TrieNode* node);
+
 /**
  * @brief   function prototype
  */
@@ -89,7 +105,22 @@ heapNew(uint32_t size);
 int
 heapInsert(Heap* heap,
            TrieNode* node,
-           const char* word);
+           const char* word,
+           uint64_t frequency);
+
+/**
+ * @brief   function prototype
+ */
+int
+heapOffer(Heap* heap,
+          const char* word,
+          uint64_t frequency);
+
+/**
+ * @brief   function prototype
+ */
+int
+heapReset(Heap* heap);
 
 /**
  * @brief   function prototype
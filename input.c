@@ -0,0 +1,829 @@
+/**
+ * @file input.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the read-ahead input layer
+ *
+ * The input layer keeps several large reads in flight so that reading the
+ * input overlaps with tokenizing it;  When the kernel supports io_uring and the
+ * input is a regular file the reads are queued to the kernel directly,
+ * otherwise a read-ahead thread fills a small ring of buffers
+ *
+ * Buffers are handed to the consumer in file order by inputNext() and must be
+ * handed back, in the same order, by inputRelease() so they can be refilled
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <input.h>
+#include <trace.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#endif
+
+/**
+ * @brief   read-ahead buffer states
+ */
+enum {
+    INPUT_FREE = 0,     /** owned by the input layer, may be refilled */
+    INPUT_PENDING,      /** a read into the buffer is in progress */
+    INPUT_READY,        /** filled and waiting for the consumer */
+};
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+/**
+ * @brief   object for maintaining the shared io_uring submission and
+ *          completion rings
+ */
+typedef struct InputRing {
+    int fd;                         /** io_uring file descriptor */
+    unsigned* sqTail;               /** submission queue tail */
+    unsigned* sqMask;               /** submission queue index mask */
+    unsigned* sqArray;              /** submission queue index array */
+    struct io_uring_sqe* sqes;      /** submission queue entries */
+    unsigned* cqHead;               /** completion queue head */
+    unsigned* cqTail;               /** completion queue tail */
+    unsigned* cqMask;               /** completion queue index mask */
+    struct io_uring_cqe* cqes;      /** completion queue entries */
+    void* sqRing;                   /** mapping of the submission ring */
+    size_t sqRingSize;              /** size of the submission ring mapping */
+    void* cqRing;                   /** mapping of the completion ring */
+    size_t cqRingSize;              /** size of the completion ring mapping */
+    size_t sqesSize;                /** size of the entries mapping */
+    off_t offset;                   /** file offset of the next read */
+    uint32_t inflight;              /** reads submitted and not yet reaped */
+    struct iovec iov[INPUT_DEPTH];  /** read vector for each buffer */
+} InputRing;
+
+#endif
+
+/**
+ * @brief   object representing an input stream with read-ahead
+ */
+struct Input {
+    int fd;                                 /** input file descriptor */
+    InputMode mode;                         /** read-ahead strategy in use */
+    uint32_t depth;                         /** number of buffers in use */
+    uint32_t head;                          /** next buffer for the consumer */
+    bool eof;                               /** end of input was read */
+    bool done;                              /** consumer saw end of input */
+    int error;                              /** errno of a failed read */
+    InputBuffer buffer[INPUT_DEPTH];        /** read-ahead buffers */
+    pthread_t thread;                       /** read-ahead thread */
+    pthread_mutex_t lock;                   /** buffer state lock */
+    pthread_cond_t filled;                  /** a buffer became ready */
+    pthread_cond_t drained;                 /** a buffer became free */
+    bool stop;                              /** read-ahead thread must exit */
+#ifdef HAVE_LINUX_IO_URING_H
+    InputRing ring;                         /** io_uring state */
+#endif
+};
+
+/**
+ * @brief   the read-ahead strategy selected on the command line - Global
+ */
+InputMode inputMode = INPUT_AUTO;
+
+/*
+ * function prototypes
+ */
+static ssize_t
+inputRead(int fd,
+          char* data,
+          size_t size);
+
+static void*
+inputThread(void* argument);
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+static int
+inputRingNew(Input* input);
+
+static int
+inputRingReap(Input* input,
+              bool wait);
+
+static int
+inputRingSubmit(Input* input,
+                uint32_t index);
+
+/**
+ * @brief   tear down the io_uring rings once every read has completed
+ * @param   input the input object using io_uring
+ * @return  0 - success, -1 - failure
+ */
+static int
+inputRingFree(Input* input)
+{
+
+    InputRing* ring = &input->ring;
+
+    /* The kernel may still write into the buffers, drain every read. */
+    while (ring->inflight != 0) {
+        if (inputRingReap(input, true) == -1) {
+            break;
+        }
+    }
+
+    if (ring->sqes) {
+        munmap(ring->sqes, ring->sqesSize);
+    }
+    if (ring->cqRing && ring->cqRing != ring->sqRing) {
+        munmap(ring->cqRing, ring->cqRingSize);
+    }
+    if (ring->sqRing) {
+        munmap(ring->sqRing, ring->sqRingSize);
+    }
+    if (ring->fd != -1) {
+        close(ring->fd);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   create the io_uring rings and queue the initial reads
+ * @param   input the input object to be read through io_uring
+ * @return  0 - success, -1 - io_uring is unavailable for this input
+ */
+static int
+inputRingNew(Input* input)
+{
+
+    InputRing* ring = &input->ring;
+    struct io_uring_params params;
+    struct stat st;
+
+    ring->fd = -1;
+
+    /* Reads at explicit offsets only make sense on regular files. */
+    if (fstat(input->fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        return (-1);
+    }
+
+    memset(&params, 0, sizeof(params));
+
+    ring->fd = syscall(__NR_io_uring_setup, INPUT_DEPTH, &params);
+    if (ring->fd == -1) {
+        return (-1);
+    }
+
+    ring->sqRingSize = params.sq_off.array
+                       + params.sq_entries * sizeof(unsigned);
+    ring->cqRingSize = params.cq_off.cqes
+                       + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    /* Newer kernels map both rings with a single mmap() call. */
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cqRingSize > ring->sqRingSize) {
+            ring->sqRingSize = ring->cqRingSize;
+        }
+        ring->cqRingSize = ring->sqRingSize;
+    }
+
+    ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_SQ_RING);
+    if (ring->sqRing == MAP_FAILED) {
+        ring->sqRing = NULL;
+        inputRingFree(input);
+        return (-1);
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cqRing = ring->sqRing;
+    }
+    else {
+        ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ring->fd,
+                            IORING_OFF_CQ_RING);
+        if (ring->cqRing == MAP_FAILED) {
+            ring->cqRing = NULL;
+            inputRingFree(input);
+            return (-1);
+        }
+    }
+
+    ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        inputRingFree(input);
+        return (-1);
+    }
+
+    char* sq = ring->sqRing;
+    char* cq = ring->cqRing;
+
+    ring->sqTail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sqMask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+    ring->cqHead = (unsigned*)(cq + params.cq_off.head);
+    ring->cqTail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cqMask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    /* Start reading from the current file position. */
+    ring->offset = lseek(input->fd, 0, SEEK_CUR);
+    if (ring->offset == -1) {
+        ring->offset = 0;
+    }
+
+    /* Queue a read into every buffer. */
+    for (uint32_t i = 0; i < input->depth; i++) {
+
+        input->buffer[i].offset = ring->offset;
+        input->buffer[i].length = 0;
+        ring->offset += INPUT_BUFFER_SIZE;
+
+        if (inputRingSubmit(input, i) == -1) {
+            inputRingFree(input);
+            return (-1);
+        }
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   process the completed reads, optionally waiting for one
+ * @param   input the input object using io_uring
+ * @param   wait true to block until at least one read completes
+ * @return  0 - success, -1 - failure
+ */
+static int
+inputRingReap(Input* input,
+              bool wait)
+{
+
+    InputRing* ring = &input->ring;
+
+    unsigned head = *ring->cqHead;
+    unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    if (head == tail && wait) {
+
+        int status;
+
+        do {
+            status = syscall(__NR_io_uring_enter, ring->fd, 0, 1,
+                             IORING_ENTER_GETEVENTS, NULL, 0);
+        } while (status == -1 && errno == EINTR);
+
+        if (status == -1) {
+            return (-1);
+        }
+
+        tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    }
+
+    for (; head != tail; head++) {
+
+        struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cqMask];
+        InputBuffer* buffer = &input->buffer[cqe->user_data];
+
+        ring->inflight--;
+
+        if (cqe->res < 0) {
+            buffer->error = -cqe->res;
+            buffer->state = INPUT_READY;
+        }
+        else if (cqe->res == 0 || input->stop) {
+            buffer->state = INPUT_READY;
+        }
+        else {
+
+            buffer->length += cqe->res;
+
+            /*
+             * A short read either reached the end of the file or was cut
+             * short by the kernel; Read the remainder into the same buffer
+             * so that the buffers stay contiguous.
+             */
+            if (buffer->length < INPUT_BUFFER_SIZE) {
+                __atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+                if (inputRingSubmit(input, cqe->user_data) == -1) {
+                    buffer->error = errno;
+                    buffer->state = INPUT_READY;
+                }
+                continue;
+            }
+
+            buffer->state = INPUT_READY;
+
+        }
+
+    }
+
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+
+    return (0);
+
+}
+
+/**
+ * @brief   queue a read to fill the remainder of a buffer
+ * @param   input the input object using io_uring
+ * @param   index the buffer to be filled
+ * @return  0 - success, -1 - failure
+ */
+static int
+inputRingSubmit(Input* input,
+                uint32_t index)
+{
+
+    InputRing* ring = &input->ring;
+    InputBuffer* buffer = &input->buffer[index];
+
+    unsigned tail = *ring->sqTail;
+    unsigned slot = tail & *ring->sqMask;
+    struct io_uring_sqe* sqe = &ring->sqes[slot];
+
+    ring->iov[index].iov_base = buffer->data + buffer->length;
+    ring->iov[index].iov_len = INPUT_BUFFER_SIZE - buffer->length;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = input->fd;
+    sqe->addr = (uintptr_t)&ring->iov[index];
+    sqe->len = 1;
+    sqe->off = buffer->offset + buffer->length;
+    sqe->user_data = index;
+
+    ring->sqArray[slot] = slot;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    int status;
+
+    do {
+        status = syscall(__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+    } while (status == -1 && errno == EINTR);
+
+    if (status != 1) {
+        return (-1);
+    }
+
+    buffer->state = INPUT_PENDING;
+    ring->inflight++;
+
+    return (0);
+
+}
+
+#endif
+
+/**
+ * @brief   release the input object and any read-ahead resources
+ * @param   input the input object to be released
+ * @return  0 - success, -1 - a read from the input failed
+ */
+int
+inputFree(Input* input)
+{
+
+    int status = (input->error != 0) ? -1 : 0;
+
+    switch (input->mode) {
+
+        default: {
+            break;
+        }
+
+        case INPUT_THREAD: {
+
+            pthread_mutex_lock(&input->lock);
+            input->stop = true;
+            bool eof = input->eof;
+            pthread_cond_broadcast(&input->drained);
+            pthread_mutex_unlock(&input->lock);
+
+            /* The thread may be blocked on a read which will never end. */
+            if (!eof) {
+                pthread_cancel(input->thread);
+            }
+
+            pthread_join(input->thread, NULL);
+
+            pthread_cond_destroy(&input->drained);
+            pthread_cond_destroy(&input->filled);
+            pthread_mutex_destroy(&input->lock);
+
+            break;
+
+        }
+
+#ifdef HAVE_LINUX_IO_URING_H
+        case INPUT_URING: {
+            input->stop = true;
+            inputRingFree(input);
+            break;
+        }
+#endif
+
+    }
+
+    for (uint32_t i = 0; i < input->depth; i++) {
+        free(input->buffer[i].data);
+    }
+
+    free(input);
+
+    return (status);
+
+}
+
+/**
+ * @brief   convert a read-ahead strategy name into its mode
+ * @param   name one of "auto", "uring", "thread" or "sync"
+ * @param   mode the converted mode
+ * @return  0 - success, -1 - unknown name
+ */
+int
+inputModeParse(const char* name,
+               InputMode* mode)
+{
+
+    static const struct {
+        const char* name;
+        InputMode mode;
+    } modeVector[] = {
+        { "auto",   INPUT_AUTO },
+        { "uring",  INPUT_URING },
+        { "thread", INPUT_THREAD },
+        { "sync",   INPUT_SYNC },
+    };
+
+    for (size_t i = 0; i < sizeof(modeVector) / sizeof(modeVector[0]); i++) {
+        if (strcmp(name, modeVector[i].name) == 0) {
+            *mode = modeVector[i].mode;
+            return (0);
+        }
+    }
+
+    return (-1);
+
+}
+
+/**
+ * @brief   allocate a new input object and start reading ahead
+ * @details when the requested strategy is unavailable the next simpler one
+ *          is used;  io_uring falls back to a thread and a thread falls
+ *          back to synchronous reads
+ * @param   fd the file descriptor to be read
+ * @param   mode the requested read-ahead strategy
+ * @return  a pointer to the newly allocated input object
+ */
+Input*
+inputNew(int fd,
+         InputMode mode)
+{
+
+    Input* input;
+
+    input = calloc(1, sizeof(*input));
+
+    input->fd = fd;
+    input->error = 0;
+
+    if (mode == INPUT_AUTO) {
+        mode = INPUT_URING;
+    }
+
+#ifdef HAVE_LINUX_IO_URING_H
+    if (mode == INPUT_URING) {
+
+        input->depth = INPUT_DEPTH;
+
+        for (uint32_t i = 0; i < input->depth; i++) {
+            input->buffer[i].data = malloc(INPUT_BUFFER_SIZE);
+        }
+
+        if (inputRingNew(input) == 0) {
+            input->mode = INPUT_URING;
+            return (input);
+        }
+
+        for (uint32_t i = 0; i < input->depth; i++) {
+            free(input->buffer[i].data);
+            memset(&input->buffer[i], 0, sizeof(input->buffer[i]));
+        }
+
+    }
+#endif
+
+    /* Hint the kernel to read ahead aggressively on regular files. */
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (mode != INPUT_SYNC) {
+
+        input->depth = INPUT_THREAD_DEPTH;
+
+        for (uint32_t i = 0; i < input->depth; i++) {
+            input->buffer[i].data = malloc(INPUT_BUFFER_SIZE);
+            input->buffer[i].state = INPUT_FREE;
+        }
+
+        pthread_mutex_init(&input->lock, NULL);
+        pthread_cond_init(&input->filled, NULL);
+        pthread_cond_init(&input->drained, NULL);
+
+        if (pthread_create(&input->thread, NULL, inputThread, input) == 0) {
+            input->mode = INPUT_THREAD;
+            return (input);
+        }
+
+        pthread_cond_destroy(&input->drained);
+        pthread_cond_destroy(&input->filled);
+        pthread_mutex_destroy(&input->lock);
+
+        for (uint32_t i = 1; i < input->depth; i++) {
+            free(input->buffer[i].data);
+        }
+
+    }
+
+    /* Synchronous reads only need a single buffer. */
+    input->mode = INPUT_SYNC;
+    input->depth = 1;
+
+    if (!input->buffer[0].data) {
+        input->buffer[0].data = malloc(INPUT_BUFFER_SIZE);
+    }
+
+    return (input);
+
+}
+
+/**
+ * @brief   get the next buffer of input, in file order
+ * @param   input the input object to be read
+ * @return  a pointer to the filled buffer, NULL at end of input or when a
+ *          read failed
+ */
+InputBuffer*
+inputNext(Input* input)
+{
+
+    if (input->done) {
+        return (NULL);
+    }
+
+    InputBuffer* buffer = &input->buffer[input->head];
+
+    switch (input->mode) {
+
+        default:
+        case INPUT_SYNC: {
+
+            ssize_t length = inputRead(input->fd, buffer->data,
+                                       INPUT_BUFFER_SIZE);
+
+            buffer->length = (length > 0) ? length : 0;
+            buffer->error = (length == -1) ? errno : 0;
+            buffer->state = INPUT_READY;
+
+            break;
+
+        }
+
+        case INPUT_THREAD: {
+
+            uint64_t start = traceStart();
+
+            pthread_mutex_lock(&input->lock);
+            while (buffer->state != INPUT_READY) {
+                pthread_cond_wait(&input->filled, &input->lock);
+            }
+            pthread_mutex_unlock(&input->lock);
+
+            traceSpan("read wait", start);
+
+            break;
+
+        }
+
+#ifdef HAVE_LINUX_IO_URING_H
+        case INPUT_URING: {
+
+            uint64_t start = traceStart();
+
+            while (buffer->state != INPUT_READY) {
+                if (inputRingReap(input, true) == -1) {
+                    buffer->error = errno;
+                    break;
+                }
+            }
+
+            traceSpan("read wait", start);
+
+            break;
+
+        }
+#endif
+
+    }
+
+    /* Either end of input or a failed read terminates the stream. */
+    if (buffer->error != 0 || buffer->length == 0) {
+        input->error = buffer->error;
+        input->eof = true;
+        input->done = true;
+        return (NULL);
+    }
+
+    input->head = (input->head + 1) % input->depth;
+
+    return (buffer);
+
+}
+
+/**
+ * @brief   read from a file descriptor, retrying interrupted reads
+ * @param   fd the file descriptor to be read
+ * @param   data the buffer receiving the data
+ * @param   size the size of the buffer
+ * @return  the number of bytes read, 0 at end of input, -1 on failure
+ */
+static ssize_t
+inputRead(int fd,
+          char* data,
+          size_t size)
+{
+
+    ssize_t length;
+    uint64_t start = traceStart();
+
+    do {
+        length = read(fd, data, size);
+    } while (length == -1 && errno == EINTR);
+
+    traceSpan("read", start);
+
+    return (length);
+
+}
+
+/**
+ * @brief   hand a consumed buffer back to the input layer for reuse
+ * @param   input the input object owning the buffer
+ * @param   buffer the buffer returned by inputNext()
+ * @return  0 - success, -1 - failure
+ */
+int
+inputRelease(Input* input,
+             InputBuffer* buffer)
+{
+
+    switch (input->mode) {
+
+        default:
+        case INPUT_SYNC: {
+            buffer->state = INPUT_FREE;
+            break;
+        }
+
+        case INPUT_THREAD: {
+
+            pthread_mutex_lock(&input->lock);
+            buffer->state = INPUT_FREE;
+            pthread_cond_signal(&input->drained);
+            pthread_mutex_unlock(&input->lock);
+
+            break;
+
+        }
+
+#ifdef HAVE_LINUX_IO_URING_H
+        case INPUT_URING: {
+
+            /* A short buffer marks the end of the file, stop reading. */
+            if (buffer->length < INPUT_BUFFER_SIZE) {
+                input->eof = true;
+            }
+
+            if (input->eof) {
+                buffer->state = INPUT_FREE;
+                break;
+            }
+
+            /* Refill the buffer with the next unread part of the file. */
+            buffer->offset = input->ring.offset;
+            buffer->length = 0;
+            input->ring.offset += INPUT_BUFFER_SIZE;
+
+            if (inputRingSubmit(input, buffer - input->buffer) == -1) {
+                buffer->error = errno;
+                buffer->state = INPUT_READY;
+                return (-1);
+            }
+
+            break;
+
+        }
+#endif
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   entry point for the read-ahead thread
+ * @details fills the buffers in ring order for as long as the consumer
+ *          hands them back, terminating at end of input or on error
+ * @param   argument the input object to be filled
+ * @return  NULL
+ */
+static void*
+inputThread(void* argument)
+{
+
+    Input* input = argument;
+
+    for (uint32_t i = 0; ; i = (i + 1) % input->depth) {
+
+        InputBuffer* buffer = &input->buffer[i];
+
+        pthread_mutex_lock(&input->lock);
+        while (buffer->state != INPUT_FREE && !input->stop) {
+            pthread_cond_wait(&input->drained, &input->lock);
+        }
+        bool stop = input->stop;
+        pthread_mutex_unlock(&input->lock);
+
+        if (stop) {
+            break;
+        }
+
+        ssize_t length = inputRead(input->fd, buffer->data,
+                                   INPUT_BUFFER_SIZE);
+
+        pthread_mutex_lock(&input->lock);
+        buffer->length = (length > 0) ? length : 0;
+        buffer->error = (length == -1) ? errno : 0;
+        buffer->state = INPUT_READY;
+        if (length <= 0) {
+            input->eof = true;
+        }
+        pthread_cond_signal(&input->filled);
+        pthread_mutex_unlock(&input->lock);
+
+        if (length <= 0) {
+            break;
+        }
+
+    }
+
+    return (NULL);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,120 @@
+/**
+ * @file input.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the read-ahead input layer
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+/**
+ * @brief   read-ahead strategies supported by the input layer
+ */
+typedef enum {
+    INPUT_AUTO = 0,     /** io_uring when usable, otherwise a thread */
+    INPUT_URING,        /** io_uring with several reads in flight */
+    INPUT_THREAD,       /** read-ahead thread with triple buffering */
+    INPUT_SYNC,         /** synchronous read() into a single buffer */
+} InputMode;
+
+enum {
+    INPUT_BUFFER_SIZE = 256 * 1024,         /** size of a read-ahead buffer */
+    INPUT_DEPTH = 4,                        /** io_uring reads in flight */
+    INPUT_THREAD_DEPTH = 3,                 /** read-ahead thread buffers */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Input Input;
+typedef struct InputBuffer InputBuffer;
+
+/**
+ * @brief   object representing a filled read-ahead buffer
+ */
+struct InputBuffer {
+    char* data;         /** buffer contents */
+    size_t length;      /** number of valid bytes within the buffer */
+    off_t offset;       /** file offset of the buffer contents */
+    int state;          /** free, pending or ready for the consumer */
+    int error;          /** errno of a failed read, 0 if none */
+};
+
+/**
+ * @brief   the read-ahead strategy selected on the command line - Global
+ */
+extern InputMode inputMode;
+
+/**
+ * @brief   function prototype
+ */
+int
+inputFree(Input* input);
+
+/**
+ * @brief   function prototype
+ */
+int
+inputModeParse(const char* name,
+               InputMode* mode);
+
+/**
+ * @brief   function prototype
+ */
+Input*
+inputNew(int fd,
+         InputMode mode);
+
+/**
+ * @brief   function prototype
+ */
+InputBuffer*
+inputNext(Input* input);
+
+/**
+ * @brief   function prototype
+ */
+int
+inputRelease(Input* input,
+             InputBuffer* buffer);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
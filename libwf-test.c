@@ -0,0 +1,196 @@
+/**
+ * @file libwf-test.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Test program for the library interface
+ *
+ * Counts a file through libwf, fed in chunks of odd sizes so that words
+ * straddle the chunks, after counting it once and resetting the context, and
+ * displays the top words, those with a prefix if one is given.  A context
+ * with a small memory limit must fail to count the file, and a context with
+ * digits, '_' and '\'' among its letters must count and find words made of
+ * them.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <libwf.h>
+
+enum {
+    LIBWF_TEST_TOP = 20,                    /** words displayed */
+    LIBWF_TEST_LIMIT = 64 * 1024,           /** memory limit bound to fail */
+};
+
+/*
+ * function prototypes
+ */
+static int
+libwfTestFeed(WfContext* ctx,
+              FILE* ifp,
+              bool odd);
+
+/**
+ * @brief   feed a file to a context, in chunks of odd sizes or all at once
+ * @param   ctx the context
+ * @param   ifp the file, read from its start
+ * @param   odd true - cycle through chunks of odd sizes, false - use one
+ *          large chunk at a time
+ * @return  0 - success, -1 - failure
+ */
+static int
+libwfTestFeed(WfContext* ctx,
+              FILE* ifp,
+              bool odd)
+{
+
+    static const size_t sizeVector[] = { 1, 3, 7, 61, 509, 4093 };
+    static char buffer[1 << 16];
+    size_t next = 0;
+    size_t count;
+
+    rewind(ifp);
+
+    do {
+
+        size_t size = sizeof(buffer);
+
+        if (odd) {
+            size = sizeVector[next++ % (sizeof(sizeVector)
+                                        / sizeof(sizeVector[0]))];
+        }
+
+        count = fread(buffer, 1, size, ifp);
+
+        if (wf_feed(ctx, buffer, count) == -1) {
+            return (-1);
+        }
+
+    } while (count != 0);
+
+    return (ferror(ifp) ? -1 : wf_flush(ctx));
+
+}
+
+/**
+ * @brief   entry point for the "libwf-test" program
+ * @param   argc the number of command line arguments
+ * @param   argv the command line arguments, the file and an optional prefix
+ * @return  0 - success, 1 - failure
+ */
+int
+main(int argc,
+     char* argv[])
+{
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s <FILE> [ <PREFIX> ]\n",
+                basename(argv[0]));
+        return (1);
+    }
+
+    FILE* ifp = fopen(argv[1], "r");
+    WfContext* ctx = wf_new(NULL);
+
+    if (!ifp || !ctx) {
+        return (1);
+    }
+
+    /* Counted twice with a reset in between, the counts are those of one. */
+    if (libwfTestFeed(ctx, ifp, false) == -1
+        || wf_reset(ctx) == -1
+        || libwfTestFeed(ctx, ifp, true) == -1) {
+        return (1);
+    }
+
+    WfEntry out[LIBWF_TEST_TOP];
+    int count = (argc == 3) ? wf_prefix(ctx, argv[2], LIBWF_TEST_TOP, out)
+                            : wf_topk(ctx, LIBWF_TEST_TOP, out);
+
+    if (count == -1) {
+        return (1);
+    }
+
+    for (int i = 0; i < count; i++) {
+
+        /* A ranked word is found with the same count on its own. */
+        if (wf_count(ctx, out[i].word) != out[i].frequency) {
+            return (1);
+        }
+
+        printf("%7" PRIu64 " %s\n", out[i].frequency, out[i].word);
+
+    }
+
+    wf_free(ctx);
+
+    /* The file takes more nodes than a small limit allows. */
+    WfOptions options = { .memoryLimit = LIBWF_TEST_LIMIT };
+
+    ctx = wf_new(&options);
+
+    if (!ctx || libwfTestFeed(ctx, ifp, true) != -1 || errno != ENOMEM) {
+        return (1);
+    }
+
+    wf_free(ctx);
+    fclose(ifp);
+
+    /* Words of an alphabet of its own are found folded like the text. */
+    static const char text[] = "Don't count x_1 or X_1, don't count x-1";
+
+    options = (WfOptions) { .alphabet = "a-z0-9_'" };
+    ctx = wf_new(&options);
+
+    if (!ctx || wf_feed(ctx, text, sizeof(text) - 1) == -1
+        || wf_flush(ctx) == -1
+        || wf_count(ctx, "don't") != 2 || wf_count(ctx, "X_1") != 2
+        || wf_count(ctx, "x1") != 0 || wf_count(ctx, "x-1") != 0) {
+        return (1);
+    }
+
+    wf_free(ctx);
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,422 @@
+/**
+ * @file libwf.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module of the embeddable word frequency library (libwf)
+ *
+ * The library keeps all of its state within the context object and reports
+ * memory allocation failures to the caller instead of terminating the
+ * process, so it can be linked into long running services
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <arena.h>
+#include <libwf.h>
+#include <trie.h>
+
+/**
+ * @brief   object representing a word counting context
+ */
+struct WfContext {
+    WfOptions options;      /** options the context was created with */
+    Alphabet alphabet;      /** letters of the words */
+    Trie* trie;             /** words counted so far */
+    char* word;             /** word in progress, may span fed buffers */
+    size_t length;          /** length of the word in progress */
+    size_t size;            /** allocated size of the word in progress */
+    Arena* results;         /** words of the most recent query result */
+    WfEntry* out;           /** entries of the query being collected */
+    size_t count;           /** number of entries collected */
+};
+
+/*
+ * function prototypes
+ */
+static TrieTopFunc wfCollect;
+
+static int
+wfCount(WfContext* ctx);
+
+static int
+wfQuery(WfContext* ctx,
+        const char* prefix,
+        size_t k,
+        WfEntry* out);
+
+/**
+ * @brief   collect a query result entry
+ * @param   argument the context collecting the result
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+wfCollect(void* argument,
+          const char* word,
+          uint64_t frequency)
+{
+
+    WfContext* ctx = argument;
+
+    uint32_t offset = arenaAppend(ctx->results, word, strlen(word));
+
+    if (offset == 0) {
+        return (-1);
+    }
+
+    /* The arena may move while collecting, keep the offset for now. */
+    ctx->out[ctx->count].word = (const char*)(uintptr_t)offset;
+    ctx->out[ctx->count].frequency = frequency;
+    ctx->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   count the word in progress
+ * @param   ctx the context
+ * @return  0 - success, -1 - failure
+ */
+static int
+wfCount(WfContext* ctx)
+{
+
+    size_t length = ctx->length;
+
+    ctx->word[length] = '\0';
+    ctx->length = 0;
+
+    /* Assume the worst case of a new node for every letter. */
+    if (ctx->options.memoryLimit != 0
+        && (ctx->trie->nodes + length) * ctx->trie->nodeSize
+           > ctx->options.memoryLimit) {
+        errno = ENOMEM;
+        return (-1);
+    }
+
+    if (!trieInsert(ctx->trie, ctx->word)) {
+        errno = ENOMEM;
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   get the frequency of a single word
+ * @details the word is folded onto the letters of the context's alphabet
+ *          while its path is walked, like the words of the fed text
+ * @param   ctx the context
+ * @param   word the word
+ * @return  the number of occurrences of the word, 0 if it was not seen or
+ *          holds a character which is not a letter
+ */
+uint64_t
+wf_count(WfContext* ctx,
+         const char* word)
+{
+
+    TrieNode* node = ctx->trie->root;
+
+    for (; *word != '\0' && node; word++) {
+
+        unsigned char letter = ctx->alphabet.fold[(unsigned char) *word];
+
+        if (letter == 0) {
+            return (0);
+        }
+
+        node = node->child[alphabetIndex(&ctx->alphabet, letter)];
+
+    }
+
+    return (node ? counterValue(&ctx->trie->wide, node->frequency) : 0);
+
+}
+
+/**
+ * @brief   count the words within a buffer of text
+ * @details a word which reaches the end of the buffer is continued by the
+ *          next call, or counted by wf_flush()
+ * @param   ctx the context
+ * @param   buf the text
+ * @param   len the length of the text
+ * @return  0 - success, -1 - failure, in which case the rest of the
+ *          buffer is not counted
+ */
+int
+wf_feed(WfContext* ctx,
+        const char* buf,
+        size_t len)
+{
+
+    for (size_t i = 0; i < len; i++) {
+
+        unsigned char letter = ctx->alphabet.fold[(unsigned char) buf[i]];
+
+        if (letter != 0) {
+
+            /* Leave room for the terminator of the word. */
+            if (ctx->length + 1 >= ctx->size) {
+
+                size_t size = 2 * ctx->size;
+                char* word = realloc(ctx->word, size);
+
+                if (!word) {
+                    errno = ENOMEM;
+                    return (-1);
+                }
+
+                ctx->word = word;
+                ctx->size = size;
+
+            }
+
+            ctx->word[ctx->length++] = letter;
+
+        }
+
+        else if (ctx->length != 0) {
+
+            if (wfCount(ctx) == -1) {
+                return (-1);
+            }
+
+        }
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   count a word left in progress at the end of the fed text
+ * @param   ctx the context
+ * @return  0 - success, -1 - failure
+ */
+int
+wf_flush(WfContext* ctx)
+{
+
+    if (ctx->length != 0) {
+        return (wfCount(ctx));
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a context and all of its memory
+ * @param   ctx the context, may be NULL
+ * @return  none
+ */
+void
+wf_free(WfContext* ctx)
+{
+
+    if (!ctx) {
+        return;
+    }
+
+    if (ctx->trie) {
+        trieFree(ctx->trie);
+    }
+
+    if (ctx->results) {
+        arenaFree(ctx->results);
+    }
+
+    free(ctx->word);
+    free(ctx);
+
+}
+
+/**
+ * @brief   allocate a new counting context
+ * @param   opts the options of the context, NULL for the defaults
+ * @return  a pointer to the new context, NULL with errno set to EINVAL if
+ *          the alphabet is not valid, to ENOMEM if memory could not be
+ *          allocated
+ */
+WfContext*
+wf_new(const WfOptions* opts)
+{
+
+    WfContext* ctx;
+
+    ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        errno = ENOMEM;
+        return (NULL);
+    }
+
+    if (opts) {
+        ctx->options = *opts;
+    }
+
+    /* The specification is only needed until it is compiled. */
+    const char* spec = ctx->options.alphabet ? ctx->options.alphabet
+                                             : ALPHABET_DEFAULT;
+
+    ctx->options.alphabet = NULL;
+
+    if (alphabetParse(spec, &ctx->alphabet) == -1) {
+        free(ctx);
+        errno = EINVAL;
+        return (NULL);
+    }
+
+    ctx->size = 64;
+    ctx->word = malloc(ctx->size);
+    ctx->trie = trieNew(&ctx->alphabet);
+    ctx->results = arenaNew(4096);
+
+    if (!ctx->word || !ctx->trie || !ctx->results) {
+        wf_free(ctx);
+        errno = ENOMEM;
+        return (NULL);
+    }
+
+    return (ctx);
+
+}
+
+/**
+ * @brief   get the most frequent words starting with a prefix
+ * @param   ctx the context
+ * @param   prefix the prefix of the words, "" for all words
+ * @param   k the maximum number of words, the size of out
+ * @param   out the entries receiving the result, in rank order;  The words
+ *          remain valid until the next query, reset or free of the context
+ * @return  the number of entries filled, -1 - failure
+ */
+int
+wf_prefix(WfContext* ctx,
+          const char* prefix,
+          size_t k,
+          WfEntry* out)
+{
+
+    return (wfQuery(ctx, prefix, k, out));
+
+}
+
+/**
+ * @brief   discard every word counted so far
+ * @param   ctx the context
+ * @return  0 - success, -1 - failure
+ */
+int
+wf_reset(WfContext* ctx)
+{
+
+    ctx->length = 0;
+
+    arenaReset(ctx->results);
+
+    return (trieReset(ctx->trie));
+
+}
+
+/**
+ * @brief   get the most frequent words
+ * @param   ctx the context
+ * @param   k the maximum number of words, the size of out
+ * @param   out the entries receiving the result, in rank order;  The words
+ *          remain valid until the next query, reset or free of the context
+ * @return  the number of entries filled, -1 - failure
+ */
+int
+wf_topk(WfContext* ctx,
+        size_t k,
+        WfEntry* out)
+{
+
+    return (wfQuery(ctx, "", k, out));
+
+}
+
+/**
+ * @brief   run a best-first query against the counted words
+ * @param   ctx the context
+ * @param   prefix the prefix of the words, "" for all words
+ * @param   k the maximum number of words, the size of out
+ * @param   out the entries receiving the result
+ * @return  the number of entries filled, -1 - failure
+ */
+static int
+wfQuery(WfContext* ctx,
+        const char* prefix,
+        size_t k,
+        WfEntry* out)
+{
+
+    if (k > INT32_MAX) {
+        k = INT32_MAX;
+    }
+
+    arenaReset(ctx->results);
+
+    ctx->out = out;
+    ctx->count = 0;
+
+    if (trieTop(ctx->trie, prefix, k, wfCollect, ctx) == -1) {
+        errno = ENOMEM;
+        return (-1);
+    }
+
+    /* The arena no longer moves, turn the offsets into pointers. */
+    for (size_t i = 0; i < ctx->count; i++) {
+        out[i].word = ctx->results->base + (uintptr_t)out[i].word;
+    }
+
+    return (ctx->count);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,152 @@
+/**
+ * @file libwf.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Public interface of the embeddable word frequency library (libwf)
+ *
+ * A context counts the words of text fed to it incrementally and answers top
+ * frequency queries at any time;  Contexts share no state, so separate
+ * contexts may be used concurrently from separate threads
+ *
+ * A word is one or more letters from the character set [a-zA-Z], counted
+ * case independently;  Words of equal frequency rank in reverse
+ * lexicographical order, as with the wf program
+ *
+ * Functions returning int report 0 - success, -1 - failure;  Memory
+ * allocation failures are reported with errno set to ENOMEM and leave the
+ * context usable
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * forward declarations
+ */
+typedef struct WfContext WfContext;
+typedef struct WfEntry WfEntry;
+typedef struct WfOptions WfOptions;
+
+/**
+ * @brief   object representing the options of a new context
+ */
+struct WfOptions {
+    size_t memoryLimit;     /** maximum bytes of counting state, 0 - none */
+    const char* alphabet;   /** letters of the words as for --alphabet,
+                                NULL - "a-z" */
+};
+
+/**
+ * @brief   object representing a word and its frequency in a query result
+ */
+struct WfEntry {
+    const char* word;       /** the word, owned by the context */
+    uint64_t frequency;     /** the number of occurrences of the word */
+};
+
+/**
+ * @brief   function prototype
+ */
+uint64_t
+wf_count(WfContext* ctx,
+         const char* word);
+
+/**
+ * @brief   function prototype
+ */
+int
+wf_feed(WfContext* ctx,
+        const char* buf,
+        size_t len);
+
+/**
+ * @brief   function prototype
+ */
+int
+wf_flush(WfContext* ctx);
+
+/**
+ * @brief   function prototype
+ */
+void
+wf_free(WfContext* ctx);
+
+/**
+ * @brief   function prototype
+ */
+WfContext*
+wf_new(const WfOptions* opts);
+
+/**
+ * @brief   function prototype
+ */
+int
+wf_prefix(WfContext* ctx,
+          const char* prefix,
+          size_t k,
+          WfEntry* out);
+
+/**
+ * @brief   function prototype
+ */
+int
+wf_reset(WfContext* ctx);
+
+/**
+ * @brief   function prototype
+ */
+int
+wf_topk(WfContext* ctx,
+        size_t k,
+        WfEntry* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,566 @@
+/**
+ * @file packed.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for packed word table object
+ *
+ * The words of up to PACKED_LETTERS letters are counted by an open addressed
+ * hash table keyed by the word packed into one integer, so a word is counted
+ * with an integer hash and compare rather than a walk down the trie, and the
+ * top words are selected with integer compares alone.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <packed.h>
+#include <trie.h>
+
+/**
+ * @brief   object representing the walk of a trie merged with the packed
+ *          words in byte order
+ */
+typedef struct PackedMerge {
+    PackedSlot* sorted;                     /** packed words in key order */
+    uint32_t count;                         /** number of packed words */
+    uint32_t next;                          /** next packed word to merge */
+    char word[PACKED_LETTERS + 1];          /** next packed word, unpacked */
+    TrieTopFunc* func;                      /** function called with each
+                                                word */
+    void* argument;                         /** argument of the function */
+} PackedMerge;
+
+/*
+ * function prototypes
+ */
+static int
+packedCompare(const void* a,
+              const void* b);
+
+static inline uint32_t
+packedHash(const Packed* packed,
+           uint64_t key);
+
+static inline bool
+packedLess(const PackedSlot* a,
+           const PackedSlot* b);
+
+static TrieTopFunc packedMergeWord;
+
+static int
+packedRebuild(Packed* packed);
+
+static void
+packedSift(PackedSlot* heap,
+           uint32_t count,
+           uint32_t i);
+
+/**
+ * @brief   compare two slots for sorting by key, so in byte order
+ * @param   a pointer to the first slot
+ * @param   b pointer to the second slot
+ * @return  less than, equal to or greater than zero as the first word
+ *          sorts before, with or after the second
+ */
+static int
+packedCompare(const void* a,
+              const void* b)
+{
+
+    uint64_t first = ((const PackedSlot*) a)->key;
+    uint64_t second = ((const PackedSlot*) b)->key;
+
+    return ((first > second) - (first < second));
+
+}
+
+/**
+ * @brief   unpack a word from its key
+ * @param   key the packed word
+ * @param   word the unpacked word, room for PACKED_LETTERS letters and the
+ *          terminator
+ * @return  the length of the word
+ */
+size_t
+packedDecode(uint64_t key,
+             char* word)
+{
+
+    size_t length = 0;
+
+    for (uint32_t i = PACKED_LETTERS; i-- > 0; length++) {
+
+        uint32_t code = (key >> (i * PACKED_BITS)) & ((1 << PACKED_BITS) - 1);
+
+        if (code == 0) {
+            break;
+        }
+
+        word[length] = alphabet.letter[code - 1];
+
+    }
+
+    word[length] = '\0';
+
+    return (length);
+
+}
+
+/**
+ * @brief   pack a word into its key
+ * @details only the letters numbered below 2^PACKED_BITS - 1 in the
+ *          alphabet are packed, which is every letter of an alphabet of up
+ *          to 31 letters
+ * @param   word the word
+ * @param   key the packed word
+ * @return  true - the word was packed, false - the word is empty, too long
+ *          or holds a letter which cannot be packed
+ */
+bool
+packedEncode(const char* word,
+             uint64_t* key)
+{
+
+    uint64_t packed = 0;
+    size_t length;
+
+    for (length = 0; word[length] != '\0'; length++) {
+
+        uint32_t index = alphabetIndex(&alphabet, word[length]);
+
+        if (length == PACKED_LETTERS || index >= (1 << PACKED_BITS) - 1) {
+            return (false);
+        }
+
+        packed |= (uint64_t) (index + 1)
+                  << ((PACKED_LETTERS - 1 - length) * PACKED_BITS);
+
+    }
+
+    *key = packed;
+
+    return (length != 0);
+
+}
+
+/**
+ * @brief   release a packed word table object
+ * @param   packed the table to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+packedFree(Packed* packed)
+{
+
+    free(packed->slot);
+    free(packed);
+
+    return (0);
+
+}
+
+/**
+ * @brief   compute the first slot to probe for a key (Fibonacci hashing)
+ * @param   packed the table
+ * @param   key the packed word
+ * @return  the slot
+ */
+static inline uint32_t
+packedHash(const Packed* packed,
+           uint64_t key)
+{
+
+    return ((key * 0x9e3779b97f4a7c15ULL) >> packed->shift);
+
+}
+
+/**
+ * @brief   count an occurrence of a packed word
+ * @param   packed the table
+ * @param   key the packed word
+ * @return  0 - success, -1 - failure
+ */
+int
+packedInsert(Packed* packed,
+             uint64_t key)
+{
+
+    uint32_t mask = packed->size - 1;
+    uint32_t i = packedHash(packed, key);
+
+    while (packed->slot[i].key != key) {
+
+        if (packed->slot[i].key != 0) {
+            i = (i + 1) & mask;
+            continue;
+        }
+
+        /* Keep at least half of the slots empty so that probes stay short. */
+        if (2 * (packed->count + 1) > packed->size) {
+            if (packedRebuild(packed) == -1) {
+                return (-1);
+            }
+            mask = packed->size - 1;
+            i = packedHash(packed, key);
+            continue;
+        }
+
+        packed->slot[i].key = key;
+        packed->count++;
+
+    }
+
+    packed->slot[i].frequency++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   determine if one word ranks below another
+ * @param   a the first word
+ * @param   b the second word
+ * @return  true - a has a lower frequency, or the same frequency and a
+ *          lexicographically smaller word, false - otherwise
+ */
+static inline bool
+packedLess(const PackedSlot* a,
+           const PackedSlot* b)
+{
+
+    if (a->frequency != b->frequency) {
+        return (a->frequency < b->frequency);
+    }
+
+    return (a->key < b->key);
+
+}
+
+/**
+ * @brief   report every word of a trie and of a packed table in byte order
+ * @details the packed words are sorted by key and merged into the walk of
+ *          the trie, which holds the words too long to be packed
+ * @param   packed the table
+ * @param   trie the trie
+ * @param   func the function called with each word and its frequency
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+int
+packedMerge(Packed* packed,
+            Trie* trie,
+            TrieTopFunc* func,
+            void* argument)
+{
+
+    PackedMerge merge = {
+        .sorted = malloc((packed->count ? packed->count : 1)
+                         * sizeof(*merge.sorted)),
+        .func = func,
+        .argument = argument,
+    };
+
+    if (!merge.sorted) {
+        return (-1);
+    }
+
+    for (uint32_t i = 0; i < packed->size; i++) {
+        if (packed->slot[i].key != 0) {
+            merge.sorted[merge.count++] = packed->slot[i];
+        }
+    }
+
+    qsort(merge.sorted, merge.count, sizeof(*merge.sorted), packedCompare);
+
+    if (merge.count != 0) {
+        packedDecode(merge.sorted[0].key, merge.word);
+    }
+
+    int status = trieWalk(trie, packedMergeWord, &merge);
+
+    /* The packed words after the last word of the trie. */
+    for (; status == 0 && merge.next < merge.count; merge.next++) {
+        packedDecode(merge.sorted[merge.next].key, merge.word);
+        status = func(argument, merge.word,
+                      merge.sorted[merge.next].frequency);
+    }
+
+    free(merge.sorted);
+
+    return (status);
+
+}
+
+/**
+ * @brief   report the packed words sorting before a word of the trie, then
+ *          the word
+ * @param   argument the merge
+ * @param   word the word of the trie
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+packedMergeWord(void* argument,
+                const char* word,
+                uint64_t frequency)
+{
+
+    PackedMerge* merge = argument;
+
+    while (merge->next < merge->count && strcmp(merge->word, word) < 0) {
+
+        if (merge->func(merge->argument, merge->word,
+                        merge->sorted[merge->next].frequency) == -1) {
+            return (-1);
+        }
+
+        if (++merge->next < merge->count) {
+            packedDecode(merge->sorted[merge->next].key, merge->word);
+        }
+
+    }
+
+    return (merge->func(merge->argument, word, frequency));
+
+}
+
+/**
+ * @brief   allocate a new, empty packed word table object
+ * @param   none
+ * @return  a pointer to the newly allocated table object, NULL if memory
+ *          could not be allocated
+ */
+Packed*
+packedNew(void)
+{
+
+    Packed* packed = calloc(1, sizeof(*packed));
+
+    if (!packed) {
+        return (NULL);
+    }
+
+    packed->size = PACKED_SIZE;
+    packed->shift = 64 - __builtin_ctz(PACKED_SIZE);
+    packed->slot = calloc(packed->size, sizeof(*packed->slot));
+
+    if (!packed->slot) {
+        packedFree(packed);
+        return (NULL);
+    }
+
+    return (packed);
+
+}
+
+/**
+ * @brief   rebuild the hash table at twice its size
+ * @param   packed the table
+ * @return  0 - success, -1 - failure
+ */
+static int
+packedRebuild(Packed* packed)
+{
+
+    Packed larger = {
+        .size = 2 * packed->size,
+        .shift = packed->shift - 1,
+        .count = packed->count,
+    };
+
+    larger.slot = calloc(larger.size, sizeof(*larger.slot));
+
+    if (!larger.slot) {
+        return (-1);
+    }
+
+    for (uint32_t i = 0; i < packed->size; i++) {
+
+        PackedSlot* from = &packed->slot[i];
+
+        if (from->key == 0) {
+            continue;
+        }
+
+        uint32_t j = packedHash(&larger, from->key);
+
+        while (larger.slot[j].key != 0) {
+            j = (j + 1) & (larger.size - 1);
+        }
+
+        larger.slot[j] = *from;
+
+    }
+
+    free(packed->slot);
+
+    *packed = larger;
+
+    return (0);
+
+}
+
+/**
+ * @brief   restore the order of a min-heap of words below one of them
+ * @param   heap the heap, the lowest ranking word at its root
+ * @param   count the number of words in the heap
+ * @param   i the word which may rank above its children
+ * @return  none
+ */
+static void
+packedSift(PackedSlot* heap,
+           uint32_t count,
+           uint32_t i)
+{
+
+    PackedSlot moving = heap[i];
+
+    for (;;) {
+
+        uint32_t child = 2 * i + 1;
+
+        if (child >= count) {
+            break;
+        }
+
+        if (child + 1 < count && packedLess(&heap[child + 1], &heap[child])) {
+            child++;
+        }
+
+        if (!packedLess(&heap[child], &moving)) {
+            break;
+        }
+
+        heap[i] = heap[child];
+        i = child;
+
+    }
+
+    heap[i] = moving;
+
+}
+
+/**
+ * @brief   report the most frequent packed words starting with a prefix
+ * @details the words are selected by a min-heap of their slots, ranked with
+ *          integer compares only, as packing keeps the byte order of the
+ *          words;  The words are reported in no particular order
+ * @param   packed the table
+ * @param   prefix the prefix of the words, NULL or "" for every word
+ * @param   count the number of words to report at most
+ * @param   func the function called with each word and its frequency
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+int
+packedTop(Packed* packed,
+          const char* prefix,
+          uint32_t count,
+          TrieTopFunc* func,
+          void* argument)
+{
+
+    /* A word matches when its leading letters pack as the prefix does. */
+    uint64_t match = 0;
+    uint32_t shift = PACKED_LETTERS * PACKED_BITS;
+
+    if (prefix && *prefix != '\0') {
+
+        /* No packed word starts with a prefix which cannot be packed. */
+        if (!packedEncode(prefix, &match)) {
+            return (0);
+        }
+
+        shift = (PACKED_LETTERS - strlen(prefix)) * PACKED_BITS;
+
+    }
+
+    if (count > packed->count) {
+        count = packed->count;
+    }
+
+    PackedSlot* heap = malloc((count ? count : 1) * sizeof(*heap));
+    uint32_t used = 0;
+
+    if (!heap) {
+        return (-1);
+    }
+
+    for (uint32_t i = 0; i < packed->size && count != 0; i++) {
+
+        PackedSlot* slot = &packed->slot[i];
+
+        if (slot->key == 0 || (slot->key >> shift) != (match >> shift)) {
+            continue;
+        }
+
+        /* The heap is built once full, then only better words enter it. */
+        if (used < count) {
+            heap[used++] = *slot;
+            if (used == count) {
+                for (uint32_t j = count / 2; j-- > 0; ) {
+                    packedSift(heap, count, j);
+                }
+            }
+        }
+        else if (packedLess(&heap[0], slot)) {
+            heap[0] = *slot;
+            packedSift(heap, count, 0);
+        }
+
+    }
+
+    int status = 0;
+    char word[PACKED_LETTERS + 1];
+
+    for (uint32_t i = 0; i < used && status == 0; i++) {
+        packedDecode(heap[i].key, word);
+        status = func(argument, word, heap[i].frequency);
+    }
+
+    free(heap);
+
+    return (status);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,141 @@
+/**
+ * @file packed.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for packed word table object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <trie.h>
+
+enum {
+    PACKED_BITS = 5,                        /** bits of a packed letter */
+    PACKED_LETTERS = 12,                    /** letters of the longest
+                                                packed word */
+    PACKED_SIZE = 4096,                     /** initial number of slots */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Packed Packed;
+typedef struct PackedSlot PackedSlot;
+
+/**
+ * @brief   object representing a slot of the packed word table
+ */
+struct PackedSlot {
+    uint64_t key;                           /** packed word, 0 if empty */
+    uint64_t frequency;                     /** word frequency */
+};
+
+/**
+ * @brief   object representing the short words counted by their packed key
+ * @details a word of up to PACKED_LETTERS letters is packed into one integer
+ *          at PACKED_BITS bits per letter, the first letter in the highest
+ *          bits and each letter numbered from one in alphabet order, so the
+ *          keys sort as the words do
+ */
+struct Packed {
+    PackedSlot* slot;                       /** open addressed hash table of
+                                                the words */
+    uint32_t size;                          /** number of slots, a power of
+                                                two */
+    uint32_t shift;                         /** bits of a hash beyond the
+                                                slot number */
+    uint32_t count;                         /** words counted */
+};
+
+/**
+ * @brief   function prototype
+ */
+size_t
+packedDecode(uint64_t key,
+             char* word);
+
+/**
+ * @brief   function prototype
+ */
+bool
+packedEncode(const char* word,
+             uint64_t* key);
+
+/**
+ * @brief   function prototype
+ */
+int
+packedFree(Packed* packed);
+
+/**
+ * @brief   function prototype
+ */
+int
+packedInsert(Packed* packed,
+             uint64_t key);
+
+/**
+ * @brief   function prototype
+ */
+int
+packedMerge(Packed* packed,
+            Trie* trie,
+            TrieTopFunc* func,
+            void* argument);
+
+/**
+ * @brief   function prototype
+ */
+Packed*
+packedNew(void);
+
+/**
+ * @brief   function prototype
+ */
+int
+packedTop(Packed* packed,
+          const char* prefix,
+          uint32_t count,
+          TrieTopFunc* func,
+          void* argument);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,426 @@
+/**
+ * @file page.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for huge page allocation
+ *
+ * The nodes of the tries are taken from regions of whole 2 MiB pages, reserved
+ * huge pages when the system has them and transparent huge pages otherwise.
+ * The kernel decides which pages a region actually gets, so the report asks
+ * it back through /proc/self/smaps rather than trusting the request.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <page.h>
+
+/**
+ * @brief   lock protecting the regions and the totals
+ */
+static pthread_mutex_t pageLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief   the regions currently mapped
+ */
+static PageRegion* pageRegions = NULL;
+
+/**
+ * @brief   measure the regions as they are released, for the report
+ */
+static bool pageReporting = false;
+
+/**
+ * @brief   bytes mapped so far, by the kind of pages requested
+ */
+static uint64_t pageMapped[PAGE_KINDS];
+
+/**
+ * @brief   resident bytes of the released regions
+ */
+static uint64_t pageResident = 0;
+
+/**
+ * @brief   resident bytes of the released regions on transparent huge pages
+ */
+static uint64_t pageTransparent = 0;
+
+/*
+ * function prototypes
+ */
+static int
+pageListRead(const char* path,
+             unsigned long* mask);
+
+static void
+pageReport(void);
+
+static int
+pageScan(const PageRegion* region,
+         uint64_t* resident,
+         uint64_t* huge);
+
+/**
+ * @brief   map a region of whole huge pages
+ * @details reserved huge pages are tried first, then base pages the kernel
+ *          is asked to back with transparent huge pages;  The region is not
+ *          touched, so its pages are placed on the NUMA node of the thread
+ *          which touches them first
+ * @param   size the bytes needed
+ * @param   mapped the bytes of the region, the size rounded up to whole
+ *          huge pages
+ * @return  a pointer to the region, NULL if it could not be mapped
+ */
+void*
+pageAlloc(size_t size,
+          size_t* mapped)
+{
+
+    size_t bytes = (size + PAGE_HUGE_SIZE - 1) & ~((size_t) PAGE_HUGE_SIZE - 1);
+    PageRegion* region = malloc(sizeof(*region));
+
+    if (!region) {
+        return (NULL);
+    }
+
+    region->size = bytes;
+    region->kind = PAGE_HUGETLB;
+    region->address = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+                           | (PAGE_HUGE_SHIFT << MAP_HUGE_SHIFT), -1, 0);
+
+    /*
+     * Without reserved huge pages the region is mapped one huge page too
+     * large, so that it can be trimmed to start on a huge page boundary.
+     */
+    if (region->address == MAP_FAILED) {
+
+        char* base = mmap(NULL, bytes + PAGE_HUGE_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (base == MAP_FAILED) {
+            free(region);
+            return (NULL);
+        }
+
+        size_t head = -(uintptr_t) base & (PAGE_HUGE_SIZE - 1);
+
+        if (head != 0) {
+            munmap(base, head);
+        }
+
+        munmap(base + head + bytes, PAGE_HUGE_SIZE - head);
+
+        region->address = base + head;
+        region->kind = (madvise(region->address, bytes, MADV_HUGEPAGE) == 0)
+                       ? PAGE_TRANSPARENT : PAGE_BASE;
+
+    }
+
+    pthread_mutex_lock(&pageLock);
+
+    region->next = pageRegions;
+    pageRegions = region;
+    pageMapped[region->kind] += bytes;
+
+    pthread_mutex_unlock(&pageLock);
+
+    *mapped = bytes;
+
+    return (region->address);
+
+}
+
+/**
+ * @brief   bind the calling thread to the processors of the NUMA node of a
+ *          worker
+ * @details the workers are spread over the online nodes in turn;  Memory
+ *          the thread touches first is then placed on its node
+ * @param   worker the number of the worker
+ * @return  the node the thread is bound to, -1 if the system has a single
+ *          node or the thread could not be bound
+ */
+int
+pageBind(uint32_t worker)
+{
+
+    const uint32_t bits = 8 * sizeof(unsigned long);
+    unsigned long online[PAGE_MASK_WORDS] = { 0 };
+    int nodes = pageListRead("/sys/devices/system/node/online", online);
+
+    if (nodes < 2) {
+        return (-1);
+    }
+
+    uint32_t skip = worker % nodes;
+    int node = -1;
+
+    for (uint32_t i = 0; i < PAGE_CPUS && node == -1; i++) {
+        if ((online[i / bits] & (1UL << (i % bits))) && skip-- == 0) {
+            node = i;
+        }
+    }
+
+    char path[64];
+    unsigned long cpus[PAGE_MASK_WORDS] = { 0 };
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             node);
+
+    if (pageListRead(path, cpus) < 1
+        || syscall(SYS_sched_setaffinity, 0, sizeof(cpus), cpus) == -1) {
+        return (-1);
+    }
+
+    return (node);
+
+}
+
+/**
+ * @brief   unmap a region mapped by pageAlloc()
+ * @param   memory the region
+ * @param   mapped the bytes of the region, as returned by pageAlloc()
+ * @return  0 - success, -1 - failure, the region is unknown
+ */
+int
+pageFree(void* memory,
+         size_t mapped)
+{
+
+    pthread_mutex_lock(&pageLock);
+
+    PageRegion** link = &pageRegions;
+
+    while (*link && (*link)->address != memory) {
+        link = &(*link)->next;
+    }
+
+    PageRegion* region = *link;
+
+    if (region) {
+
+        *link = region->next;
+
+        /* The kernel only tells which pages a region got while mapped. */
+        if (pageReporting && region->kind != PAGE_HUGETLB) {
+            pageScan(region, &pageResident, &pageTransparent);
+        }
+
+    }
+
+    pthread_mutex_unlock(&pageLock);
+
+    if (!region) {
+        return (-1);
+    }
+
+    assert(region->size == mapped);
+
+    munmap(region->address, region->size);
+    free(region);
+
+    return (0);
+
+}
+
+/**
+ * @brief   read a list of numbers and ranges of numbers, such as "0-3,8"
+ *          from sysfs
+ * @param   path the file holding the list
+ * @param   mask the mask of PAGE_CPUS bits receiving the numbers
+ * @return  the number of numbers read, -1 - failure
+ */
+static int
+pageListRead(const char* path,
+             unsigned long* mask)
+{
+
+    const uint32_t bits = 8 * sizeof(unsigned long);
+    FILE* fp = fopen(path, "r");
+
+    if (!fp) {
+        return (-1);
+    }
+
+    int count = 0;
+    unsigned int first;
+    unsigned int last;
+    int separator;
+
+    while (fscanf(fp, "%u", &first) == 1) {
+
+        last = first;
+        separator = fgetc(fp);
+
+        if (separator == '-') {
+            if (fscanf(fp, "%u", &last) != 1) {
+                break;
+            }
+            separator = fgetc(fp);
+        }
+
+        for (unsigned int i = first; i <= last && i < PAGE_CPUS; i++) {
+            mask[i / bits] |= 1UL << (i % bits);
+            count++;
+        }
+
+        if (separator != ',') {
+            break;
+        }
+
+    }
+
+    fclose(fp);
+
+    return (count);
+
+}
+
+/**
+ * @brief   display the pages the regions of this process got
+ * @details called upon exit;  Silent in processes which mapped no region
+ * @param   none
+ * @return  none
+ */
+static void
+pageReport(void)
+{
+
+    pthread_mutex_lock(&pageLock);
+
+    uint64_t resident = pageResident;
+    uint64_t huge = pageTransparent;
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < PAGE_KINDS; i++) {
+        total += pageMapped[i];
+    }
+
+    for (PageRegion* region = pageRegions; region; region = region->next) {
+        if (region->kind != PAGE_HUGETLB) {
+            pageScan(region, &resident, &huge);
+        }
+    }
+
+    pthread_mutex_unlock(&pageLock);
+
+    if (total == 0) {
+        return;
+    }
+
+    fprintf(stderr, "wf: %" PRIu64 " kB mapped for trie nodes: %" PRIu64
+            " kB on reserved %d kB pages, %" PRIu64 " kB on transparent %d kB"
+            " pages, %" PRIu64 " kB on %ld kB pages\n", total / 1024,
+            pageMapped[PAGE_HUGETLB] / 1024, PAGE_HUGE_SIZE / 1024,
+            huge / 1024, PAGE_HUGE_SIZE / 1024, (resident - huge) / 1024,
+            sysconf(_SC_PAGESIZE) / 1024);
+
+}
+
+/**
+ * @brief   display the pages the regions got once this process exits
+ * @param   none
+ * @return  none
+ */
+void
+pageReportAtExit(void)
+{
+
+    pageReporting = true;
+    atexit(pageReport);
+
+}
+
+/**
+ * @brief   add up the resident bytes of a region and those of them on
+ *          transparent huge pages, as the kernel reports them
+ * @details adjacent regions may share a mapping, so each mapping only
+ *          counts up to the bytes it shares with the region
+ * @param   region the region
+ * @param   resident the resident bytes, added to
+ * @param   huge the bytes on transparent huge pages, added to
+ * @return  0 - success, -1 - failure
+ */
+static int
+pageScan(const PageRegion* region,
+         uint64_t* resident,
+         uint64_t* huge)
+{
+
+    FILE* fp = fopen("/proc/self/smaps", "r");
+
+    if (!fp) {
+        return (-1);
+    }
+
+    uintptr_t start = (uintptr_t) region->address;
+    uintptr_t end = start + region->size;
+    uint64_t shared = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), fp)) {
+
+        uintptr_t from;
+        uintptr_t to;
+        uint64_t size;
+
+        if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR, &from, &to) == 2) {
+            from = (from > start) ? from : start;
+            to = (to < end) ? to : end;
+            shared = (from < to) ? to - from : 0;
+        }
+        else if (shared && sscanf(line, "Rss: %" SCNu64, &size) == 1) {
+            *resident += (size * 1024 < shared) ? size * 1024 : shared;
+        }
+        else if (shared
+                 && sscanf(line, "AnonHugePages: %" SCNu64, &size) == 1) {
+            *huge += (size * 1024 < shared) ? size * 1024 : shared;
+        }
+
+    }
+
+    fclose(fp);
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
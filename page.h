@@ -0,0 +1,109 @@
+/**
+ * @file page.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for huge page allocation
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+enum {
+    PAGE_CPUS = 1024,                       /** processors or nodes of a
+                                                mask */
+    PAGE_HUGE_SHIFT = 21,                   /** log2 of the huge page size */
+    PAGE_HUGE_SIZE = 1 << PAGE_HUGE_SHIFT,  /** bytes of a huge page */
+    PAGE_MASK_WORDS = PAGE_CPUS / (8 * sizeof(unsigned long)),
+                                            /** words of a mask */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct PageRegion PageRegion;
+
+/**
+ * @brief   the kinds of pages backing a region
+ */
+typedef enum {
+    PAGE_BASE = 0,      /** base pages, transparent huge pages refused */
+    PAGE_HUGETLB,       /** reserved huge pages, MAP_HUGETLB */
+    PAGE_TRANSPARENT,   /** transparent huge pages, MADV_HUGEPAGE */
+    PAGE_KINDS,
+} PageKind;
+
+/**
+ * @brief   object representing a region mapped by pageAlloc()
+ */
+struct PageRegion {
+    PageRegion* next;   /** next region, NULL for none */
+    char* address;      /** start of the region, huge page aligned */
+    size_t size;        /** bytes of the region, whole huge pages */
+    PageKind kind;      /** pages requested for the region */
+};
+
+/**
+ * @brief   function prototype
+ */
+void*
+pageAlloc(size_t size,
+          size_t* mapped);
+
+/**
+ * @brief   function prototype
+ */
+int
+pageBind(uint32_t worker);
+
+/**
+ * @brief   function prototype
+ */
+int
+pageFree(void* memory,
+         size_t mapped);
+
+/**
+ * @brief   function prototype
+ */
+void
+pageReportAtExit(void);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
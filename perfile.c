@@ -0,0 +1,361 @@
+/**
+ * @file perfile.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for counting many inputs within one process
+ *
+ * Each input is read, filtered and counted by the calling process, without
+ * the pipeline of the squeeze and count jobs.  The trie, the heap and the
+ * output buffer are created once and reused by every input:  The pooled trie
+ * and the heap are emptied in constant time between inputs, so the cost of an
+ * input is the cost of its words
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <count.h>
+#include <counter.h>
+#include <heap.h>
+#include <perfile.h>
+#include <trace.h>
+#include <trie.h>
+#include <writer.h>
+
+/*
+ * forward declarations
+ */
+typedef struct PerFile PerFile;
+
+/**
+ * @brief   object holding the state reused by every input
+ */
+struct PerFile {
+    Trie* trie;         /** words of the input, pooled */
+    Heap* heap;         /** top words of the input */
+    Writer* writer;     /** tagged results of every input */
+    const char* name;   /** name of the input being ranked */
+    char* buffer;       /** read buffer */
+    char* word;         /** word in progress, may span read buffers */
+    size_t size;        /** allocated size of the word in progress */
+    uint64_t words;     /** words counted over every input */
+};
+
+/**
+ * @brief   rank the words of each input on its own, in process - Global
+ */
+bool perFileEnabled = false;
+
+/*
+ * function prototypes
+ */
+static int
+perFileDocument(PerFile* state,
+                const char* name);
+
+static TrieTopFunc perFileDump;
+
+static int
+perFileInsert(PerFile* state,
+              size_t length);
+
+/**
+ * @brief   count and rank the words of many inputs one at a time
+ * @details each result line is tagged with the name of its input and a
+ *          tab;  An input which cannot be read is reported and skipped
+ * @param   names the names of the inputs, "-" for standard input
+ * @param   count the number of names, 0 to read the names from standard
+ *          input one per line
+ * @param   fd the output file descriptor
+ * @return  0 - success, -1 - failure
+ */
+int
+perFileCount(char** names,
+             uint32_t count,
+             int fd)
+{
+
+    PerFile state = {
+        .trie = trieNewPooled(&alphabet, countHugePages),
+        .heap = heapNew(frequencyCount),
+        .writer = writerNew(fd, WRITER_BUFFER_SIZE),
+        .buffer = malloc(PER_FILE_BUFFER_SIZE),
+        .size = 64,
+    };
+
+    state.word = malloc(state.size);
+
+    assert(state.trie && state.heap && state.writer && state.buffer
+           && state.word);
+
+    int status = 0;
+    uint64_t documents = 0;
+
+    if (count != 0) {
+
+        for (uint32_t i = 0; i < count; i++, documents++) {
+            if (perFileDocument(&state, names[i]) == -1) {
+                status = -1;
+            }
+        }
+
+    }
+    else {
+
+        /* The manifest on standard input lists a name per line. */
+        char* line = NULL;
+        size_t size = 0;
+        ssize_t length;
+
+        while ((length = getline(&line, &size, stdin)) != -1) {
+
+            if (length > 0 && line[length - 1] == '\n') {
+                line[--length] = '\0';
+            }
+
+            if (length == 0) {
+                continue;
+            }
+
+            if (perFileDocument(&state, line) == -1) {
+                status = -1;
+            }
+
+            documents++;
+
+        }
+
+        free(line);
+
+        if (ferror(stdin)) {
+            status = -1;
+        }
+
+    }
+
+    if (countStats) {
+        fprintf(stderr, "wf: %" PRIu64 " inputs, %" PRIu64 " words\n",
+                documents, state.words);
+    }
+
+    if (writerFree(state.writer) == -1) {
+        status = -1;
+    }
+
+    /*
+     * Since this is a filter the trie and the heap are left to the
+     * operating system to clean up upon process termination.
+     */
+    free(state.buffer);
+    free(state.word);
+
+    return (status);
+
+}
+
+/**
+ * @brief   count and rank the words of one input, then empty the trie and
+ *          the heap for the next
+ * @param   state the state reused by every input
+ * @param   name the name of the input, "-" for standard input
+ * @return  0 - success, -1 - failure
+ */
+static int
+perFileDocument(PerFile* state,
+                const char* name)
+{
+
+    uint64_t start = traceStart();
+    int fd = (strcmp(name, "-") == 0) ? STDIN_FILENO : open(name, O_RDONLY);
+
+    if (fd == -1) {
+        fprintf(stderr, "wf: cannot open %s: %s\n", name, strerror(errno));
+        return (-1);
+    }
+
+    int status = 0;
+    size_t length = 0;
+    ssize_t count = 0;
+
+    /*
+     * Only the letters of the alphabet are kept, upper case characters
+     * folded onto the lower case letters.  A word may span the boundary
+     * between two read buffers.
+     */
+    while (status == 0
+           && (count = read(fd, state->buffer, PER_FILE_BUFFER_SIZE)) > 0) {
+
+        for (ssize_t i = 0; i < count && status == 0; i++) {
+
+            unsigned char letter = alphabet.fold[(unsigned char)
+                                                 state->buffer[i]];
+
+            if (letter != 0) {
+
+                /* Leave room for the terminator of the word. */
+                if (length + 1 >= state->size) {
+
+                    char* word = realloc(state->word, 2 * state->size);
+
+                    if (!word) {
+                        status = -1;
+                        break;
+                    }
+
+                    state->word = word;
+                    state->size *= 2;
+
+                }
+
+                state->word[length++] = letter;
+
+            }
+
+            else if (length != 0) {
+                status = perFileInsert(state, length);
+                length = 0;
+            }
+
+        }
+
+    }
+
+    if (status == 0 && count == -1) {
+        fprintf(stderr, "wf: cannot read %s: %s\n", name, strerror(errno));
+        status = -1;
+    }
+
+    /* If a valid word was in process count it as well. */
+    if (status == 0 && length != 0) {
+        status = perFileInsert(state, length);
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    state->name = name;
+
+    /* Report the top words with the prefix straight from the trie. */
+    if (status == 0 && frequencyPrefix) {
+        status = trieTop(state->trie, frequencyPrefix, frequencyCount,
+                         perFileDump, state);
+    }
+
+    else if (status == 0) {
+
+        heapSort(state->heap);
+
+        for (uint32_t i = 0; i < state->heap->count && status == 0; i++) {
+            status = perFileDump(state, state->heap->words->base
+                                        + state->heap->vector[i].word,
+                                 state->heap->vector[i].frequency);
+        }
+
+    }
+
+    heapReset(state->heap);
+    trieReset(state->trie);
+
+    traceSpan("document", start);
+
+    return (status);
+
+}
+
+/**
+ * @brief   write out a word of the input being ranked, tagged with its name
+ * @param   argument the state reused by every input
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+perFileDump(void* argument,
+            const char* word,
+            uint64_t frequency)
+{
+
+    PerFile* state = argument;
+
+    writerWrite(state->writer, state->name, strlen(state->name));
+    writerWrite(state->writer, "\t", 1);
+    writerUnsigned(state->writer, frequency);
+    writerWrite(state->writer, " ", 1);
+    writerWrite(state->writer, word, strlen(word));
+
+    return (writerWrite(state->writer, "\n", 1));
+
+}
+
+/**
+ * @brief   count the word in progress
+ * @param   state the state reused by every input
+ * @param   length the length of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+perFileInsert(PerFile* state,
+              size_t length)
+{
+
+    state->word[length] = '\0';
+
+    TrieNode* node = trieInsert(state->trie, state->word);
+
+    if (!node) {
+        return (-1);
+    }
+
+    state->words++;
+
+    /* Prefix queries are answered from the trie once it is complete. */
+    if (!frequencyPrefix) {
+        heapInsert(state->heap, node, state->word,
+                   counterValue(&state->trie->wide, node->frequency));
+    }
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
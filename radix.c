@@ -0,0 +1,509 @@
+/**
+ * @file radix.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the path-compressed radix tree object
+ *
+ * Each node holds the label of the edge leading to it rather than a single
+ * letter, so a chain of nodes with one child each collapses into one node.
+ * Short labels are stored inline in the node and long labels in an arena.
+ * An edge is split where an inserted word leaves its label.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <arena.h>
+#include <radix.h>
+
+/*
+ * function prototypes
+ */
+static const char*
+radixLabel(const Radix* radix,
+           const RadixNode* node);
+
+static int
+radixLabelSet(Radix* radix,
+              RadixNode* node,
+              const char* text,
+              uint32_t length);
+
+static void
+radixNodeFree(Radix* radix,
+              RadixNode* node);
+
+static RadixNode*
+radixNodeNew(Radix* radix);
+
+/**
+ * @brief   add a number of occurrences of a word to a radix tree
+ * @details the word follows the edges whose labels it matches;  Where it
+ *          leaves the middle of a label the edge is split by a new node,
+ *          and the rest of the word becomes the label of a new leaf
+ * @param   radix the radix tree
+ * @param   word pointer to the word to be added, in lower case
+ * @param   count the number of occurrences, at least 1
+ * @return  0 - success, -1 - failure, a node could not be allocated or the
+ *          frequency could not be promoted
+ */
+int
+radixAdd(Radix* radix,
+         const char* word,
+         uint64_t count)
+{
+
+    RadixNode* node = radix->root;
+
+    for (;;) {
+
+        if (*word == '\0') {
+            return (counterAdd(&radix->wide, &node->frequency, count));
+        }
+
+        RadixNode** edge = &node->child[alphabetIndex(&alphabet, *word)];
+        RadixNode* child = *edge;
+
+        /* No edge starts with the letter, the rest of the word is a leaf. */
+        if (!child) {
+
+            child = radixNodeNew(radix);
+
+            if (!child || radixLabelSet(radix, child, word,
+                                        strlen(word)) == -1) {
+                free(child);
+                return (-1);
+            }
+
+            child->frequency = 0;
+            *edge = child;
+
+            return (counterAdd(&radix->wide, &child->frequency, count));
+
+        }
+
+        const char* label = radixLabel(radix, child);
+        uint32_t common = 1;
+
+        while (common < child->length && word[common] == label[common]) {
+            common++;
+        }
+
+        /* The whole label matched, continue below the child. */
+        if (common == child->length) {
+            node = child;
+            word += common;
+            continue;
+        }
+
+        /*
+         * Split the edge.  The new node takes the common part of the label
+         * and the child keeps the rest.  A long label shares its arena copy
+         * with both parts while they remain long.
+         */
+        RadixNode* split = radixNodeNew(radix);
+
+        if (!split) {
+            return (-1);
+        }
+
+        if (common <= RADIX_INLINE) {
+            memcpy(split->label.text, label, common);
+        }
+        else {
+            split->label.offset = child->label.offset;
+        }
+
+        split->length = common;
+
+        uint32_t rest = child->length - common;
+
+        if (rest <= RADIX_INLINE) {
+            memmove(child->label.text, label + common, rest);
+        }
+        else {
+            child->label.offset += common;
+        }
+
+        child->length = rest;
+
+        split->child[alphabetIndex(&alphabet, *radixLabel(radix, child))] = child;
+        *edge = split;
+
+        node = split;
+        word += common;
+
+    }
+
+}
+
+/**
+ * @brief   release a radix tree object and all of its nodes
+ * @param   radix the radix tree to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+radixFree(Radix* radix)
+{
+
+    radixNodeFree(radix, radix->root);
+    arenaFree(radix->labels);
+    counterFree(&radix->wide);
+    free(radix);
+
+    return (0);
+
+}
+
+/**
+ * @brief   insert a word into a radix tree
+ * @param   radix the radix tree
+ * @param   word pointer to the word to be inserted, in lower case
+ * @return  0 - success, -1 - failure, a node could not be allocated or the
+ *          frequency could not be promoted
+ */
+int
+radixInsert(Radix* radix,
+            const char* word)
+{
+
+    return (radixAdd(radix, word, 1));
+
+}
+
+/**
+ * @brief   get the label of the edge leading to a node
+ * @param   radix the radix tree holding the long labels
+ * @param   node the node
+ * @return  a pointer to the label, which is not null terminated
+ */
+static const char*
+radixLabel(const Radix* radix,
+           const RadixNode* node)
+{
+
+    if (node->length <= RADIX_INLINE) {
+        return (node->label.text);
+    }
+
+    return (radix->labels->base + node->label.offset);
+
+}
+
+/**
+ * @brief   store the label of the edge leading to a node
+ * @param   radix the radix tree holding the long labels
+ * @param   node the node
+ * @param   text the label
+ * @param   length the length of the label
+ * @return  0 - success, -1 - failure
+ */
+static int
+radixLabelSet(Radix* radix,
+              RadixNode* node,
+              const char* text,
+              uint32_t length)
+{
+
+    node->length = length;
+
+    if (length <= RADIX_INLINE) {
+        memcpy(node->label.text, text, length);
+        return (0);
+    }
+
+    node->label.offset = arenaAppend(radix->labels, text, length);
+
+    return ((node->label.offset == 0) ? -1 : 0);
+
+}
+
+/**
+ * @brief   allocate a new, empty radix tree object
+ * @param   none
+ * @return  a pointer to the newly allocated radix tree object, NULL if
+ *          memory could not be allocated
+ */
+Radix*
+radixNew(void)
+{
+
+    Radix* radix;
+
+    radix = calloc(1, sizeof(*radix));
+    if (!radix) {
+        return (NULL);
+    }
+
+    radix->nodes = 0;
+    radix->nodeSize = sizeof(RadixNode) + alphabet.size * sizeof(RadixNode*);
+    radix->root = radixNodeNew(radix);
+    radix->labels = arenaNew(4096);
+
+    if (!radix->root || !radix->labels) {
+        free(radix->root);
+        if (radix->labels) {
+            arenaFree(radix->labels);
+        }
+        free(radix);
+        return (NULL);
+    }
+
+    return (radix);
+
+}
+
+/**
+ * @brief   release a subtree of radix tree nodes
+ * @details the nodes waiting to be released are chained through their
+ *          labels, which are no longer needed, so no recursion or extra
+ *          memory is used however deep the subtree is
+ * @param   radix the radix tree owning the nodes
+ * @param   node the root of the subtree to be released
+ * @return  none
+ */
+static void
+radixNodeFree(Radix* radix,
+              RadixNode* node)
+{
+
+    RadixNode* pending = NULL;
+
+    while (node) {
+
+        for (uint32_t i = 0; i < alphabet.size; i++) {
+            RadixNode* child = node->child[i];
+            if (child) {
+                memcpy(child->label.text, &pending, sizeof(pending));
+                pending = child;
+            }
+        }
+
+        free(node);
+        radix->nodes--;
+
+        node = pending;
+
+        if (node) {
+            memcpy(&pending, node->label.text, sizeof(pending));
+        }
+
+    }
+
+}
+
+/**
+ * @brief   allocate and initialize a new radix tree node
+ * @param   radix the radix tree the node belongs to
+ * @return  a pointer to a new node with an empty label, NULL if memory
+ *          could not be allocated
+ */
+static RadixNode*
+radixNodeNew(Radix* radix)
+{
+
+    RadixNode* node;
+
+    node = calloc(1, radix->nodeSize);
+    if (!node) {
+        return (NULL);
+    }
+
+    node->frequency = 0;
+    node->length = 0;
+
+    radix->nodes++;
+
+    return (node);
+
+}
+
+/**
+ * @brief   discard every word of a radix tree, keeping the empty root
+ * @param   radix the radix tree
+ * @return  0 - success, -1 - failure
+ */
+int
+radixReset(Radix* radix)
+{
+
+    RadixNode* root = radix->root;
+
+    for (uint32_t i = 0; i < alphabet.size; i++) {
+        if (root->child[i]) {
+            radixNodeFree(radix, root->child[i]);
+            root->child[i] = NULL;
+        }
+    }
+
+    root->frequency = 0;
+
+    arenaReset(radix->labels);
+    counterReset(&radix->wide);
+
+    return (0);
+
+}
+
+/**
+ * @brief   visit every word of a radix tree in lexicographical order
+ * @details the walk keeps its own stack rather than recursing, so words
+ *          of any length can be visited
+ * @param   radix the radix tree
+ * @param   func the function called with each word and its frequency, the
+ *          walk stops when it fails
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure, memory could not be allocated or the
+ *          function failed
+ */
+int
+radixWalk(Radix* radix,
+          TrieTopFunc* func,
+          void* argument)
+{
+
+    /* Per level the node, the next child to visit and the word length. */
+    size_t size = 64;
+    RadixNode** stack = malloc(size * sizeof(*stack));
+    uint8_t* next = malloc(size);
+    size_t* length = malloc(size * sizeof(*length));
+
+    size_t wordSize = 256;
+    char* word = malloc(wordSize);
+
+    int status = (stack && next && length && word) ? 0 : -1;
+    size_t depth = 0;
+
+    if (status == 0) {
+        stack[0] = radix->root;
+        next[0] = 0;
+        length[0] = 0;
+    }
+
+    while (status == 0) {
+
+        RadixNode* node = stack[depth];
+        uint32_t i = next[depth];
+
+        while (i < alphabet.size && !node->child[i]) {
+            i++;
+        }
+
+        /* Every child has been visited, return to the parent. */
+        if (i == alphabet.size) {
+            if (depth == 0) {
+                break;
+            }
+            depth--;
+            continue;
+        }
+
+        next[depth] = i + 1;
+
+        RadixNode* child = node->child[i];
+        size_t end = length[depth] + child->length;
+
+        if (depth + 1 == size) {
+
+            size *= 2;
+
+            RadixNode** grownStack = realloc(stack, size * sizeof(*stack));
+            if (grownStack) {
+                stack = grownStack;
+            }
+
+            uint8_t* grownNext = realloc(next, size);
+            if (grownNext) {
+                next = grownNext;
+            }
+
+            size_t* grownLength = realloc(length, size * sizeof(*length));
+            if (grownLength) {
+                length = grownLength;
+            }
+
+            if (!grownStack || !grownNext || !grownLength) {
+                status = -1;
+                break;
+            }
+
+        }
+
+        if (end + 1 > wordSize) {
+
+            char* grown = realloc(word, 2 * (end + 1));
+
+            if (!grown) {
+                status = -1;
+                break;
+            }
+
+            word = grown;
+            wordSize = 2 * (end + 1);
+
+        }
+
+        memcpy(word + length[depth], radixLabel(radix, child), child->length);
+
+        depth++;
+        stack[depth] = child;
+        next[depth] = 0;
+        length[depth] = end;
+
+        if (child->frequency != 0) {
+            word[end] = '\0';
+            status = func(argument, word,
+                          counterValue(&radix->wide, child->frequency));
+        }
+
+    }
+
+    free(stack);
+    free(next);
+    free(length);
+    free(word);
+
+    return (status);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,130 @@
+/**
+ * @file radix.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the path-compressed radix tree object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+#include <trie.h>
+
+enum {
+    RADIX_INLINE = 16,                      /** longest inline edge label */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Radix Radix;
+typedef struct RadixNode RadixNode;
+
+/**
+ * @brief   object representing a radix tree node and the edge leading to it
+ */
+struct RadixNode {
+    uint32_t frequency;                     /** word frequency, see Counter */
+    uint32_t length;                        /** length of the edge label */
+    union {
+        char text[RADIX_INLINE];            /** label of a short edge */
+        uint32_t offset;                    /** label offset in the arena */
+    } label;
+    RadixNode* child[];                     /** child nodes by first letter,
+                                                one per letter of the
+                                                alphabet */
+};
+
+/**
+ * @brief   object representing a radix tree
+ */
+struct Radix {
+    RadixNode* root;                        /** root node, empty label */
+    size_t nodes;                           /** number of nodes allocated */
+    size_t nodeSize;                        /** bytes of a node, with one
+                                                child per letter */
+    Arena* labels;                          /** labels of the long edges */
+    Counter wide;                           /** frequencies beyond 31 bits */
+};
+
+/**
+ * @brief   function prototype
+ */
+int
+radixAdd(Radix* radix,
+         const char* word,
+         uint64_t count);
+
+/**
+ * @brief   function prototype
+ */
+int
+radixFree(Radix* radix);
+
+/**
+ * @brief   function prototype
+ */
+int
+radixInsert(Radix* radix,
+            const char* word);
+
+/**
+ * @brief   function prototype
+ */
+Radix*
+radixNew(void);
+
+/**
+ * @brief   function prototype
+ */
+int
+radixReset(Radix* radix);
+
+/**
+ * @brief   function prototype
+ */
+int
+radixWalk(Radix* radix,
+          TrieTopFunc* func,
+          void* argument);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,319 @@
+/**
+ * @file rank.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the full vocabulary ranking
+ *
+ * The words arrive in lexicographical order, so taking them in reverse order
+ * and sorting stably by frequency gives the reported order, ties in reverse
+ * lexicographical order.  Most words have a low frequency, those are placed
+ * by a counting sort;  The few words above RANK_DENSE are ordered by a least
+ * significant digit radix sort.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <arena.h>
+#include <rank.h>
+#include <writer.h>
+
+/*
+ * function prototypes
+ */
+static int
+rankRadix(const Rank* rank,
+          uint32_t* vector,
+          uint32_t count);
+
+/**
+ * @brief   add a word to be ranked
+ * @details the words must be added in lexicographical order, as produced
+ *          by trieWalk() or spillMerge()
+ * @param   argument the rank object
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+int
+rankAdd(void* argument,
+        const char* word,
+        uint64_t frequency)
+{
+
+    Rank* rank = argument;
+
+    if (rank->count == rank->size) {
+
+        if (rank->size > UINT32_MAX / 2) {
+            return (-1);
+        }
+
+        uint32_t size = rank->size ? 2 * rank->size : 4096;
+        RankEntry* vector = realloc(rank->vector, size * sizeof(*vector));
+
+        if (!vector) {
+            return (-1);
+        }
+
+        rank->vector = vector;
+        rank->size = size;
+
+    }
+
+    uint32_t offset = arenaAppend(rank->words, word, strlen(word));
+
+    if (offset == 0) {
+        return (-1);
+    }
+
+    rank->vector[rank->count].word = offset;
+    rank->vector[rank->count].frequency = frequency;
+    rank->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   display every word with its frequency in ranked order
+ * @param   rank the rank object
+ * @param   fd the output file descriptor
+ * @return  0 - success, -1 - failure
+ */
+int
+rankDump(Rank* rank,
+         int fd)
+{
+
+    uint32_t* order = malloc((rank->count ? rank->count : 1) * sizeof(*order));
+    uint32_t* start = calloc(RANK_DENSE, sizeof(*start));
+    Writer* writer = writerNew(fd, WRITER_BUFFER_SIZE);
+
+    int status = (order && start && writer) ? 0 : -1;
+
+    uint32_t tail = 0;
+
+    /* Count the dense frequencies, gather the tail in reverse order. */
+    for (uint32_t i = rank->count; status == 0 && i-- > 0; ) {
+
+        uint64_t frequency = rank->vector[i].frequency;
+
+        if (frequency < RANK_DENSE) {
+            start[frequency]++;
+        }
+        else {
+            order[tail++] = i;
+        }
+
+    }
+
+    if (status == 0) {
+        status = rankRadix(rank, order, tail);
+    }
+
+    /* Turn the counts into the first position of each frequency. */
+    uint32_t position = tail;
+
+    for (uint32_t frequency = RANK_DENSE; status == 0 && frequency-- > 0; ) {
+        uint32_t count = start[frequency];
+        start[frequency] = position;
+        position += count;
+    }
+
+    for (uint32_t i = rank->count; status == 0 && i-- > 0; ) {
+
+        uint64_t frequency = rank->vector[i].frequency;
+
+        if (frequency < RANK_DENSE) {
+            order[start[frequency]++] = i;
+        }
+
+    }
+
+    for (uint32_t i = 0; status == 0 && i < rank->count; i++) {
+
+        const RankEntry* entry = &rank->vector[order[i]];
+        const char* word = rank->words->base + entry->word;
+
+        writerUnsigned(writer, entry->frequency);
+        writerWrite(writer, " ", 1);
+        writerWrite(writer, word, strlen(word));
+
+        if (writerWrite(writer, "\n", 1) == -1) {
+            status = -1;
+        }
+
+    }
+
+    if (writer && writerFree(writer) == -1) {
+        status = -1;
+    }
+
+    free(order);
+    free(start);
+
+    return (status);
+
+}
+
+/**
+ * @brief   release a rank object
+ * @param   rank the rank object to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+rankFree(Rank* rank)
+{
+
+    arenaFree(rank->words);
+    free(rank->vector);
+    free(rank);
+
+    return (0);
+
+}
+
+/**
+ * @brief   allocate a new, empty rank object
+ * @param   none
+ * @return  a pointer to the newly allocated rank object, NULL if memory
+ *          could not be allocated
+ */
+Rank*
+rankNew(void)
+{
+
+    Rank* rank;
+
+    rank = calloc(1, sizeof(*rank));
+    if (!rank) {
+        return (NULL);
+    }
+
+    rank->words = arenaNew(65536);
+
+    if (!rank->words) {
+        free(rank);
+        return (NULL);
+    }
+
+    rank->count = 0;
+    rank->size = 0;
+    rank->vector = NULL;
+
+    return (rank);
+
+}
+
+/**
+ * @brief   sort words by descending frequency, keeping the order of ties
+ * @details a stable least significant digit radix sort, eight bits a
+ *          pass, of the complemented frequency;  Passes in which every
+ *          word has the same digit are skipped
+ * @param   rank the rank object holding the words
+ * @param   vector the indices of the words to be sorted
+ * @param   count the number of indices
+ * @return  0 - success, -1 - failure
+ */
+static int
+rankRadix(const Rank* rank,
+          uint32_t* vector,
+          uint32_t count)
+{
+
+    if (count < 2) {
+        return (0);
+    }
+
+    uint32_t* scratch = malloc(count * sizeof(*scratch));
+
+    if (!scratch) {
+        return (-1);
+    }
+
+    uint32_t* from = vector;
+    uint32_t* to = scratch;
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+
+        uint32_t bucket[256] = { 0 };
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t key = ~rank->vector[from[i]].frequency;
+            bucket[(key >> shift) & 0xff]++;
+        }
+
+        if (bucket[(~rank->vector[from[0]].frequency >> shift) & 0xff]
+            == count) {
+            continue;
+        }
+
+        uint32_t position = 0;
+
+        for (uint32_t digit = 0; digit < 256; digit++) {
+            uint32_t size = bucket[digit];
+            bucket[digit] = position;
+            position += size;
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t key = ~rank->vector[from[i]].frequency;
+            to[bucket[(key >> shift) & 0xff]++] = from[i];
+        }
+
+        uint32_t* swap = from;
+        from = to;
+        to = swap;
+
+    }
+
+    if (from != vector) {
+        memcpy(vector, from, count * sizeof(*vector));
+    }
+
+    free(scratch);
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
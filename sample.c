@@ -0,0 +1,418 @@
+/**
+ * @file sample.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for sampled frequency estimation
+ *
+ * The input is mapped and counted a block at a time, visiting the blocks in
+ * random order without replacement.  Each block is extended to word
+ * boundaries so that every word is counted by the block in which it starts,
+ * and sampling every block gives the exact counts.  Sampling stops once the
+ * ranking of the top words has not changed for a number of rounds.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <libwf.h>
+#include <sample.h>
+
+/**
+ * @brief   rounds the ranking must be stable before sampling stops, 0 for
+ *          an exact count - Global
+ */
+uint32_t sampleRounds = 0;
+
+/**
+ * @brief   object representing the mapped input being sampled
+ */
+typedef struct Sample {
+    const char* data;   /** mapped input */
+    size_t size;        /** size of the input */
+    uint32_t blocks;    /** number of blocks within the input */
+    uint32_t* order;    /** block numbers, the sampled ones first */
+    uint32_t sampled;   /** number of blocks sampled */
+} Sample;
+
+/*
+ * function prototypes
+ */
+static int
+sampleFeed(const Sample* input,
+           WfContext* ctx,
+           uint32_t block);
+
+static uint64_t
+sampleRandom(uint64_t* state);
+
+static int
+sampleRanking(WfEntry* top,
+              int count,
+              char** ranking,
+              size_t* size);
+
+static int
+sampleReport(const Sample* input,
+             WfEntry* top,
+             int count,
+             FILE* ofp);
+
+/**
+ * @brief   estimate the frequencies of the top words from a sample of the
+ *          blocks of a file
+ * @param   fd the file descriptor of a regular file
+ * @param   ofp the output stream for the estimates
+ * @return  0 - success, -1 - failure
+ */
+int
+sample(int fd,
+       FILE* ofp)
+{
+
+    struct stat info;
+
+    if (fstat(fd, &info) == -1 || !S_ISREG(info.st_mode)) {
+        fprintf(stderr, "wf: --sample needs a regular file\n");
+        return (-1);
+    }
+
+    if (info.st_size == 0) {
+        return (0);
+    }
+
+    Sample input = {
+        .size = info.st_size,
+        .blocks = (info.st_size + SAMPLE_BLOCK_SIZE - 1) / SAMPLE_BLOCK_SIZE,
+        .sampled = 0,
+    };
+
+    void* data = mmap(NULL, input.size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "wf: cannot map the input: %s\n", strerror(errno));
+        return (-1);
+    }
+
+    /* Blocks are visited in random order, read-ahead would be wasted. */
+    madvise(data, input.size, MADV_RANDOM);
+    input.data = data;
+
+    input.order = malloc(input.blocks * sizeof(*input.order));
+    WfEntry* top = calloc(frequencyCount, sizeof(*top));
+
+    /* The blocks are split into words by the command line alphabet. */
+    WfOptions options = { .alphabet = alphabetLetters };
+    WfContext* ctx = wf_new(&options);
+
+    char* ranking[2] = { NULL, NULL };
+    size_t size[2] = { 0, 0 };
+
+    int status = (input.order && top && ctx) ? 0 : -1;
+    int count = 0;
+
+    for (uint32_t i = 0; status == 0 && i < input.blocks; i++) {
+        input.order[i] = i;
+    }
+
+    /* A fixed seed keeps the estimates of a file reproducible. */
+    uint64_t state = 0x9e3779b97f4a7c15ULL ^ input.size;
+    uint32_t stable = 0;
+    uint32_t rounds = 0;
+
+    while (status == 0 && input.sampled < input.blocks
+           && stable < sampleRounds) {
+
+        for (uint32_t i = 0;
+             i < SAMPLE_ROUND && input.sampled < input.blocks && status == 0;
+             i++) {
+
+            /* Choose one of the blocks not yet sampled. */
+            uint32_t pick = input.sampled
+                            + sampleRandom(&state)
+                              % (input.blocks - input.sampled);
+            uint32_t block = input.order[pick];
+
+            input.order[pick] = input.order[input.sampled];
+            input.order[input.sampled++] = block;
+
+            status = sampleFeed(&input, ctx, block);
+
+        }
+
+        if (status == -1) {
+            break;
+        }
+
+        rounds++;
+
+        count = wf_prefix(ctx, frequencyPrefix ? frequencyPrefix : "",
+                          frequencyCount, top);
+
+        if (count == -1
+            || sampleRanking(top, count, &ranking[rounds % 2],
+                             &size[rounds % 2]) == -1) {
+            status = -1;
+            break;
+        }
+
+        /* The ranking of this round matches the previous round. */
+        if (count != 0 && ranking[(rounds + 1) % 2]
+            && strcmp(ranking[0], ranking[1]) == 0) {
+            stable++;
+        }
+        else {
+            stable = 0;
+        }
+
+    }
+
+    if (status == 0) {
+        fprintf(stderr, "wf: sampled %u of %u blocks (%.1f%%) in %u rounds\n",
+                input.sampled, input.blocks,
+                100.0 * input.sampled / input.blocks, rounds);
+        status = sampleReport(&input, top, count, ofp);
+    }
+
+    free(ranking[0]);
+    free(ranking[1]);
+    wf_free(ctx);
+    free(top);
+    free(input.order);
+    munmap(data, input.size);
+
+    return (status);
+
+}
+
+/**
+ * @brief   count the words starting within a block
+ * @details a word crossing into the block from the one before is left to
+ *          that block, and a word crossing out of the block is followed to
+ *          its end
+ * @param   input the mapped input
+ * @param   ctx the context counting the words
+ * @param   block the number of the block
+ * @return  0 - success, -1 - failure
+ */
+static int
+sampleFeed(const Sample* input,
+           WfContext* ctx,
+           uint32_t block)
+{
+
+    const unsigned char* data = (const unsigned char*) input->data;
+    size_t start = (size_t) block * SAMPLE_BLOCK_SIZE;
+    size_t end = start + SAMPLE_BLOCK_SIZE;
+
+    if (end > input->size) {
+        end = input->size;
+    }
+
+    if (start > 0 && alphabet.fold[data[start - 1]]) {
+        while (start < end && alphabet.fold[data[start]]) {
+            start++;
+        }
+    }
+
+    if (start < end) {
+        while (end < input->size && alphabet.fold[data[end - 1]]
+               && alphabet.fold[data[end]]) {
+            end++;
+        }
+    }
+
+    if (wf_feed(ctx, input->data + start, end - start) == -1) {
+        return (-1);
+    }
+
+    return (wf_flush(ctx));
+
+}
+
+/**
+ * @brief   generate a pseudo-random number (xorshift64*)
+ * @param   state the generator state, updated
+ * @return  the next pseudo-random number
+ */
+static uint64_t
+sampleRandom(uint64_t* state)
+{
+
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return (*state * 0x2545f4914f6cdd1dULL);
+
+}
+
+/**
+ * @brief   record the words of a ranking, in order, as a single string
+ * @param   top the ranked entries
+ * @param   count the number of entries
+ * @param   ranking the string receiving the words, grown as needed
+ * @param   size the allocated size of the string
+ * @return  0 - success, -1 - failure
+ */
+static int
+sampleRanking(WfEntry* top,
+              int count,
+              char** ranking,
+              size_t* size)
+{
+
+    size_t length = 1;
+
+    for (int i = 0; i < count; i++) {
+        length += strlen(top[i].word) + 1;
+    }
+
+    if (length > *size) {
+
+        char* grown = realloc(*ranking, length);
+
+        if (!grown) {
+            return (-1);
+        }
+
+        *ranking = grown;
+        *size = length;
+
+    }
+
+    char* out = *ranking;
+
+    for (int i = 0; i < count; i++) {
+        size_t word = strlen(top[i].word);
+        memcpy(out, top[i].word, word);
+        out += word;
+        *out++ = '\n';
+    }
+
+    *out = '\0';
+
+    return (0);
+
+}
+
+/**
+ * @brief   display the estimated frequencies with 95% confidence intervals
+ * @details the sampled blocks are counted again one at a time for the
+ *          top words, and the spread of the per-block counts gives the
+ *          standard error of the estimated total, corrected for sampling
+ *          without replacement;  The interval shrinks to the exact count
+ *          once every block has been sampled
+ * @param   input the sampled input
+ * @param   top the ranked entries of the sample
+ * @param   count the number of entries
+ * @param   ofp the output stream for the estimates
+ * @return  0 - success, -1 - failure
+ */
+static int
+sampleReport(const Sample* input,
+             WfEntry* top,
+             int count,
+             FILE* ofp)
+{
+
+    double* sum = calloc(count ? count : 1, sizeof(*sum));
+    double* squares = calloc(count ? count : 1, sizeof(*squares));
+    WfOptions options = { .alphabet = alphabetLetters };
+    WfContext* block = wf_new(&options);
+
+    int status = (sum && squares && block) ? 0 : -1;
+    uint32_t n = input->sampled;
+
+    for (uint32_t i = 0; status == 0 && n < input->blocks && i < n; i++) {
+
+        if (wf_reset(block) == -1
+            || sampleFeed(input, block, input->order[i]) == -1) {
+            status = -1;
+            break;
+        }
+
+        for (int k = 0; k < count; k++) {
+            double c = wf_count(block, top[k].word);
+            sum[k] += c;
+            squares[k] += c * c;
+        }
+
+    }
+
+    double fraction = (double) n / input->blocks;
+
+    for (int k = 0; status == 0 && k < count; k++) {
+
+        uint64_t observed = top[k].frequency;
+        double estimate = observed / fraction;
+        double error = 0;
+
+        if (n < input->blocks && n > 1) {
+            double mean = sum[k] / n;
+            double variance = (squares[k] - n * mean * mean) / (n - 1);
+            error = input->blocks
+                    * sqrt((1 - fraction) * (variance > 0 ? variance : 0) / n);
+        }
+
+        double low = estimate - 1.96 * error;
+        double high = estimate + 1.96 * error;
+
+        /* Every sampled occurrence is certain. */
+        if (low < observed) {
+            low = observed;
+        }
+
+        fprintf(ofp, "%" PRIu64 " %s [%" PRIu64 ", %" PRIu64 "]\n",
+                (uint64_t) llround(estimate), top[k].word,
+                (uint64_t) llround(low), (uint64_t) llround(high));
+
+    }
+
+    wf_free(block);
+    free(sum);
+    free(squares);
+
+    return (status);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
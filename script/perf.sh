@@ -0,0 +1,213 @@
+#! /usr/bin/env sh
+
+#
+# End-to-end throughput regression gate for wf.
+#
+# Every mode of wf is run against the sample corpora and against larger
+# generated inputs.  Each run is repeated and the median wall time is
+# converted to MB/s and compared with the baseline file.  The gate fails
+# when any throughput falls more than the threshold percentage below its
+# baseline.  The speedup over script/wf.sh on the same input is reported
+# for reference.
+#
+# usage: perf.sh [ -t <PERCENT> ] [ -r <REPEAT> ] [ -w ] <WF> <BASELINE>
+#
+#   -t  allowed regression in percent (default 25)
+#   -r  number of runs per measurement (default 5)
+#   -w  write a new baseline file instead of comparing
+#
+
+threshold=25
+repeat=5
+write=0
+
+while getopts "t:r:w" option; do
+    case $option in
+        t) threshold=$OPTARG ;;
+        r) repeat=$OPTARG ;;
+        w) write=1 ;;
+        *) echo "usage: $0 [ -t <PERCENT> ] [ -r <REPEAT> ] [ -w ] <WF> <BASELINE>" >&2
+           exit 2 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -ne 2 ]; then
+    echo "usage: $0 [ -t <PERCENT> ] [ -r <REPEAT> ] [ -w ] <WF> <BASELINE>" >&2
+    exit 2
+fi
+
+wf=$1
+baseline=$2
+root=$(cd "$(dirname "$0")/.." && pwd)
+
+#
+# The modes of wf to be measured, one set of options per line.  VOCAB
+# stands for a vocabulary file generated below and TRACE for a trace file
+# in the work directory, so that the baseline does not depend on their
+# paths.  The modes reading several files are given pieces of the input,
+# see below.
+#
+modes="--input=uring
+--input=thread
+--input=sync
+--window=100000
+--memory-budget=16M
+--sample
+--all
+--prefix=th
+--engine=radix
+--relayout=hot
+--engine=auto
+--engine=packed
+--df
+--tfidf
+--per-file
+--compare
+--trace=TRACE
+--hapax
+--batch
+--vocab=VOCAB
+--stem
+--huge-pages"
+
+work=$(mktemp -d "${TMPDIR:-/tmp}/wf-perf.XXXXXX")
+trap 'rm -rf "$work"' EXIT INT TERM
+
+#
+# Larger generated inputs: book-scale prose and a high-cardinality
+# vocabulary with a skewed (roughly Zipfian) word distribution.
+#
+for i in 1 2 3 4 5 6 7 8; do
+    cat "$root/sample/warandpeace.input"
+done > "$work/prose.input"
+
+awk 'BEGIN {
+    srand(1)
+    for (v = 0; v < 200000; v++) {
+        n = 2 + int(rand() * 10)
+        w = ""
+        for (c = 0; c < n; c++) {
+            w = w sprintf("%c", 97 + int(rand() * 26))
+        }
+        vocab[v] = w
+    }
+    for (i = 0; i < 4000000; i++) {
+        r = rand()
+        printf "%s%s", vocab[int(200000 * r * r * r)], (i % 16 == 15) ? "\n" : " "
+    }
+}' > "$work/vocab.input"
+
+# The distinct words of a novel, as a closed vocabulary.
+"$wf" --all "$root/sample/warandpeace.input" | awk '{ print $2 }' \
+    > "$work/vocab.words"
+
+inputs="$root/sample/mobydick.input
+$root/sample/warandpeace.input
+$root/sample/large.input
+$work/prose.input
+$work/vocab.input"
+
+#
+# Print the wall time in seconds of running a command "loops" times in
+# succession, discarding its output.
+#
+elapsed() {
+    start=$(date +%s%N)
+    for loop in $(seq "$loops"); do
+        "$@" > /dev/null 2>&1
+    done
+    end=$(date +%s%N)
+    echo "$start $end" | awk '{ printf "%.6f\n", ($2 - $1) / 1e9 }'
+}
+
+#
+# Print the median wall time of running a command "repeat" times.
+#
+median() {
+    for run in $(seq "$repeat"); do
+        elapsed "$@"
+    done | sort -n | awk '{ t[NR] = $1 }
+        END { printf "%.6f\n", (NR % 2) ? t[(NR + 1) / 2] : (t[NR / 2] + t[NR / 2 + 1]) / 2 }'
+}
+
+if [ $write -eq 1 ]; then
+    echo "# input mode MB/s - generated by script/perf.sh -w" > "$work/baseline"
+fi
+
+failed=0
+
+printf "%-20s %-20s %10s %10s %8s %9s\n" input mode MB/s baseline change "vs wf.sh"
+
+echo "$inputs" | while read -r input; do
+
+    name=$(basename "$input" .input)
+    size=$(wc -c < "$input")
+
+    # The shell pipeline is slow, a single run is enough for reference.
+    loops=1
+    reference=$(elapsed sh "$root/script/wf.sh" "$input")
+
+    # Small inputs are run back to back to keep process startup from
+    # dominating the measurement.
+    loops=$(echo "$size" | awk '{ n = int(16e6 / ($1 > 0 ? $1 : 1)); print (n > 1) ? n : 1 }')
+    bytes=$((size * loops))
+    reference=$(echo "$reference $loops" | awk '{ print $1 * $2 }')
+
+    # The same bytes as separate files:  64 KiB pieces as the documents of
+    # --df and --tfidf and the file list of --per-file, two halves for
+    # --compare.
+    rm -f "$work"/piece.* "$work"/half.*
+    split -a 3 -b 65536 "$input" "$work/piece."
+    split -b $(((size + 1) / 2)) "$input" "$work/half."
+
+    echo "$modes" | while read -r mode; do
+
+        case $mode in
+            --df|--tfidf|--per-file) set -- "$work"/piece.* ;;
+            --compare) set -- "$work"/half.* ;;
+            *) set -- "$input" ;;
+        esac
+
+        options=$(echo "$mode" | sed -e "s|VOCAB|$work/vocab.words|" \
+                                     -e "s|TRACE|$work/trace.json|")
+        seconds=$(median "$wf" $options "$@")
+        rate=$(echo "$bytes $seconds" | awk '{ printf "%.2f", ($1 / 1e6) / ($2 > 0 ? $2 : 1e-6) }')
+        speedup=$(echo "$reference $seconds" | awk '{ printf "%.1fx", $1 / ($2 > 0 ? $2 : 1e-6) }')
+
+        if [ $write -eq 1 ]; then
+            echo "$name $mode $rate" >> "$work/baseline"
+            printf "%-20s %-20s %10s %10s %8s %9s\n" "$name" "$mode" "$rate" - - "$speedup"
+            continue
+        fi
+
+        expected=$(awk -v n="$name" -v m="$mode" '$1 == n && $2 == m { print $3 }' "$baseline" 2>/dev/null)
+
+        if [ -z "$expected" ]; then
+            printf "%-20s %-20s %10s %10s %8s %9s\n" "$name" "$mode" "$rate" - new "$speedup"
+            continue
+        fi
+
+        change=$(echo "$rate $expected" | awk '{ printf "%+.1f%%", 100 * ($1 - $2) / $2 }')
+        printf "%-20s %-20s %10s %10s %8s %9s\n" "$name" "$mode" "$rate" "$expected" "$change" "$speedup"
+
+        if echo "$rate $expected $threshold" | awk '{ exit !($1 < $2 * (1 - $3 / 100)) }'; then
+            echo "REGRESSION: $name $mode $rate MB/s is more than $threshold% below $expected MB/s" >&2
+            touch "$work/failed"
+        fi
+
+    done
+
+done
+
+if [ $write -eq 1 ]; then
+    cp "$work/baseline" "$baseline"
+    echo "Baseline written to $baseline"
+    exit 0
+fi
+
+if [ -e "$work/failed" ]; then
+    failed=1
+fi
+
+exit $failed
@@ -0,0 +1,1115 @@
+/**
+ * @file serve.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the word frequency server
+ *
+ * The server keeps counting into one trie for as long as it runs.  Each
+ * connection is served by a thread of its own, and its first line tells a
+ * producer from a reader:
+ *
+ *     FEED                the rest of the connection is text to be counted
+ *     TOP <K>             the K most frequent words
+ *     PREFIX <P> <K>      the K most frequent words starting with P
+ *     COUNT <WORD>        the frequency of a word
+ *
+ * A reader may send any number of queries;  Each reply is a "frequency word"
+ * line per word followed by an empty line, or an "error" line instead.  A
+ * producer is answered with the empty line once its words can be queried.
+ *
+ * Producers take turns at the trie under a lock.  Readers never touch the
+ * trie or the lock:  The words are published every so often as an immutable
+ * snapshot, sorted by word and by rank, which readers pick up with a single
+ * atomic load.  A replaced snapshot is released once every reader has moved
+ * on to a later epoch, so queries never block the producers and producers
+ * never wait for queries
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <arena.h>
+#include <count.h>
+#include <heap.h>
+#include <serve.h>
+#include <trie.h>
+
+/*
+ * forward declarations
+ */
+typedef struct ServeConnection ServeConnection;
+
+/**
+ * @brief   object handing an accepted connection to its thread
+ */
+struct ServeConnection {
+    Serve* server;      /** the server */
+    int fd;             /** the connected socket */
+};
+
+/**
+ * @brief   the socket of the server to count into and query, NULL for
+ *          none - Global
+ */
+const char* serveConnect = NULL;
+
+/**
+ * @brief   the socket to serve on, NULL for none - Global
+ */
+const char* serveSocket = NULL;
+
+/**
+ * @brief   set once the server was asked to stop
+ */
+static volatile sig_atomic_t serveStopped = 0;
+
+/*
+ * function prototypes
+ */
+static int
+serveAnswer(ServeSnapshot* snapshot,
+            char* line,
+            FILE* ofp);
+
+static void*
+serveConnection(void* argument);
+
+static int
+serveFeed(Serve* server,
+          FILE* ifp,
+          FILE* ofp);
+
+static uint32_t
+serveFind(ServeSnapshot* snapshot,
+          const char* word);
+
+static int
+serveFold(const char* word,
+          char* folded,
+          size_t size);
+
+static int
+serveOpen(const char* path,
+          struct sockaddr_un* address);
+
+static int
+servePublish(Serve* server);
+
+static void*
+servePublisher(void* argument);
+
+static int
+serveQuery(Serve* server,
+           char* line,
+           FILE* ifp,
+           FILE* ofp);
+
+static int
+serveRankCompare(const void* a,
+                 const void* b);
+
+static TrieTopFunc serveSnapshotAdd;
+
+static void
+serveSnapshotFree(ServeSnapshot* snapshot);
+
+static ServeSnapshot*
+serveSnapshotNew(Serve* server);
+
+static int
+serveSpawn(void* (*entry)(void*),
+           void* argument);
+
+static void
+serveStop(int signal);
+
+/**
+ * @brief   serve the counted words on a Unix socket until stopped
+ * @param   path the path of the socket, an old socket there is replaced
+ * @return  0 - success, -1 - failure
+ */
+int
+serve(const char* path)
+{
+
+    struct sockaddr_un address;
+
+    if (serveOpen(path, &address) == -1) {
+        return (-1);
+    }
+
+    /* A socket left behind by an earlier server is replaced. */
+    struct stat status;
+
+    if (lstat(path, &status) == 0 && S_ISSOCK(status.st_mode)) {
+        unlink(path);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listener == -1
+        || bind(listener, (struct sockaddr*) &address, sizeof(address)) == -1
+        || listen(listener, SOMAXCONN) == -1) {
+        fprintf(stderr, "wf: cannot serve on %s: %s\n", path,
+                strerror(errno));
+        return (-1);
+    }
+
+    Serve* server = calloc(1, sizeof(*server));
+    assert(server);
+
+    pthread_mutex_init(&server->lock, NULL);
+    server->trie = countTrieNew();
+    server->epoch = 1;
+    server->current = serveSnapshotNew(server);
+    assert(server->trie && server->current);
+
+    /* Stop on the signals, interrupting accept() rather than restarting. */
+    struct sigaction action = { .sa_handler = serveStop };
+
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int result = serveSpawn(servePublisher, server);
+
+    while (result == 0 && !serveStopped) {
+
+        int fd = accept(listener, NULL, NULL);
+
+        if (fd == -1) {
+            if (errno != EINTR && errno != ECONNABORTED) {
+                fprintf(stderr, "wf: cannot accept on %s: %s\n", path,
+                        strerror(errno));
+                result = -1;
+            }
+            continue;
+        }
+
+        ServeConnection* connection = malloc(sizeof(*connection));
+
+        if (!connection) {
+            close(fd);
+            continue;
+        }
+
+        connection->server = server;
+        connection->fd = fd;
+
+        if (serveSpawn(serveConnection, connection) == -1) {
+            free(connection);
+            close(fd);
+        }
+
+    }
+
+    close(listener);
+    unlink(path);
+
+    /*
+     * The connection threads may still be running, the operating system
+     * cleans up the server upon process termination.
+     */
+    return (result);
+
+}
+
+/**
+ * @brief   answer one query from a snapshot
+ * @param   snapshot the snapshot
+ * @param   line the query, split up in place
+ * @param   ofp the output stream of the reply
+ * @return  0 - success, -1 - invalid query or failure
+ */
+static int
+serveAnswer(ServeSnapshot* snapshot,
+            char* line,
+            FILE* ofp)
+{
+
+    char* save;
+    char* command = strtok_r(line, " ", &save);
+    char* first = command ? strtok_r(NULL, " ", &save) : NULL;
+    char* second = first ? strtok_r(NULL, " ", &save) : NULL;
+    char* extra = second ? strtok_r(NULL, " ", &save) : NULL;
+
+    unsigned long count = 0;
+    char* end;
+
+    /* The number of words is the last argument of TOP and PREFIX. */
+    char* number = (command && strcmp(command, "TOP") == 0) ? first : second;
+
+    if (number) {
+        count = strtoul(number, &end, 10);
+        if (*number == '\0' || *end != '\0') {
+            count = 0;
+        }
+    }
+
+    int status = 0;
+
+    if (command && strcmp(command, "TOP") == 0 && first && !second
+        && count != 0) {
+
+        for (uint32_t i = 0; i < snapshot->count && i < count; i++) {
+            fprintf(ofp, "%" PRIu64 " %s\n", snapshot->byRank[i].frequency,
+                    snapshot->text->base + snapshot->byRank[i].word);
+        }
+
+    }
+
+    else if (command && strcmp(command, "PREFIX") == 0 && second && !extra
+             && count != 0) {
+
+        size_t length = strlen(first);
+        char* prefix = malloc(length + 1);
+
+        /* Only the words with the prefix are ranked, through a heap. */
+        if (!prefix) {
+            status = -1;
+        }
+        else if (serveFold(first, prefix, length + 1) == 0) {
+
+            uint32_t i = serveFind(snapshot, prefix);
+            uint32_t last = i;
+
+            while (last < snapshot->count
+                   && strncmp(snapshot->text->base
+                              + snapshot->byWord[last].word,
+                              prefix, length) == 0) {
+                last++;
+            }
+
+            if (last > i) {
+
+                Heap* heap = heapNew((count < last - i) ? count : last - i);
+
+                for (status = heap ? 0 : -1; i < last && status == 0; i++) {
+                    status = heapOffer(heap, snapshot->text->base
+                                             + snapshot->byWord[i].word,
+                                       snapshot->byWord[i].frequency);
+                }
+
+                if (status == 0) {
+                    heapSort(heap);
+                    heapDump(heap, ofp);
+                }
+
+                if (heap) {
+                    heapFree(heap);
+                }
+
+            }
+
+        }
+
+        free(prefix);
+
+    }
+
+    else if (command && strcmp(command, "COUNT") == 0 && first && !second) {
+
+        size_t length = strlen(first);
+        char* word = malloc(length + 1);
+
+        if (!word) {
+            status = -1;
+        }
+        else {
+
+            uint64_t frequency = 0;
+
+            if (serveFold(first, word, length + 1) == 0) {
+
+                uint32_t i = serveFind(snapshot, word);
+
+                if (i < snapshot->count
+                    && strcmp(snapshot->text->base + snapshot->byWord[i].word,
+                              word) == 0) {
+                    frequency = snapshot->byWord[i].frequency;
+                }
+
+            }
+
+            fprintf(ofp, "%" PRIu64 " %s\n", frequency, first);
+
+        }
+
+        free(word);
+
+    }
+
+    else {
+        fprintf(ofp, "error invalid query\n");
+        return (-1);
+    }
+
+    if (status == -1) {
+        fprintf(ofp, "error %s\n", strerror(errno));
+        return (-1);
+    }
+
+    fputc('\n', ofp);
+
+    return (0);
+
+}
+
+/**
+ * @brief   count a file into a server and display its top words
+ * @details the file, if any, is sent to the server first and the query
+ *          waits until the server acknowledged its words;  The top words
+ *          are those of everything the server has counted, limited to the
+ *          prefix when one was given
+ * @param   path the path of the server socket
+ * @param   file the file to be counted, "-" for standard input, NULL for
+ *          none
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+int
+serveClient(const char* path,
+            const char* file,
+            FILE* ofp)
+{
+
+    struct sockaddr_un address;
+
+    if (serveOpen(path, &address) == -1) {
+        return (-1);
+    }
+
+    for (uint32_t round = file ? 0 : 1; round < 2; round++) {
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd == -1
+            || connect(fd, (struct sockaddr*) &address,
+                       sizeof(address)) == -1) {
+            fprintf(stderr, "wf: cannot connect to %s: %s\n", path,
+                    strerror(errno));
+            return (-1);
+        }
+
+        FILE* sfp = fdopen(dup(fd), "w");
+        FILE* rfp = fdopen(fd, "r");
+        int status = (sfp && rfp) ? 0 : -1;
+
+        /* Send the file to be counted, or the query. */
+        if (status == 0 && round == 0) {
+
+            int input = (strcmp(file, "-") == 0) ? STDIN_FILENO
+                                                  : open(file, O_RDONLY);
+
+            if (input == -1) {
+                fprintf(stderr, "wf: cannot open %s: %s\n", file,
+                        strerror(errno));
+                status = -1;
+            }
+            else {
+
+                char buffer[65536];
+                ssize_t length;
+
+                fputs("FEED\n", sfp);
+
+                while ((length = read(input, buffer, sizeof(buffer))) > 0) {
+                    fwrite(buffer, 1, length, sfp);
+                }
+
+                if (length == -1) {
+                    status = -1;
+                }
+
+                if (input != STDIN_FILENO) {
+                    close(input);
+                }
+
+            }
+
+        }
+        else if (status == 0 && frequencyPrefix) {
+            fprintf(sfp, "PREFIX %s %" PRIu32 "\n", frequencyPrefix,
+                    frequencyCount);
+        }
+        else if (status == 0) {
+            fprintf(sfp, "TOP %" PRIu32 "\n", frequencyCount);
+        }
+
+        /* The server replies once it has read everything sent. */
+        if (sfp && fclose(sfp) != 0) {
+            status = -1;
+        }
+
+        shutdown(fd, SHUT_WR);
+
+        /* The reply ends with an empty line, or is an error. */
+        char* line = NULL;
+        size_t size = 0;
+
+        while (status == 0 && getline(&line, &size, rfp) != -1
+               && strcmp(line, "\n") != 0) {
+
+            if (strncmp(line, "error ", 6) == 0) {
+                fprintf(stderr, "wf: %s: %s", path, line);
+                status = -1;
+            }
+            else if (round == 1) {
+                fputs(line, ofp);
+            }
+
+        }
+
+        free(line);
+
+        if (rfp) {
+            fclose(rfp);
+        }
+
+        if (status == -1) {
+            return (-1);
+        }
+
+    }
+
+    return (ferror(ofp) ? -1 : 0);
+
+}
+
+/**
+ * @brief   entry point of the thread serving a connection
+ * @param   argument the accepted connection
+ * @return  NULL
+ */
+static void*
+serveConnection(void* argument)
+{
+
+    ServeConnection* connection = argument;
+    Serve* server = connection->server;
+    int fd = connection->fd;
+
+    free(connection);
+
+    FILE* ifp = fdopen(fd, "r");
+    FILE* ofp = fdopen(dup(fd), "w");
+
+    if (ifp && ofp) {
+
+        char* line = NULL;
+        size_t size = 0;
+        ssize_t length = getline(&line, &size, ifp);
+
+        if (length > 0 && line[length - 1] == '\n') {
+            line[length - 1] = '\0';
+        }
+
+        /* The first line tells a producer from a reader. */
+        if (length == -1) {
+            /* Nothing asked. */
+        }
+        else if (strcmp(line, "FEED") == 0) {
+            serveFeed(server, ifp, ofp);
+        }
+        else {
+            serveQuery(server, line, ifp, ofp);
+        }
+
+        free(line);
+
+    }
+
+    if (ifp) {
+        fclose(ifp);
+    }
+    else {
+        close(fd);
+    }
+
+    if (ofp) {
+        fclose(ofp);
+    }
+
+    return (NULL);
+
+}
+
+/**
+ * @brief   count the text of a producer
+ * @details the text is counted a buffer at a time under the lock;  A word
+ *          split between two buffers is carried over by the connection, so
+ *          producers never mix up each other's words
+ * @param   server the server
+ * @param   ifp the input stream of the text
+ * @param   ofp the output stream of the acknowledgement
+ * @return  0 - success, -1 - failure
+ */
+static int
+serveFeed(Serve* server,
+          FILE* ifp,
+          FILE* ofp)
+{
+
+    char buffer[65536];
+    size_t size = 64;
+    size_t length = 0;
+    char* word = malloc(size);
+    int status = word ? 0 : -1;
+    size_t count;
+
+    do {
+
+        count = fread(buffer, 1, sizeof(buffer), ifp);
+
+        pthread_mutex_lock(&server->lock);
+
+        /* At the end of the text a word in progress ends as well. */
+        for (size_t i = 0; i <= count && status == 0; i++) {
+
+            unsigned char letter = (i < count)
+                                   ? alphabet.fold[(unsigned char) buffer[i]]
+                                   : 0;
+
+            if (letter != 0) {
+
+                /* Leave room for the terminator of the word. */
+                if (length + 1 >= size) {
+                    char* grown = realloc(word, 2 * size);
+                    if (!grown) {
+                        status = -1;
+                        break;
+                    }
+                    word = grown;
+                    size *= 2;
+                }
+
+                word[length++] = letter;
+
+            }
+
+            else if (length != 0 && (i < count || count == 0)) {
+
+                word[length] = '\0';
+                length = 0;
+
+                if (!trieInsert(server->trie, word)) {
+                    status = -1;
+                    break;
+                }
+
+                server->words++;
+                server->dirty = true;
+
+            }
+
+        }
+
+        /* Make the words of the producer visible before acknowledging. */
+        if (count == 0 && status == 0 && server->dirty) {
+            status = servePublish(server);
+        }
+
+        pthread_mutex_unlock(&server->lock);
+
+    } while (count != 0 && status == 0);
+
+    free(word);
+
+    if (status == -1 || ferror(ifp)) {
+        fprintf(ofp, "error %s\n", strerror(errno));
+        return (-1);
+    }
+
+    fputc('\n', ofp);
+
+    return (0);
+
+}
+
+/**
+ * @brief   find the first word of a snapshot not sorting before a word
+ * @param   snapshot the snapshot
+ * @param   word the word
+ * @return  the index of the word within the words in byte order
+ */
+static uint32_t
+serveFind(ServeSnapshot* snapshot,
+          const char* word)
+{
+
+    uint32_t low = 0;
+    uint32_t high = snapshot->count;
+
+    while (low < high) {
+
+        uint32_t middle = low + (high - low) / 2;
+
+        if (strcmp(snapshot->text->base + snapshot->byWord[middle].word,
+                   word) < 0) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+
+    }
+
+    return (low);
+
+}
+
+/**
+ * @brief   fold a word of a query onto the letters of the alphabet
+ * @param   word the word
+ * @param   folded the folded word
+ * @param   size the size of the folded word, including the terminator
+ * @return  0 - success, -1 - the word holds a character which is not a
+ *          letter, so it cannot have been counted
+ */
+static int
+serveFold(const char* word,
+          char* folded,
+          size_t size)
+{
+
+    size_t i;
+
+    for (i = 0; word[i] != '\0' && i + 1 < size; i++) {
+
+        folded[i] = alphabet.fold[(unsigned char) word[i]];
+
+        if (folded[i] == 0) {
+            return (-1);
+        }
+
+    }
+
+    folded[i] = '\0';
+
+    return (0);
+
+}
+
+/**
+ * @brief   fill in the address of a server socket
+ * @param   path the path of the socket
+ * @param   address the address
+ * @return  0 - success, -1 - the path is too long
+ */
+static int
+serveOpen(const char* path,
+          struct sockaddr_un* address)
+{
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "wf: socket path too long: %s\n", path);
+        return (-1);
+    }
+
+    strcpy(address->sun_path, path);
+
+    return (0);
+
+}
+
+/**
+ * @brief   publish a new snapshot of the counted words
+ * @details called with the lock held;  The replaced snapshot is retired
+ *          with the epoch it was current in, and every retired snapshot
+ *          which is older than the epoch of each active reader is released
+ * @param   server the server
+ * @return  0 - success, -1 - failure, the last snapshot stays current
+ */
+static int
+servePublish(Serve* server)
+{
+
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    ServeSnapshot* snapshot = serveSnapshotNew(server);
+
+    if (!snapshot) {
+        return (-1);
+    }
+
+    ServeSnapshot* old = __atomic_exchange_n(&server->current, snapshot,
+                                             __ATOMIC_SEQ_CST);
+
+    old->retired = __atomic_fetch_add(&server->epoch, 1, __ATOMIC_SEQ_CST);
+    old->next = server->retired;
+    server->retired = old;
+    server->dirty = false;
+
+    /* A reader may still use any snapshot current in or after its epoch. */
+    uint64_t oldest = UINT64_MAX;
+
+    for (uint32_t i = 0; i < SERVE_READERS; i++) {
+
+        uint64_t epoch = __atomic_load_n(&server->reader[i].epoch,
+                                         __ATOMIC_SEQ_CST);
+
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+
+    }
+
+    for (ServeSnapshot** link = &server->retired; *link; ) {
+
+        ServeSnapshot* retired = *link;
+
+        if (retired->retired < oldest) {
+            *link = retired->next;
+            serveSnapshotFree(retired);
+        }
+        else {
+            link = &retired->next;
+        }
+
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    server->build = (end.tv_sec - start.tv_sec) * 1e3
+                    + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    if (countStats) {
+        fprintf(stderr, "wf: published %" PRIu32 " words of %" PRIu64
+                " counted in %.1f ms\n", snapshot->count, snapshot->words,
+                server->build);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   entry point of the thread publishing the snapshots
+ * @details a snapshot is published every SERVE_PUBLISH_MS while words are
+ *          being counted, or ten times as long as the last one took to
+ *          build, so that publishing never takes up more than a tenth of
+ *          the time of the producers
+ * @param   argument the server
+ * @return  NULL
+ */
+static void*
+servePublisher(void* argument)
+{
+
+    Serve* server = argument;
+
+    for (;;) {
+
+        pthread_mutex_lock(&server->lock);
+        double interval = 10 * server->build;
+        pthread_mutex_unlock(&server->lock);
+
+        if (interval < SERVE_PUBLISH_MS) {
+            interval = SERVE_PUBLISH_MS;
+        }
+
+        struct timespec delay = {
+            .tv_sec = interval / 1e3,
+            .tv_nsec = fmod(interval, 1e3) * 1e6,
+        };
+
+        nanosleep(&delay, NULL);
+
+        pthread_mutex_lock(&server->lock);
+
+        if (server->dirty) {
+            servePublish(server);
+        }
+
+        pthread_mutex_unlock(&server->lock);
+
+    }
+
+    return (NULL);
+
+}
+
+/**
+ * @brief   answer the queries of a reader
+ * @details each query enters the current epoch before loading the current
+ *          snapshot and leaves it once answered, so the snapshot is not
+ *          released while it is being read
+ * @param   server the server
+ * @param   line the first query
+ * @param   ifp the input stream of the further queries
+ * @param   ofp the output stream of the replies
+ * @return  0 - success, -1 - failure
+ */
+static int
+serveQuery(Serve* server,
+           char* line,
+           FILE* ifp,
+           FILE* ofp)
+{
+
+    ServeReader* reader = NULL;
+
+    for (uint32_t i = 0; i < SERVE_READERS && !reader; i++) {
+
+        bool unused = false;
+
+        if (__atomic_compare_exchange_n(&server->reader[i].used, &unused,
+                                        true, false, __ATOMIC_SEQ_CST,
+                                        __ATOMIC_SEQ_CST)) {
+            reader = &server->reader[i];
+        }
+
+    }
+
+    if (!reader) {
+        fprintf(ofp, "error too many readers\n");
+        return (-1);
+    }
+
+    char* next = NULL;
+    size_t size = 0;
+    ssize_t length;
+
+    do {
+
+        __atomic_store_n(&reader->epoch,
+                         __atomic_load_n(&server->epoch, __ATOMIC_SEQ_CST),
+                         __ATOMIC_SEQ_CST);
+
+        ServeSnapshot* snapshot = __atomic_load_n(&server->current,
+                                                  __ATOMIC_SEQ_CST);
+
+        serveAnswer(snapshot, line, ofp);
+
+        __atomic_store_n(&reader->epoch, 0, __ATOMIC_SEQ_CST);
+
+        if (fflush(ofp) != 0) {
+            break;
+        }
+
+        length = getline(&next, &size, ifp);
+
+        if (length > 0 && next[length - 1] == '\n') {
+            next[length - 1] = '\0';
+        }
+
+        line = next;
+
+    } while (length != -1);
+
+    free(next);
+
+    __atomic_store_n(&reader->used, false, __ATOMIC_SEQ_CST);
+
+    return (0);
+
+}
+
+/**
+ * @brief   order two snapshot words by rank
+ * @details words of equal frequency rank in reverse byte order, their text
+ *          was appended to the arena in byte order
+ * @param   a the first word
+ * @param   b the second word
+ * @return  less than, equal to or greater than zero as the first word
+ *          ranks above, with or below the second
+ */
+static int
+serveRankCompare(const void* a,
+                 const void* b)
+{
+
+    const ServeEntry* first = a;
+    const ServeEntry* second = b;
+
+    if (first->frequency != second->frequency) {
+        return ((first->frequency > second->frequency) ? -1 : 1);
+    }
+
+    return ((first->word > second->word) ? -1 : (first->word < second->word));
+
+}
+
+/**
+ * @brief   add a word of the trie to a snapshot being built
+ * @param   argument the snapshot
+ * @param   word the word
+ * @param   frequency the frequency of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+serveSnapshotAdd(void* argument,
+                 const char* word,
+                 uint64_t frequency)
+{
+
+    ServeSnapshot* snapshot = argument;
+    uint32_t offset = arenaAppend(snapshot->text, word, strlen(word));
+
+    if (offset == 0) {
+        return (-1);
+    }
+
+    snapshot->byWord[snapshot->count++] = (ServeEntry) {
+        .frequency = frequency,
+        .word = offset,
+    };
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a snapshot
+ * @param   snapshot the snapshot to be released
+ * @return  none
+ */
+static void
+serveSnapshotFree(ServeSnapshot* snapshot)
+{
+
+    if (snapshot->text) {
+        arenaFree(snapshot->text);
+    }
+
+    free(snapshot->byWord);
+    free(snapshot->byRank);
+    free(snapshot);
+
+}
+
+/**
+ * @brief   copy the counted words into a new snapshot
+ * @details called with the lock held
+ * @param   server the server
+ * @return  a pointer to the new snapshot, NULL if memory could not be
+ *          allocated
+ */
+static ServeSnapshot*
+serveSnapshotNew(Serve* server)
+{
+
+    ServeSnapshot* snapshot = calloc(1, sizeof(*snapshot));
+
+    if (!snapshot) {
+        return (NULL);
+    }
+
+    /* A trie holds fewer words than nodes. */
+    size_t size = server->trie->nodes;
+
+    snapshot->words = server->words;
+    snapshot->byWord = malloc(size * sizeof(*snapshot->byWord));
+    snapshot->byRank = malloc(size * sizeof(*snapshot->byRank));
+    snapshot->text = arenaNew(4096);
+
+    if (!snapshot->byWord || !snapshot->byRank || !snapshot->text
+        || trieWalk(server->trie, serveSnapshotAdd, snapshot) == -1) {
+        serveSnapshotFree(snapshot);
+        return (NULL);
+    }
+
+    memcpy(snapshot->byRank, snapshot->byWord,
+           snapshot->count * sizeof(*snapshot->byRank));
+    qsort(snapshot->byRank, snapshot->count, sizeof(*snapshot->byRank),
+          serveRankCompare);
+
+    return (snapshot);
+
+}
+
+/**
+ * @brief   start a detached thread which leaves the signals to the main
+ *          thread
+ * @param   entry the entry point of the thread
+ * @param   argument the argument of the entry point
+ * @return  0 - success, -1 - failure
+ */
+static int
+serveSpawn(void* (*entry)(void*),
+           void* argument)
+{
+
+    sigset_t block;
+    sigset_t previous;
+
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &block, &previous);
+
+    pthread_attr_t attributes;
+    pthread_t thread;
+
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+
+    int status = pthread_create(&thread, &attributes, entry, argument);
+
+    pthread_attr_destroy(&attributes);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    return ((status == 0) ? 0 : -1);
+
+}
+
+/**
+ * @brief   ask the server to stop
+ * @param   signal the signal received
+ * @return  none
+ */
+static void
+serveStop(int signal __attribute__ ((unused)))
+{
+
+    serveStopped = 1;
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
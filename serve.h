@@ -0,0 +1,141 @@
+/**
+ * @file serve.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the word frequency server
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+#include <trie.h>
+
+enum {
+    SERVE_PUBLISH_MS = 100,                 /** minimum time between two
+                                                published snapshots */
+    SERVE_READERS = 64,                     /** query connections served
+                                                at the same time */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Serve Serve;
+typedef struct ServeEntry ServeEntry;
+typedef struct ServeReader ServeReader;
+typedef struct ServeSnapshot ServeSnapshot;
+
+/**
+ * @brief   object representing a word of a snapshot
+ */
+struct ServeEntry {
+    uint64_t frequency;                     /** frequency of the word */
+    uint32_t word;                          /** offset of the word within
+                                                the snapshot arena */
+};
+
+/**
+ * @brief   object representing an immutable copy of the counted words
+ */
+struct ServeSnapshot {
+    uint64_t words;                         /** words counted */
+    uint32_t count;                         /** number of distinct words */
+    ServeEntry* byWord;                     /** words in byte order */
+    ServeEntry* byRank;                     /** words in rank order */
+    Arena* text;                            /** text of the words */
+    uint64_t retired;                       /** epoch it was replaced in */
+    ServeSnapshot* next;                    /** next replaced snapshot */
+};
+
+/**
+ * @brief   object representing a query connection reading snapshots
+ */
+struct ServeReader {
+    uint64_t epoch;                         /** epoch entered, 0 if idle */
+    bool used;                              /** claimed by a connection */
+    char pad[48];                           /** one reader per cache line */
+};
+
+/**
+ * @brief   object representing the state of a running server
+ */
+struct Serve {
+    pthread_mutex_t lock;                   /** held by the writers */
+    Trie* trie;                             /** counted words, locked */
+    uint64_t words;                         /** words counted, locked */
+    bool dirty;                             /** words counted since the
+                                                last snapshot, locked */
+    double build;                           /** milliseconds spent building
+                                                the last snapshot, locked */
+    ServeSnapshot* retired;                 /** replaced snapshots still
+                                                in use, locked */
+    ServeSnapshot* current;                 /** published snapshot, atomic */
+    uint64_t epoch;                         /** publication epoch, atomic */
+    ServeReader reader[SERVE_READERS];      /** query connections */
+};
+
+/**
+ * @brief   the socket of the server to count into and query, NULL for
+ *          none - Global
+ */
+extern const char* serveConnect;
+
+/**
+ * @brief   the socket to serve on, NULL for none - Global
+ */
+extern const char* serveSocket;
+
+/**
+ * @brief   function prototype
+ */
+int
+serve(const char* path);
+
+/**
+ * @brief   function prototype
+ */
+int
+serveClient(const char* path,
+            const char* file,
+            FILE* ofp);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
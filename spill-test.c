@@ -0,0 +1,135 @@
+/**
+ * @file spill-test.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Test program for the k-way merge of spilled runs
+ *
+ * Writes more runs than are merged at a time, so that the merge goes through
+ * an intermediate run, with counts which only fit in 64 bits once added up,
+ * and displays the merged words.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <spill.h>
+#include <trie.h>
+
+enum {
+    SPILL_TEST_RUNS = SPILL_FANIN + 6,      /** runs written */
+    SPILL_TEST_LARGE = 3000000000u,         /** count of a word per run */
+};
+
+/**
+ * @brief   the alphabet of the words - Global
+ */
+Alphabet alphabet;
+
+/*
+ * function prototypes
+ */
+static TrieTopFunc spillTestDump;
+
+/**
+ * @brief   display a merged word with its total count
+ * @param   argument the output stream
+ * @param   word the word
+ * @param   frequency the total count of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+spillTestDump(void* argument,
+              const char* word,
+              uint64_t frequency)
+{
+
+    return ((fprintf(argument, "%" PRIu64 " %s\n", frequency, word) < 0)
+            ? -1 : 0);
+
+}
+
+/**
+ * @brief   entry point for the "spill-test" program
+ * @param   argc the number of command line arguments
+ * @param   argv the command line arguments
+ * @return  0 - success, 1 - failure
+ */
+int
+main(int argc,
+     char* argv[])
+{
+
+    (void) argc;
+    (void) argv;
+
+    if (alphabetParse(ALPHABET_DEFAULT, &alphabet) == -1) {
+        return (1);
+    }
+
+    Spill* spill = spillNew();
+    assert(spill);
+
+    for (uint32_t run = 0; run < SPILL_TEST_RUNS; run++) {
+
+        Trie* trie = trieNew(&alphabet);
+        assert(trie);
+
+        if (!trieAdd(trie, "the", SPILL_TEST_LARGE)
+            || !trieAdd(trie, "of", run + 1)
+            || (run % 2 && !trieAdd(trie, "zebra", 1))
+            || spillWrite(spill, trie) == -1) {
+            return (1);
+        }
+
+        trieFree(trie);
+
+    }
+
+    int status = spillMerge(spill, spillTestDump, stdout);
+
+    spillFree(spill);
+
+    return ((status == 0) ? 0 : 1);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,677 @@
+/**
+ * @file spill.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for spilling counted words to disk
+ *
+ * When the trie reaches the memory budget its words are written to a
+ * temporary file in lexicographical order together with their counts, and
+ * the trie starts over.  At the end of the input the sorted runs are merged,
+ * adding up the counts of each word, and the totals are passed on in order.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <radix.h>
+#include <spill.h>
+#include <trie.h>
+
+/**
+ * @brief   the memory budget of the trie in bytes, 0 for none - Global
+ */
+size_t spillBudget = 0;
+
+/**
+ * @brief   object representing the head of a run record, in host byte order
+ */
+typedef struct __attribute__ ((packed)) SpillHeader {
+    uint64_t frequency; /** count of the word */
+    uint32_t length;    /** length of the word */
+} SpillHeader;
+
+/**
+ * @brief   object representing the read position within a run
+ */
+typedef struct SpillCursor {
+    int fd;             /** spill file descriptor */
+    off_t position;     /** file offset of the next read */
+    off_t end;          /** file offset of the end of the run */
+    char* buffer;       /** read buffer of SPILL_READ_SIZE bytes */
+    size_t start;       /** first unconsumed byte within the buffer */
+    size_t fill;        /** number of valid bytes within the buffer */
+    char* word;         /** word of the current record */
+    size_t size;        /** allocated size of the word */
+    uint64_t frequency; /** count of the current record */
+} SpillCursor;
+
+/*
+ * function prototypes
+ */
+static bool
+spillCursorLess(const SpillCursor* cursor,
+                uint32_t a,
+                uint32_t b);
+
+static int
+spillCursorNext(SpillCursor* cursor);
+
+static int
+spillCursorRead(SpillCursor* cursor,
+                void* data,
+                size_t length);
+
+static int
+spillMergeRuns(Spill* spill,
+               uint32_t first,
+               uint32_t count,
+               TrieTopFunc* func,
+               void* argument);
+
+static TrieTopFunc spillRecord;
+
+static int
+spillRunAdd(Spill* spill,
+            off_t offset);
+
+static void
+spillSift(const SpillCursor* cursor,
+          uint32_t* heap,
+          uint32_t count,
+          uint32_t parent);
+
+/**
+ * @brief   parse a memory budget
+ * @details a number of bytes, optionally followed by "K", "M" or "G"
+ * @param   spec the budget specification
+ * @param   budget the parsed budget in bytes
+ * @return  0 - success, -1 - failure
+ */
+int
+spillBudgetParse(const char* spec,
+                 size_t* budget)
+{
+
+    char* end;
+    unsigned long long value = strtoull(spec, &end, 10);
+
+    if (!isdigit((unsigned char) *spec) || value == 0) {
+        return (-1);
+    }
+
+    size_t scale = 0;
+
+    switch (toupper((unsigned char) *end)) {
+        case '\0': scale = 1; break;
+        case 'K': scale = 1024; break;
+        case 'M': scale = 1024 * 1024; break;
+        case 'G': scale = 1024 * 1024 * 1024; break;
+        default: return (-1);
+    }
+
+    if (*end != '\0' && end[1] != '\0') {
+        return (-1);
+    }
+
+    if (value > SIZE_MAX / scale) {
+        return (-1);
+    }
+
+    *budget = value * scale;
+
+    return (0);
+
+}
+
+/**
+ * @brief   determine if the current word of one run sorts before another
+ * @param   cursor the vector of run cursors
+ * @param   a the index of the first cursor
+ * @param   b the index of the second cursor
+ * @return  true - a sorts before b, false - otherwise
+ */
+static bool
+spillCursorLess(const SpillCursor* cursor,
+                uint32_t a,
+                uint32_t b)
+{
+
+    return (strcmp(cursor[a].word, cursor[b].word) < 0);
+
+}
+
+/**
+ * @brief   read the next record of a run
+ * @param   cursor the read position within the run
+ * @return  1 - a record was read, 0 - end of the run, -1 - failure
+ */
+static int
+spillCursorNext(SpillCursor* cursor)
+{
+
+    SpillHeader header;
+
+    if (cursor->start == cursor->fill && cursor->position == cursor->end) {
+        return (0);
+    }
+
+    if (spillCursorRead(cursor, &header, sizeof(header)) == -1) {
+        return (-1);
+    }
+
+    if (header.length + 1 > cursor->size) {
+
+        size_t size = 2 * ((size_t) header.length + 1);
+        char* word = realloc(cursor->word, size);
+
+        if (!word) {
+            return (-1);
+        }
+
+        cursor->word = word;
+        cursor->size = size;
+
+    }
+
+    if (spillCursorRead(cursor, cursor->word, header.length) == -1) {
+        return (-1);
+    }
+
+    cursor->word[header.length] = '\0';
+    cursor->frequency = header.frequency;
+
+    return (1);
+
+}
+
+/**
+ * @brief   copy bytes from a run, refilling the read buffer as needed
+ * @param   cursor the read position within the run
+ * @param   data the destination of the bytes
+ * @param   length the number of bytes
+ * @return  0 - success, -1 - failure, the run ended early or a read failed
+ */
+static int
+spillCursorRead(SpillCursor* cursor,
+                void* data,
+                size_t length)
+{
+
+    char* out = data;
+
+    while (length > 0) {
+
+        if (cursor->start == cursor->fill) {
+
+            off_t left = cursor->end - cursor->position;
+            size_t size = (left < SPILL_READ_SIZE) ? left : SPILL_READ_SIZE;
+
+            if (size == 0) {
+                return (-1);
+            }
+
+            ssize_t count = pread(cursor->fd, cursor->buffer, size,
+                                  cursor->position);
+
+            if (count <= 0) {
+                return (-1);
+            }
+
+            cursor->position += count;
+            cursor->start = 0;
+            cursor->fill = count;
+
+        }
+
+        size_t copy = cursor->fill - cursor->start;
+
+        if (copy > length) {
+            copy = length;
+        }
+
+        memcpy(out, cursor->buffer + cursor->start, copy);
+        cursor->start += copy;
+        out += copy;
+        length -= copy;
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a spill object, closing and so removing its file
+ * @param   spill the spill object to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+spillFree(Spill* spill)
+{
+
+    int status = (fclose(spill->fp) == 0) ? 0 : -1;
+
+    free(spill->runs);
+    free(spill);
+
+    return (status);
+
+}
+
+/**
+ * @brief   merge every run, passing on each word with its total count
+ * @details runs are first merged SPILL_FANIN at a time into new runs, so
+ *          the read buffers stay bounded however many runs exist
+ * @param   spill the spill object
+ * @param   func the function called with each word in lexicographical
+ *          order and its total count
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+int
+spillMerge(Spill* spill,
+           TrieTopFunc* func,
+           void* argument)
+{
+
+    while (spill->count - spill->first > SPILL_FANIN) {
+
+        off_t offset = ftello(spill->fp);
+
+        if (offset == -1
+            || spillMergeRuns(spill, spill->first, SPILL_FANIN,
+                              spillRecord, spill->fp) == -1
+            || spillRunAdd(spill, offset) == -1) {
+            return (-1);
+        }
+
+        spill->first += SPILL_FANIN;
+
+    }
+
+    int status = spillMergeRuns(spill, spill->first,
+                                spill->count - spill->first, func, argument);
+
+    if (status == 0) {
+        spill->first = spill->count;
+    }
+
+    return (status);
+
+}
+
+/**
+ * @brief   merge a range of runs
+ * @details the runs are ordered by a small binary heap on their current
+ *          words
+ * @param   spill the spill object
+ * @param   first the index of the first run
+ * @param   count the number of runs
+ * @param   func the function called with each word and its total count
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+static int
+spillMergeRuns(Spill* spill,
+               uint32_t first,
+               uint32_t count,
+               TrieTopFunc* func,
+               void* argument)
+{
+
+    /* The runs are read back directly, write out what is buffered. */
+    if (fflush(spill->fp) != 0) {
+        return (-1);
+    }
+
+    SpillCursor* cursor = calloc(count ? count : 1, sizeof(*cursor));
+    uint32_t* heap = calloc(count ? count : 1, sizeof(*heap));
+
+    /* The word being totalled, the cursor words move on beneath it. */
+    size_t size = 64;
+    char* word = malloc(size);
+
+    int status = (cursor && heap && word) ? 0 : -1;
+    uint32_t live = 0;
+
+    for (uint32_t i = 0; i < count && status == 0; i++) {
+
+        cursor[i].fd = fileno(spill->fp);
+        cursor[i].position = spill->runs[first + i].offset;
+        cursor[i].end = cursor[i].position + spill->runs[first + i].length;
+        cursor[i].buffer = malloc(SPILL_READ_SIZE);
+
+        if (!cursor[i].buffer) {
+            status = -1;
+            break;
+        }
+
+        int next = spillCursorNext(&cursor[i]);
+
+        if (next == -1) {
+            status = -1;
+        }
+        else if (next == 1) {
+            heap[live++] = i;
+        }
+
+    }
+
+    /* Build the heap, the run with the smallest word at the root. */
+    for (uint32_t i = live / 2; i-- > 0 && status == 0; ) {
+        spillSift(cursor, heap, live, i);
+    }
+
+    while (live > 0 && status == 0) {
+
+        SpillCursor* top = &cursor[heap[0]];
+        size_t length = strlen(top->word);
+
+        if (length + 1 > size) {
+
+            char* grown = realloc(word, 2 * (length + 1));
+
+            if (!grown) {
+                status = -1;
+                break;
+            }
+
+            word = grown;
+            size = 2 * (length + 1);
+
+        }
+
+        memcpy(word, top->word, length + 1);
+
+        uint64_t total = 0;
+
+        /* Add up the counts of the word across every run holding it. */
+        while (live > 0 && strcmp(cursor[heap[0]].word, word) == 0) {
+
+            total += cursor[heap[0]].frequency;
+
+            int next = spillCursorNext(&cursor[heap[0]]);
+
+            if (next == -1) {
+                status = -1;
+                break;
+            }
+
+            if (next == 0) {
+                heap[0] = heap[--live];
+            }
+
+            spillSift(cursor, heap, live, 0);
+
+        }
+
+        if (status == 0) {
+            status = func(argument, word, total);
+        }
+
+    }
+
+    for (uint32_t i = 0; cursor && i < count; i++) {
+        free(cursor[i].buffer);
+        free(cursor[i].word);
+    }
+
+    free(cursor);
+    free(heap);
+    free(word);
+
+    return (status);
+
+}
+
+/**
+ * @brief   allocate a new spill object and its temporary file
+ * @details the file is created below $TMPDIR, or /tmp when unset, and
+ *          unlinked straight away so that it is removed however the
+ *          program ends
+ * @param   none
+ * @return  a pointer to the newly allocated spill object, NULL if the
+ *          file or memory could not be allocated
+ */
+Spill*
+spillNew(void)
+{
+
+    Spill* spill;
+
+    spill = calloc(1, sizeof(*spill));
+    if (!spill) {
+        return (NULL);
+    }
+
+    const char* tmpdir = getenv("TMPDIR");
+
+    if (!tmpdir || *tmpdir == '\0') {
+        tmpdir = "/tmp";
+    }
+
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/wf-spill.XXXXXX", tmpdir);
+
+    int fd = mkstemp(path);
+
+    if (fd == -1) {
+        free(spill);
+        return (NULL);
+    }
+
+    unlink(path);
+
+    spill->fp = fdopen(fd, "w+");
+
+    if (!spill->fp) {
+        close(fd);
+        free(spill);
+        return (NULL);
+    }
+
+    setvbuf(spill->fp, NULL, _IOFBF, SPILL_BUFFER_SIZE);
+
+    spill->first = 0;
+    spill->count = 0;
+    spill->size = 0;
+    spill->runs = NULL;
+
+    return (spill);
+
+}
+
+/**
+ * @brief   write a word and its count to a run
+ * @details a record is a SpillHeader followed by the word without a
+ *          terminator
+ * @param   argument the spill file stream
+ * @param   word the word
+ * @param   frequency the count of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+spillRecord(void* argument,
+            const char* word,
+            uint64_t frequency)
+{
+
+    FILE* ofp = argument;
+    SpillHeader header = {
+        .frequency = frequency,
+        .length = strlen(word),
+    };
+
+    if (fwrite(&header, sizeof(header), 1, ofp) != 1
+        || fwrite(word, 1, header.length, ofp) != header.length) {
+        return (-1);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   record a run which was just appended to the spill file
+ * @param   spill the spill object
+ * @param   offset the file offset at which the run started
+ * @return  0 - success, -1 - failure
+ */
+static int
+spillRunAdd(Spill* spill,
+            off_t offset)
+{
+
+    off_t end = ftello(spill->fp);
+
+    if (end == -1) {
+        return (-1);
+    }
+
+    if (spill->count == spill->size) {
+
+        uint32_t size = spill->size ? 2 * spill->size : 64;
+        SpillRun* runs = realloc(spill->runs, size * sizeof(*runs));
+
+        if (!runs) {
+            return (-1);
+        }
+
+        spill->runs = runs;
+        spill->size = size;
+
+    }
+
+    spill->runs[spill->count].offset = offset;
+    spill->runs[spill->count].length = end - offset;
+    spill->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   move a run down the merge heap to its place
+ * @param   cursor the vector of run cursors
+ * @param   heap the heap of cursor indices
+ * @param   count the number of runs within the heap
+ * @param   parent the position of the run to be moved
+ * @return  none
+ */
+static void
+spillSift(const SpillCursor* cursor,
+          uint32_t* heap,
+          uint32_t count,
+          uint32_t parent)
+{
+
+    for (;;) {
+
+        uint32_t child = 2 * parent + 1;
+
+        if (child >= count) {
+            break;
+        }
+
+        if (child + 1 < count
+            && spillCursorLess(cursor, heap[child + 1], heap[child])) {
+            child++;
+        }
+
+        if (!spillCursorLess(cursor, heap[child], heap[parent])) {
+            break;
+        }
+
+        uint32_t swap = heap[child];
+        heap[child] = heap[parent];
+        heap[parent] = swap;
+        parent = child;
+
+    }
+
+}
+
+/**
+ * @brief   append the words of a trie to the spill file as a sorted run
+ * @details the trie is left as it is, the caller resets it
+ * @param   spill the spill object
+ * @param   trie the trie holding the counted words
+ * @return  0 - success, -1 - failure
+ */
+int
+spillWrite(Spill* spill,
+           Trie* trie)
+{
+
+    off_t offset = ftello(spill->fp);
+
+    if (offset == -1 || trieWalk(trie, spillRecord, spill->fp) == -1) {
+        return (-1);
+    }
+
+    return (spillRunAdd(spill, offset));
+
+}
+
+/**
+ * @brief   append the words of a radix tree to the spill file as a sorted run
+ * @details the radix tree is left as it is, the caller resets it
+ * @param   spill the spill object
+ * @param   radix the radix tree holding the counted words
+ * @return  0 - success, -1 - failure
+ */
+int
+spillWriteRadix(Spill* spill,
+                Radix* radix)
+{
+
+    off_t offset = ftello(spill->fp);
+
+    if (offset == -1 || radixWalk(radix, spillRecord, spill->fp) == -1) {
+        return (-1);
+    }
+
+    return (spillRunAdd(spill, offset));
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
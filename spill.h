@@ -0,0 +1,129 @@
+/**
+ * @file spill.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for spilling counted words to disk
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <radix.h>
+#include <trie.h>
+
+enum {
+    SPILL_BUFFER_SIZE = 1024 * 1024,        /** run file write buffer size */
+    SPILL_FANIN = 64,                       /** runs merged at a time */
+    SPILL_READ_SIZE = 64 * 1024,            /** run file read buffer size */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Spill Spill;
+typedef struct SpillRun SpillRun;
+
+/**
+ * @brief   object representing a sorted run within the spill file
+ */
+struct SpillRun {
+    off_t offset;           /** file offset of the first record */
+    off_t length;           /** length of the run in bytes */
+};
+
+/**
+ * @brief   object representing the sorted runs spilled to disk
+ */
+struct Spill {
+    FILE* fp;               /** unlinked temporary file holding the runs */
+    uint32_t first;         /** index of the oldest run not yet merged */
+    uint32_t count;         /** number of runs written */
+    uint32_t size;          /** allocated size of the run vector */
+    SpillRun* runs;         /** dynamically allocated vector of runs */
+};
+
+/**
+ * @brief   the memory budget selected on the command line - Global
+ */
+extern size_t spillBudget;
+
+/**
+ * @brief   function prototype
+ */
+int
+spillBudgetParse(const char* spec,
+                 size_t* budget);
+
+/**
+ * @brief   function prototype
+ */
+int
+spillFree(Spill* spill);
+
+/**
+ * @brief   function prototype
+ */
+int
+spillMerge(Spill* spill,
+           TrieTopFunc* func,
+           void* argument);
+
+/**
+ * @brief   function prototype
+ */
+Spill*
+spillNew(void);
+
+/**
+ * @brief   function prototype
+ */
+int
+spillWrite(Spill* spill,
+           Trie* trie);
+
+/**
+ * @brief   function prototype
+ */
+int
+spillWriteRadix(Spill* spill,
+                Radix* radix);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -44,10 +44,13 @@
 
 #include <wf.h>
 
+#include <alphabet.h>
+#include <input.h>
 #include <squeeze.h>
+#include <trace.h>
 
 /**
- * @brief   filter input within the character class [a-zA-Z]
+ * @brief   filter input down to the words of the alphabet
  * @param   ifp input stream file pointer
  * @param   ofp output stream file pointer
  * @return  0 - success, -1 - failure
@@ -58,34 +61,66 @@ squeeze(FILE* ifp,
 {
 
     /*
-     * Process a byte at a time from the input stream.
+     * Process a buffer at a time from the read-ahead input layer.
      *
-     * All upper case characters in the class [a-zA-Z] are converted to
-     * the lower case equivalent.
+     * Only the letters of the alphabet are kept, upper case characters
+     * folded onto the lower case letters.
      *
      * A newline character delimts words in the output stream.
      *
-     * The squeezing Boolean is true when multiple contiguous characters
-     * NOT in the class [a-zA-Z] are being processed.
+     * The length is zero while multiple contiguous characters NOT in the
+     * alphabet are being processed.  A word may span the boundary
+     * between two input buffers.
      */
-    char byte = '\0';
-    uint32_t length = 0;
-    bool squeezing = true;
+    Input* input = inputNew(fileno(ifp), inputMode);
+    InputBuffer* buffer;
 
-    while (fread(&byte, 1, 1, ifp) == 1) {
+    /* Each input byte produces at most one output byte, plus a newline. */
+    char* output = malloc(INPUT_BUFFER_SIZE + 1);
+    size_t length = 0;
+
+    while ((buffer = inputNext(input)) != NULL) {
+
+        char* out = output;
+        bool partial = (buffer->length < INPUT_BUFFER_SIZE);
+        uint64_t start = traceStart();
+
+        for (size_t i = 0; i < buffer->length; i++) {
+
+            unsigned char byte = buffer->data[i];
+            unsigned char letter = alphabet.fold[byte];
+
+            if (letter != 0) {
+                *out++ = letter;
+                length++;
+            }
+
+            else if (length != 0) {
+                *out++ = '\n';
+                length = 0;
+            }
 
-        if (isalpha(byte)) {
-            fputc(tolower(byte), ofp);
-            length++;
-            squeezing = false;
         }
 
-        else if (length != 0 && squeezing == false) {
-            fputc('\n', ofp);
-            length = 0;
-            squeezing = true;
+        traceSpan("tokenize", start);
+
+        /* Hand the buffer back so it can be refilled while writing. */
+        inputRelease(input, buffer);
+
+        start = traceStart();
+
+        fwrite(output, 1, out - output, ofp);
+
+        /*
+         * A short buffer means the input arrives slower than it is read,
+         * pass its words on now rather than when the stream fills up.
+         */
+        if (partial) {
+            fflush(ofp);
         }
 
+        traceSpan("pipe write", start);
+
     }
 
     /* If a valid word was in process terminate the record. */
@@ -93,14 +128,12 @@ squeeze(FILE* ifp,
         fputc('\n', ofp);
     }
 
-    int status = 0;
+    free(output);
 
-    /* End of input reached, report success. */
-    if (feof(ifp)) {
-        status = 0;
-    }
-    /* An input error occurred, report failure. */
-    else if (ferror(ifp)) {
+    /* A failed read is reported when the input is released. */
+    int status = inputFree(input);
+
+    if (ferror(ofp)) {
         status = -1;
     }
 
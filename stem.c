@@ -0,0 +1,686 @@
+/**
+ * @file stem.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for counting the words by their stem
+ *
+ * The stem of a word is found by the Porter stemmer (M.F. Porter, "An
+ * algorithm for suffix stripping", Program 14(3), 1980), once per distinct
+ * surface word:  The surface words are counted by the trie as usual, then
+ * the trie is walked once and each word adds its count to its stem in a
+ * trie of the stems.  An occurrence of a word costs its trie walk only.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <count.h>
+#include <stem.h>
+#include <trie.h>
+
+/*
+ * forward declarations
+ */
+typedef struct StemFold StemFold;
+typedef struct StemWord StemWord;
+
+/**
+ * @brief   object representing the stem trie being filled from the surface
+ *          words
+ */
+struct StemFold {
+    Trie* stems;            /** stems, counted */
+    char* scratch;          /** word being stemmed */
+    size_t size;            /** allocated size of the scratch word */
+};
+
+/**
+ * @brief   object representing a word being stemmed
+ */
+struct StemWord {
+    char* b;                /** letters of the word */
+    int k;                  /** index of the last letter */
+    int j;                  /** index of the last letter before a suffix */
+};
+
+/**
+ * @brief   count the words by their stem - Global
+ */
+bool stemEnabled = false;
+
+/*
+ * function prototypes
+ */
+static bool
+stemConsonant(const StemWord* z,
+              int i);
+
+static bool
+stemCvc(const StemWord* z,
+        int i);
+
+static bool
+stemDouble(const StemWord* z,
+           int i);
+
+static bool
+stemEnds(StemWord* z,
+         const char* suffix);
+
+static TrieTopFunc stemFold;
+
+static int
+stemMeasure(const StemWord* z);
+
+static void
+stemReplace(StemWord* z,
+            const char* suffix);
+
+static void
+stemSet(StemWord* z,
+        const char* suffix);
+
+static void
+stemStep1ab(StemWord* z);
+
+static void
+stemStep1c(StemWord* z);
+
+static void
+stemStep2(StemWord* z);
+
+static void
+stemStep3(StemWord* z);
+
+static void
+stemStep4(StemWord* z);
+
+static void
+stemStep5(StemWord* z);
+
+static bool
+stemVowelIn(const StemWord* z);
+
+/**
+ * @brief   determine if a letter of a word is a consonant
+ * @details a 'y' is a consonant at the start of the word or after a vowel
+ * @param   z the word
+ * @param   i the index of the letter
+ * @return  true - consonant, false - vowel
+ */
+static bool
+stemConsonant(const StemWord* z,
+              int i)
+{
+
+    switch (z->b[i]) {
+        case 'a':
+        case 'e':
+        case 'i':
+        case 'o':
+        case 'u':
+            return (false);
+        case 'y':
+            return ((i == 0) ? true : !stemConsonant(z, i - 1));
+        default:
+            return (true);
+    }
+
+}
+
+/**
+ * @brief   determine if the letters up to an index end consonant, vowel,
+ *          consonant, the last not a 'w', 'x' or 'y'
+ * @details this is used to restore an 'e' at the end of a short word, as
+ *          in "cav(e)", "lov(e)", "hop(e)" but not "snow", "box" or "tray"
+ * @param   z the word
+ * @param   i the index of the last letter
+ * @return  true - the letters end consonant, vowel, consonant, false - not
+ */
+static bool
+stemCvc(const StemWord* z,
+        int i)
+{
+
+    if (i < 2 || !stemConsonant(z, i) || stemConsonant(z, i - 1)
+        || !stemConsonant(z, i - 2)) {
+        return (false);
+    }
+
+    return (z->b[i] != 'w' && z->b[i] != 'x' && z->b[i] != 'y');
+
+}
+
+/**
+ * @brief   determine if a letter doubles the letter before it, which are
+ *          consonants
+ * @param   z the word
+ * @param   i the index of the letter
+ * @return  true - double consonant, false - not
+ */
+static bool
+stemDouble(const StemWord* z,
+           int i)
+{
+
+    if (i < 1 || z->b[i] != z->b[i - 1]) {
+        return (false);
+    }
+
+    return (stemConsonant(z, i));
+
+}
+
+/**
+ * @brief   determine if the word ends with a suffix, and if so mark the
+ *          letters before it
+ * @param   z the word
+ * @param   suffix the suffix
+ * @return  true - the word ends with the suffix, false - not
+ */
+static bool
+stemEnds(StemWord* z,
+         const char* suffix)
+{
+
+    int length = strlen(suffix);
+
+    if (length > z->k + 1
+        || memcmp(z->b + z->k - length + 1, suffix, length) != 0) {
+        return (false);
+    }
+
+    z->j = z->k - length;
+
+    return (true);
+
+}
+
+/**
+ * @brief   add the count of a surface word to its stem
+ * @param   argument the stem trie being filled
+ * @param   word the surface word
+ * @param   frequency the frequency of the surface word
+ * @return  0 - success, -1 - failure
+ */
+static int
+stemFold(void* argument,
+         const char* word,
+         uint64_t frequency)
+{
+
+    StemFold* fold = argument;
+    size_t length = strlen(word);
+
+    if (length + 1 > fold->size) {
+
+        char* scratch = realloc(fold->scratch, 2 * (length + 1));
+
+        if (!scratch) {
+            return (-1);
+        }
+
+        fold->scratch = scratch;
+        fold->size = 2 * (length + 1);
+
+    }
+
+    memcpy(fold->scratch, word, length);
+    length = stemPorter(fold->scratch, length);
+    fold->scratch[length] = '\0';
+
+    /* A stem with a letter outside of the alphabet is not used. */
+    for (size_t i = 0; i < length; i++) {
+        if (alphabetIndex(&alphabet, fold->scratch[i]) == ALPHABET_NONE) {
+            memcpy(fold->scratch, word, strlen(word) + 1);
+            break;
+        }
+    }
+
+    return (trieAdd(fold->stems, fold->scratch, frequency) ? 0 : -1);
+
+}
+
+/**
+ * @brief   count the consonant vowel sequences of the letters before a
+ *          suffix
+ * @details with [C] and [V] optional runs of consonants and vowels, the
+ *          letters read [C](VC){m}[V] and m is the measure
+ * @param   z the word
+ * @return  the measure
+ */
+static int
+stemMeasure(const StemWord* z)
+{
+
+    int n = 0;
+    int i = 0;
+
+    /* Skip the leading consonants. */
+    for (;; i++) {
+        if (i > z->j) {
+            return (n);
+        }
+        if (!stemConsonant(z, i)) {
+            break;
+        }
+    }
+
+    for (i++; ; i++) {
+
+        /* A run of vowels, then a run of consonants ends a sequence. */
+        for (;; i++) {
+            if (i > z->j) {
+                return (n);
+            }
+            if (stemConsonant(z, i)) {
+                break;
+            }
+        }
+
+        n++;
+
+        for (i++; ; i++) {
+            if (i > z->j) {
+                return (n);
+            }
+            if (!stemConsonant(z, i)) {
+                break;
+            }
+        }
+
+    }
+
+}
+
+/**
+ * @brief   reduce a word to its stem by the Porter stemmer
+ * @details the word is rewritten in place and never grows;  Words of two
+ *          letters or less are their own stem
+ * @param   word the letters of the word, in lower case, not terminated
+ * @param   length the length of the word
+ * @return  the length of the stem
+ */
+size_t
+stemPorter(char* word,
+           size_t length)
+{
+
+    if (length <= 2) {
+        return (length);
+    }
+
+    StemWord z = {
+        .b = word,
+        .k = length - 1,
+        .j = 0,
+    };
+
+    stemStep1ab(&z);
+
+    if (z.k > 0) {
+        stemStep1c(&z);
+        stemStep2(&z);
+        stemStep3(&z);
+        stemStep4(&z);
+        stemStep5(&z);
+    }
+
+    return (z.k + 1);
+
+}
+
+/**
+ * @brief   replace the suffix found by stemEnds() if the letters before it
+ *          have a measure above zero
+ * @param   z the word
+ * @param   suffix the replacement
+ * @return  none
+ */
+static void
+stemReplace(StemWord* z,
+            const char* suffix)
+{
+
+    if (stemMeasure(z) > 0) {
+        stemSet(z, suffix);
+    }
+
+}
+
+/**
+ * @brief   replace the suffix found by stemEnds()
+ * @param   z the word
+ * @param   suffix the replacement
+ * @return  none
+ */
+static void
+stemSet(StemWord* z,
+        const char* suffix)
+{
+
+    int length = strlen(suffix);
+
+    memmove(z->b + z->j + 1, suffix, length);
+    z->k = z->j + length;
+
+}
+
+/**
+ * @brief   remove the plurals and the -ed or -ing endings
+ * @details caresses -> caress, ponies -> poni, cats -> cat, feed -> feed,
+ *          agreed -> agree, plastered -> plaster, motoring -> motor,
+ *          hopping -> hop, filing -> file
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep1ab(StemWord* z)
+{
+
+    char* b = z->b;
+
+    if (b[z->k] == 's') {
+        if (stemEnds(z, "sses")) {
+            z->k -= 2;
+        }
+        else if (stemEnds(z, "ies")) {
+            stemSet(z, "i");
+        }
+        else if (b[z->k - 1] != 's') {
+            z->k--;
+        }
+    }
+
+    if (stemEnds(z, "eed")) {
+        if (stemMeasure(z) > 0) {
+            z->k--;
+        }
+    }
+    else if ((stemEnds(z, "ed") || stemEnds(z, "ing")) && stemVowelIn(z)) {
+
+        z->k = z->j;
+
+        if (stemEnds(z, "at")) {
+            stemSet(z, "ate");
+        }
+        else if (stemEnds(z, "bl")) {
+            stemSet(z, "ble");
+        }
+        else if (stemEnds(z, "iz")) {
+            stemSet(z, "ize");
+        }
+        /* A double consonant is undone, but for "ll", "ss" and "zz". */
+        else if (stemDouble(z, z->k)) {
+            z->k--;
+            if (b[z->k] == 'l' || b[z->k] == 's' || b[z->k] == 'z') {
+                z->k++;
+            }
+        }
+        else if (stemMeasure(z) == 1 && stemCvc(z, z->k)) {
+            stemSet(z, "e");
+        }
+
+    }
+
+}
+
+/**
+ * @brief   turn a final 'y' into an 'i' when there is another vowel
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep1c(StemWord* z)
+{
+
+    if (stemEnds(z, "y") && stemVowelIn(z)) {
+        z->b[z->k] = 'i';
+    }
+
+}
+
+/**
+ * @brief   map the double suffixes to single ones, -ization to -ize and
+ *          so on, when the letters before them have a measure above zero
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep2(StemWord* z)
+{
+
+    static const struct {
+        char letter;
+        const char* suffix;
+        const char* replacement;
+    } suffixVector[] = {
+        { 'a', "ational", "ate" },
+        { 'a', "tional", "tion" },
+        { 'c', "enci", "ence" },
+        { 'c', "anci", "ance" },
+        { 'e', "izer", "ize" },
+        { 'g', "logi", "log" },
+        { 'l', "bli", "ble" },
+        { 'l', "alli", "al" },
+        { 'l', "entli", "ent" },
+        { 'l', "eli", "e" },
+        { 'l', "ousli", "ous" },
+        { 'o', "ization", "ize" },
+        { 'o', "ation", "ate" },
+        { 'o', "ator", "ate" },
+        { 's', "alism", "al" },
+        { 's', "iveness", "ive" },
+        { 's', "fulness", "ful" },
+        { 's', "ousness", "ous" },
+        { 't', "aliti", "al" },
+        { 't', "iviti", "ive" },
+        { 't', "biliti", "ble" },
+    };
+
+    /* Only the first suffix found, by the next to last letter, is tried. */
+    for (size_t i = 0; i < sizeof(suffixVector) / sizeof(suffixVector[0]);
+         i++) {
+        if (suffixVector[i].letter == z->b[z->k - 1]
+            && stemEnds(z, suffixVector[i].suffix)) {
+            stemReplace(z, suffixVector[i].replacement);
+            break;
+        }
+    }
+
+}
+
+/**
+ * @brief   remove or simplify -ic-, -full, -ness and so on, when the
+ *          letters before them have a measure above zero
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep3(StemWord* z)
+{
+
+    static const struct {
+        const char* suffix;
+        const char* replacement;
+    } suffixVector[] = {
+        { "icate", "ic" },
+        { "ative", "" },
+        { "alize", "al" },
+        { "iciti", "ic" },
+        { "ical", "ic" },
+        { "ful", "" },
+        { "ness", "" },
+    };
+
+    for (size_t i = 0; i < sizeof(suffixVector) / sizeof(suffixVector[0]);
+         i++) {
+        if (stemEnds(z, suffixVector[i].suffix)) {
+            stemReplace(z, suffixVector[i].replacement);
+            break;
+        }
+    }
+
+}
+
+/**
+ * @brief   remove -ant, -ence and so on, when the letters before them have
+ *          a measure above one
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep4(StemWord* z)
+{
+
+    static const char* const suffixVector[] = {
+        "al", "ance", "ence", "er", "ic", "able", "ible", "ant", "ement",
+        "ment", "ent", "ion", "ou", "ism", "ate", "iti", "ous", "ive", "ize",
+    };
+
+    for (size_t i = 0; i < sizeof(suffixVector) / sizeof(suffixVector[0]);
+         i++) {
+
+        if (!stemEnds(z, suffixVector[i])) {
+            continue;
+        }
+
+        /* The -ion suffix only follows an 's' or a 't'. */
+        if (strcmp(suffixVector[i], "ion") == 0
+            && (z->j < 0 || (z->b[z->j] != 's' && z->b[z->j] != 't'))) {
+            continue;
+        }
+
+        if (stemMeasure(z) > 1) {
+            z->k = z->j;
+        }
+
+        break;
+
+    }
+
+}
+
+/**
+ * @brief   remove a final -e and undo a final -ll, when the letters before
+ *          them have a measure above one
+ * @param   z the word
+ * @return  none
+ */
+static void
+stemStep5(StemWord* z)
+{
+
+    z->j = z->k;
+
+    if (z->b[z->k] == 'e') {
+
+        int measure = stemMeasure(z);
+
+        if (measure > 1 || (measure == 1 && !stemCvc(z, z->k - 1))) {
+            z->k--;
+        }
+
+    }
+
+    if (z->b[z->k] == 'l' && stemDouble(z, z->k) && stemMeasure(z) > 1) {
+        z->k--;
+    }
+
+}
+
+/**
+ * @brief   count the stems of the words of a trie
+ * @details each distinct surface word is stemmed once, and its stem counted
+ *          as often as the word;  The stem trie keeps its subtree maxima, so
+ *          it is queried best first like any other trie
+ * @param   surface the trie of the surface words
+ * @return  a pointer to the new trie of the stems, NULL if memory could not
+ *          be allocated
+ */
+Trie*
+stemTrie(Trie* surface)
+{
+
+    StemFold fold = {
+        .stems = countTrieNew(),
+        .scratch = malloc(64),
+        .size = 64,
+    };
+
+    int status = (fold.stems && fold.scratch) ? 0 : -1;
+
+    if (status == 0) {
+        status = trieWalk(surface, stemFold, &fold);
+    }
+
+    free(fold.scratch);
+
+    if (status == -1 && fold.stems) {
+        trieFree(fold.stems);
+        fold.stems = NULL;
+    }
+
+    return (fold.stems);
+
+}
+
+/**
+ * @brief   determine if the letters before a suffix contain a vowel
+ * @param   z the word
+ * @return  true - a vowel is found, false - none
+ */
+static bool
+stemVowelIn(const StemWord* z)
+{
+
+    for (int i = 0; i <= z->j; i++) {
+        if (!stemConsonant(z, i)) {
+            return (true);
+        }
+    }
+
+    return (false);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
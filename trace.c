@@ -0,0 +1,407 @@
+/**
+ * @file trace.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for timeline tracing
+ *
+ * Every thread records its spans into a ring of its own, without locking.
+ * Each process appends its rings to a part file as it exits, and the process
+ * which opened the trace merges the part files of all its processes into
+ * one Chrome trace JSON file, which Perfetto reads as well
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <trace.h>
+
+/**
+ * @brief   record timed spans - Global
+ */
+bool traceEnabled = false;
+
+/**
+ * @brief   the file receiving the merged trace, NULL for none - Global
+ */
+const char* traceFile = NULL;
+
+/**
+ * @brief   the file receiving the spans of every process
+ */
+static char* tracePart = NULL;
+
+/**
+ * @brief   the process which opened the trace and merges it
+ */
+static pid_t traceParent = 0;
+
+/**
+ * @brief   the name of this process in the trace, NULL for none
+ */
+static const char* traceProcess = NULL;
+
+/**
+ * @brief   the rings of every thread of this process
+ */
+static TraceRing* traceRings = NULL;
+
+/**
+ * @brief   lock protecting the list of rings
+ */
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief   the ring of the calling thread
+ */
+static __thread TraceRing* traceLocal = NULL;
+
+/*
+ * function prototypes
+ */
+static void
+traceClose(void);
+
+static int
+traceMerge(void);
+
+static TraceRing*
+traceRingNew(void);
+
+static int
+traceWrite(int fd,
+           const char* data,
+           size_t length);
+
+/**
+ * @brief   get the time of a span boundary
+ * @details the monotonic clock is shared by the processes, so their spans
+ *          line up
+ * @param   none
+ * @return  the time in nanoseconds
+ */
+uint64_t
+traceClock(void)
+{
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000000 + now.tv_nsec);
+
+}
+
+/**
+ * @brief   append the spans of this process to the part file, and merge the
+ *          trace once the process which opened it exits
+ * @details called upon exit, the child processes have terminated by the
+ *          time the process which opened the trace exits
+ * @param   none
+ * @return  none
+ */
+static void
+traceClose(void)
+{
+
+    int fd = open(tracePart, O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    if (fd == -1) {
+        fprintf(stderr, "wf: cannot create %s: %s\n", tracePart,
+                strerror(errno));
+        return;
+    }
+
+    /*
+     * Each write holds whole lines, so the lines of processes exiting at
+     * the same time never interleave.
+     */
+    char buffer[65536];
+    size_t used = 0;
+    pid_t pid = getpid();
+    int status = 0;
+
+    if (traceProcess) {
+        used += snprintf(buffer, sizeof(buffer),
+                         "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                         "\"args\":{\"name\":\"%s\"}}\n", (int) pid,
+                         traceProcess);
+    }
+
+    pthread_mutex_lock(&traceLock);
+
+    for (TraceRing* ring = traceRings; ring; ring = ring->next) {
+
+        /* The oldest spans were overwritten once the ring wrapped. */
+        uint64_t first = (ring->count > TRACE_EVENTS)
+                         ? ring->count - TRACE_EVENTS : 0;
+
+        for (uint64_t i = first; i < ring->count && status == 0; i++) {
+
+            const TraceEvent* event = &ring->event[i % TRACE_EVENTS];
+
+            if (used > sizeof(buffer) - 256) {
+                status = traceWrite(fd, buffer, used);
+                used = 0;
+            }
+
+            used += snprintf(buffer + used, sizeof(buffer) - used,
+                             "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,"
+                             "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}\n",
+                             event->name, (int) pid, (int) ring->tid,
+                             event->start / 1e3, event->duration / 1e3);
+
+        }
+
+    }
+
+    pthread_mutex_unlock(&traceLock);
+
+    if (status == 0) {
+        status = traceWrite(fd, buffer, used);
+    }
+
+    close(fd);
+
+    if (status == 0 && pid == traceParent) {
+        status = traceMerge();
+    }
+
+    if (status == -1) {
+        fprintf(stderr, "wf: cannot write trace %s: %s\n", traceFile,
+                strerror(errno));
+    }
+
+}
+
+/**
+ * @brief   merge the spans of every process into the trace file
+ * @param   none
+ * @return  0 - success, -1 - failure
+ */
+static int
+traceMerge(void)
+{
+
+    FILE* ifp = fopen(tracePart, "r");
+    FILE* ofp = fopen(traceFile, "w");
+
+    if (!ifp || !ofp) {
+        if (ifp) {
+            fclose(ifp);
+        }
+        if (ofp) {
+            fclose(ofp);
+        }
+        return (-1);
+    }
+
+    char* line = NULL;
+    size_t size = 0;
+    ssize_t length;
+    const char* separator = "";
+
+    fputs("{\"traceEvents\":[\n", ofp);
+
+    while ((length = getline(&line, &size, ifp)) > 0) {
+
+        if (line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+
+        fprintf(ofp, "%s%s", separator, line);
+        separator = ",\n";
+
+    }
+
+    fputs("\n],\"displayTimeUnit\":\"ns\"}\n", ofp);
+
+    free(line);
+    fclose(ifp);
+    unlink(tracePart);
+
+    return ((fclose(ofp) == 0) ? 0 : -1);
+
+}
+
+/**
+ * @brief   name the calling process in the trace
+ * @param   name the name of the process, a string literal
+ * @return  none
+ */
+void
+traceName(const char* name)
+{
+
+    traceProcess = name;
+
+}
+
+/**
+ * @brief   start recording spans into a trace file
+ * @details the trace is written when the calling process exits, with the
+ *          spans of every process it forks after the call
+ * @param   path the path of the trace file
+ * @return  0 - success, -1 - failure
+ */
+int
+traceOpen(const char* path)
+{
+
+    size_t length = strlen(path) + sizeof(".part");
+
+    tracePart = malloc(length);
+
+    if (!tracePart) {
+        return (-1);
+    }
+
+    snprintf(tracePart, length, "%s.part", path);
+
+    /* Spans of an earlier run must not be merged into this one. */
+    unlink(tracePart);
+
+    if (atexit(traceClose) != 0) {
+        free(tracePart);
+        tracePart = NULL;
+        return (-1);
+    }
+
+    traceFile = path;
+    traceParent = getpid();
+    traceEnabled = true;
+
+    return (0);
+
+}
+
+/**
+ * @brief   record a span of the calling thread ending now
+ * @param   name the name of the span, a string literal
+ * @param   start the start of the span from traceStart()
+ * @return  none
+ */
+void
+traceRecord(const char* name,
+            uint64_t start)
+{
+
+    uint64_t end = traceClock();
+    TraceRing* ring = traceLocal ? traceLocal : traceRingNew();
+
+    /* Without a ring the span is lost rather than failing the count. */
+    if (!ring) {
+        return;
+    }
+
+    TraceEvent* event = &ring->event[ring->count % TRACE_EVENTS];
+
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+
+    ring->count++;
+
+}
+
+/**
+ * @brief   allocate the ring of the calling thread
+ * @param   none
+ * @return  a pointer to the new ring, NULL if memory could not be
+ *          allocated
+ */
+static TraceRing*
+traceRingNew(void)
+{
+
+    TraceRing* ring = calloc(1, sizeof(*ring));
+
+    if (!ring) {
+        return (NULL);
+    }
+
+    ring->tid = syscall(SYS_gettid);
+
+    pthread_mutex_lock(&traceLock);
+    ring->next = traceRings;
+    traceRings = ring;
+    pthread_mutex_unlock(&traceLock);
+
+    traceLocal = ring;
+
+    return (ring);
+
+}
+
+/**
+ * @brief   write out a buffer, retrying partial and interrupted writes
+ * @param   fd the output file descriptor
+ * @param   data the data to be written
+ * @param   length the length of the data
+ * @return  0 - success, -1 - failure
+ */
+static int
+traceWrite(int fd,
+           const char* data,
+           size_t length)
+{
+
+    while (length != 0) {
+
+        ssize_t written = write(fd, data, length);
+
+        if (written == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (written == -1) {
+            return (-1);
+        }
+
+        data += written;
+        length -= written;
+
+    }
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -0,0 +1,147 @@
+/**
+ * @file trace.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for timeline tracing
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+enum {
+    TRACE_EVENTS = 65536,                   /** spans kept by each thread,
+                                                the oldest overwritten */
+    TRACE_STALL_NS = 10000,                 /** shortest word read traced
+                                                as a pipe read */
+    TRACE_WORDS = 65536,                    /** words counted per span */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct TraceEvent TraceEvent;
+typedef struct TraceRing TraceRing;
+
+/**
+ * @brief   object representing a timed span
+ */
+struct TraceEvent {
+    const char* name;                       /** name of the span, static */
+    uint64_t start;                         /** start in nanoseconds */
+    uint64_t duration;                      /** duration in nanoseconds */
+};
+
+/**
+ * @brief   object representing the spans recorded by one thread
+ */
+struct TraceRing {
+    TraceRing* next;                        /** ring of the next thread */
+    pid_t tid;                              /** thread id */
+    uint64_t count;                         /** spans recorded */
+    TraceEvent event[TRACE_EVENTS];         /** the most recent spans */
+};
+
+/**
+ * @brief   record timed spans - Global
+ */
+extern bool traceEnabled;
+
+/**
+ * @brief   the file receiving the merged trace, NULL for none - Global
+ */
+extern const char* traceFile;
+
+/**
+ * @brief   function prototype
+ */
+uint64_t
+traceClock(void);
+
+/**
+ * @brief   function prototype
+ */
+void
+traceName(const char* name);
+
+/**
+ * @brief   function prototype
+ */
+int
+traceOpen(const char* path);
+
+/**
+ * @brief   function prototype
+ */
+void
+traceRecord(const char* name,
+            uint64_t start);
+
+/**
+ * @brief   start a span
+ * @details costs a single test of a global while tracing is off
+ * @return  the start of the span, 0 while tracing is off
+ */
+static inline uint64_t
+traceStart(void)
+{
+
+    return (traceEnabled ? traceClock() : 0);
+
+}
+
+/**
+ * @brief   end a span started by traceStart()
+ * @param   name the name of the span, a string literal
+ * @param   start the start of the span
+ * @return  none
+ */
+static inline void
+traceSpan(const char* name,
+          uint64_t start)
+{
+
+    if (traceEnabled) {
+        traceRecord(name, start);
+    }
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
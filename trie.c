@@ -44,62 +44,1712 @@
 
 #include <wf.h>
 
+#include <alphabet.h>
+#include <arena.h>
+#include <page.h>
 #include <trie.h>
 
+/**
+ * @brief   object representing a pending item of a best-first trie query
+ */
+typedef struct TrieItem {
+    TrieNode* node;     /** trie node of the item */
+    uint64_t value;     /** subtree maximum or word frequency */
+    uint32_t text;      /** offset of the item's word or prefix */
+    uint32_t length;    /** length of the item's word or prefix */
+    bool subtree;       /** true - whole subtree, false - single word */
+} TrieItem;
+
+/**
+ * @brief   object representing a node waiting to be moved by a re-layout
+ */
+typedef struct TrieMove {
+    TrieNode* node;     /** node at its old address */
+    TrieNode** slot;    /** pointer to the node, updated once it moved */
+} TrieMove;
+
+/**
+ * @brief   object representing the priority queue of a best-first query
+ */
+typedef struct TrieQueue {
+    uint32_t count;     /** number of items within the queue */
+    uint32_t size;      /** allocated size of the queue */
+    TrieItem* vector;   /** dynamically allocated vector of items */
+    Arena* text;        /** words and prefixes of the items */
+} TrieQueue;
+
+/*
+ * function prototypes
+ */
+static Trie*
+trieAllocate(const Alphabet* alphabet,
+             bool pooled,
+             bool huge);
+
+static bool
+trieBlockHas(const Trie* trie,
+             const TrieNode* node);
+
+static uint64_t
+trieBound(uint32_t max);
+
+static inline int
+trieCount(Trie* trie,
+          TrieNode* node,
+          TrieNode* run,
+          const char* from);
+
+static inline TrieNode*
+trieDescend(Trie* trie,
+            const char* word,
+            bool create,
+            TrieNode** run,
+            const char** from);
+
+static bool
+trieItemLess(const TrieQueue* queue,
+             const TrieItem* a,
+             const TrieItem* b);
+
+static TrieMove
+trieMovePop(TrieMove* work,
+            size_t* count);
+
+static void
+trieMovePush(TrieMove* work,
+             size_t* count,
+             TrieNode* node,
+             TrieNode** slot);
+
+static void
+trieNodeFree(Trie* trie,
+             TrieNode* node,
+             bool keep);
+
+static bool
+trieNodeOwned(const Trie* trie,
+              const TrieNode* node);
+
+static void
+trieQueuePop(TrieQueue* queue,
+             TrieItem* item);
+
+static int
+trieQueuePush(TrieQueue* queue,
+              const TrieItem* item);
+
+static void
+trieSlabFree(TrieSlab* slab);
+
+static TrieSlab*
+trieSlabNew(const Trie* trie,
+            size_t size);
+
+static void
+trieSpareFree(Trie* trie);
+
+/**
+ * @brief   add a number of occurrences of a word to a trie
+ * @param   trie the trie
+ * @param   word pointer to the word to be added
+ * @param   count the number of occurrences, at least 1
+ * @return  a pointer to the trie node containing the word, NULL if a node
+ *          could not be allocated or its frequency could not be promoted
+ */
+TrieNode*
+trieAdd(Trie* trie,
+        const char* word,
+        uint64_t count)
+{
+
+    TrieNode* run;
+    const char* from;
+    TrieNode* node = trieDescend(trie, word, true, &run, &from);
+
+    if (!node || counterAdd(&trie->wide, &node->frequency, count) == -1) {
+        return (NULL);
+    }
+
+    /* A promoted frequency saturates the subtree maxima. */
+    uint32_t bound = (node->frequency < COUNTER_WIDE) ? node->frequency
+                                                      : UINT32_MAX;
+
+    /*
+     * More than one occurrence can raise the maxima above the trailing run
+     * as well, so the whole path is walked.
+     */
+    for (TrieNode* raise = trie->root; ; word++) {
+
+        if (raise->max < bound) {
+            raise->max = bound;
+        }
+
+        if (*word == '\0') {
+            break;
+        }
+
+        raise = raise->child[alphabetIndex(trie->alphabet, *word)];
+
+    }
+
+    return (node);
+
+}
+
+/**
+ * @brief   allocate a new trie holding only an empty root
+ * @param   alphabet the letters of the words, kept by the caller for the
+ *          life of the trie
+ * @param   pooled true - take the nodes from slabs, false - allocate them
+ *          node by node
+ * @param   huge true - map the slabs from huge pages, false - allocate them
+ * @return  a pointer to the new trie, NULL if memory could not be
+ *          allocated
+ */
+static Trie*
+trieAllocate(const Alphabet* alphabet,
+             bool pooled,
+             bool huge)
+{
+
+    Trie* trie;
+
+    trie = calloc(1, sizeof(*trie));
+    if (!trie) {
+        return (NULL);
+    }
+
+    trie->alphabet = alphabet;
+    trie->huge = huge;
+    trie->nodes = 0;
+    trie->nodeSize = sizeof(TrieNode) + alphabet->size * sizeof(TrieNode*);
+
+    if (pooled) {
+
+        trie->pool = trieSlabNew(trie, TRIE_SLAB);
+
+        if (!trie->pool) {
+            free(trie);
+            return (NULL);
+        }
+
+        trie->slab = trie->pool;
+        trie->slabUsed = 0;
+
+    }
+
+    trie->root = trieNodeNew(trie);
+
+    if (!trie->root) {
+        if (trie->pool) {
+            trieSlabFree(trie->pool);
+        }
+        free(trie);
+        return (NULL);
+    }
+
+    return (trie);
+
+}
+
+/**
+ * @brief   determine if a node lies within the block of the last re-layout
+ * @param   trie the trie
+ * @param   node the node
+ * @return  true - the node belongs to the block, false - it was allocated
+ *          on its own
+ */
+static bool
+trieBlockHas(const Trie* trie,
+             const TrieNode* node)
+{
+
+    uintptr_t address = (uintptr_t) node;
+    uintptr_t start = (uintptr_t) trie->block;
+
+    return (trie->block && address >= start
+            && address < start + trie->blockSize * trie->nodeSize);
+
+}
+
+/**
+ * @brief   convert a subtree maximum into a bound on its frequencies
+ * @param   max the subtree maximum
+ * @return  the bound, unlimited once a frequency in the subtree is promoted
+ */
+static uint64_t
+trieBound(uint32_t max)
+{
+
+    return ((max == UINT32_MAX) ? UINT64_MAX : max);
+
+}
+
+/**
+ * @brief   count a word at the end of its path
+ * @details the maximum frequency of every subtree along the path is kept
+ *          up to date;  The maxima never increase going down the path, so
+ *          only a trailing run of nodes sharing the terminal node's maximum
+ *          can need raising and only that run is walked a second time;  A
+ *          node of the run already raised past the word by another word of
+ *          a batch is left alone
+ * @param   trie the trie
+ * @param   node the terminal node of the word
+ * @param   run the first node of the trailing run of equal maxima
+ * @param   from the rest of the word below the run
+ * @return  0 - success, -1 - failure, the frequency could not be promoted
+ */
+static inline int
+trieCount(Trie* trie,
+          TrieNode* node,
+          TrieNode* run,
+          const char* from)
+{
+
+    if (counterIncrement(&trie->wide, &node->frequency) == -1) {
+        return (-1);
+    }
+
+    /* A promoted frequency saturates the subtree maxima. */
+    uint32_t bound = (node->frequency < COUNTER_WIDE) ? node->frequency
+                                                      : UINT32_MAX;
+
+    /* The word now bounds its own subtree, raise the trailing run. */
+    if (node->max < bound) {
+
+        for (TrieNode* raise = run; ; from++) {
+
+            if (raise->max < bound) {
+                raise->max = bound;
+            }
+
+            if (*from == '\0') {
+                break;
+            }
+
+            raise = raise->child[alphabetIndex(trie->alphabet, *from)];
+
+        }
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   find the terminal node of a word, adding the missing nodes
+ * @param   trie the trie
+ * @param   word pointer to the word
+ * @param   create true - add the missing nodes, false - fail instead
+ * @param   run the first node of the trailing run of equal maxima
+ * @param   from the rest of the word below the run
+ * @return  a pointer to the terminal node, NULL if a node is missing or
+ *          could not be allocated
+ */
+static inline TrieNode*
+trieDescend(Trie* trie,
+            const char* word,
+            bool create,
+            TrieNode** run,
+            const char** from)
+{
+
+    TrieNode* node;
+
+    *run = trie->root;
+    *from = word;
+
+    for (node = trie->root; *word != '\0'; word++) {
+
+        uint32_t i = alphabetIndex(trie->alphabet, *word);
+
+        if (!node->child[i]) {
+            if (!create) {
+                return (NULL);
+            }
+            node->child[i] = trieNodeNew(trie);
+            if (!node->child[i]) {
+                return (NULL);
+            }
+        }
+
+        TrieNode* child = node->child[i];
+
+        if (child->max != node->max) {
+            *run = child;
+            *from = word + 1;
+        }
+
+        node = child;
+
+    }
+
+    return (node);
+
+}
+
+/**
+ * @brief   find the node of a word
+ * @param   trie the trie
+ * @param   word pointer to the word to be found
+ * @return  a pointer to the trie node of the word, NULL if the word was
+ *          never inserted
+ */
+TrieNode*
+trieFind(Trie* trie,
+         const char* word)
+{
+
+    TrieNode* node = trie->root;
+
+    for (const char* traverse = word; *traverse != '\0' && node; traverse++) {
+
+        if (alphabetIndex(trie->alphabet, *traverse) == ALPHABET_NONE) {
+            return (NULL);
+        }
+
+        node = node->child[alphabetIndex(trie->alphabet, *traverse)];
+
+    }
+
+    return (node);
+
+}
+
+/**
+ * @brief   release a trie object and all of its nodes
+ * @param   trie the trie to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+trieFree(Trie* trie)
+{
+
+    /* The nodes of a pooled trie are released with their slabs. */
+    if (!trie->pool) {
+        trieNodeFree(trie, trie->root, false);
+    }
+
+    trieSpareFree(trie);
+
+    while (trie->pool) {
+        TrieSlab* slab = trie->pool;
+        trie->pool = slab->next;
+        trieSlabFree(slab);
+    }
+
+    counterFree(&trie->wide);
+    free(trie->block);
+    free(trie);
+
+    return (0);
+
+}
+
 /**
  * @brief   insert a word into a trie
- * @param   trie trie root
+ * @param   trie the trie
  * @param   word pointer to the word to be inserted
- * @return  a pointer to the trie node containing the word
+ * @return  a pointer to the trie node containing the word, NULL if a node
+ *          could not be allocated or its frequency could not be promoted
  */
 TrieNode*
-trieInsert(TrieNode* trie,
+trieInsert(Trie* trie,
            const char* word)
 {
 
-    const char* traverse = word;
-    TrieNode* node;
+    TrieNode* run;
+    const char* from;
+    TrieNode* node = trieDescend(trie, word, true, &run, &from);
+
+    if (!node || trieCount(trie, node, run, from) == -1) {
+        return (NULL);
+    }
+
+    return (node);
 
-    for (node = trie; *traverse != '\0'; traverse++) {
+}
+
+/**
+ * @brief   insert a batch of words into a trie
+ * @details inserting a word is a chain of dependent loads, one node per
+ *          letter, which stalls on memory once the trie outgrows the
+ *          caches;  The paths of the words are walked together, one level
+ *          of each word in turn, prefetching the next node of a word before
+ *          moving on to the next word, so that the cache misses of the
+ *          words overlap (asynchronous memory access chaining).  Each word
+ *          keeps its terminal node and the trailing run of equal maxima
+ *          seen on the way down and is then counted from there, in order,
+ *          without walking its path again.  A word repeated within the
+ *          batch has been counted since its run was seen, its run is taken
+ *          from the root instead
+ * @param   trie the trie
+ * @param   words the words to be inserted
+ * @param   count the number of words, at most TRIE_BATCH_MAX
+ * @param   nodes the trie nodes containing the words, in order
+ * @return  0 - success, -1 - failure, a node could not be allocated or a
+ *          frequency could not be promoted
+ */
+int
+trieInsertBatch(Trie* trie,
+                const char* const* words,
+                uint32_t count,
+                TrieNode** nodes)
+{
+
+    const char* rest[TRIE_BATCH_MAX];
+    TrieNode* run[TRIE_BATCH_MAX];
+    const char* from[TRIE_BATCH_MAX];
+    uint32_t above[TRIE_BATCH_MAX];
+    uint32_t seen[TRIE_BATCH_MAX];
+
+    for (uint32_t word = 0; word < count; word++) {
+        nodes[word] = trie->root;
+        rest[word] = words[word];
+        run[word] = trie->root;
+        from[word] = words[word];
+        above[word] = trie->root->max;
+    }
+
+    for (uint32_t active = count; active != 0; ) {
+
+        for (uint32_t word = 0; word < count; word++) {
+
+            if (!rest[word]) {
+                continue;
+            }
+
+            /* The node was fetched a round ago, compare it to its parent. */
+            TrieNode* node = nodes[word];
+
+            if (node->max != above[word]) {
+                run[word] = node;
+                from[word] = rest[word];
+            }
+
+            above[word] = node->max;
+
+            /* The path is walked, keep the frequency its run was seen at. */
+            if (*rest[word] == '\0') {
+                seen[word] = node->frequency;
+                rest[word] = NULL;
+                active--;
+                continue;
+            }
+
+            uint32_t i = alphabetIndex(trie->alphabet, *rest[word]++);
+            TrieNode* child = node->child[i];
 
-        if (!node->child[tolower(*traverse)-'a']) {
-            node->child[tolower(*traverse)-'a'] = trieNodeNew();
+            if (!child) {
+                child = trieNodeNew(trie);
+                if (!child) {
+                    return (-1);
+                }
+                node->child[i] = child;
+            }
+
+            /* Fetch the node and its next child while the others advance. */
+            __builtin_prefetch(child);
+
+            if (*rest[word] != '\0') {
+                i = alphabetIndex(trie->alphabet, *rest[word]);
+                __builtin_prefetch(&child->child[i]);
+            }
+
+            nodes[word] = child;
+
+        }
+
+    }
+
+    for (uint32_t word = 0; word < count; word++) {
+
+        if (nodes[word]->frequency != seen[word]) {
+            run[word] = trie->root;
+            from[word] = words[word];
         }
 
-        node = node->child[tolower(*traverse)-'a'];
+        if (trieCount(trie, nodes[word], run[word], from[word]) == -1) {
+            return (-1);
+        }
 
     }
 
-    /*
-     * At this point the terminating node in the trie has been reached
-     * and the word and frequency can be inserted or updated.
-     */
-    node->frequency++;
+    return (0);
+
+}
+
+/**
+ * @brief   count a word only if it was counted before
+ * @details no node is added, so words can be kept elsewhere until they are
+ *          worth a path of their own
+ * @param   trie the trie
+ * @param   word pointer to the word to be counted
+ * @return  a pointer to the trie node containing the word, NULL if the word
+ *          has no frequency yet or its frequency could not be promoted
+ */
+TrieNode*
+trieInsertFound(Trie* trie,
+                const char* word)
+{
+
+    TrieNode* run;
+    const char* from;
+    TrieNode* node = trieDescend(trie, word, false, &run, &from);
+
+    if (!node || node->frequency == 0
+        || trieCount(trie, node, run, from) == -1) {
+        return (NULL);
+    }
 
     return (node);
 
 }
 
 /**
- * @brief   allocate and initialize a new Trie Node from the heap
- * @param   none
- * @return  a pointer to a new Trie Node
+ * @brief   insert a word into a trie, counting it once per stamp
+ * @details the frequency becomes the number of distinct stamps the word
+ *          was inserted with, such as the documents containing it;  Each
+ *          node remembers the last stamp, so the stamps must not return
+ * @param   trie the trie
+ * @param   word pointer to the word to be inserted
+ * @param   stamp the stamp of the insertion
+ * @param   counted set to true if the word was counted, false if it was
+ *          already inserted with the stamp
+ * @return  a pointer to the trie node containing the word, NULL if a node
+ *          could not be allocated or its frequency could not be promoted
  */
 TrieNode*
-trieNodeNew(void)
+trieInsertOnce(Trie* trie,
+               const char* word,
+               uint32_t stamp,
+               bool* counted)
 {
 
-    TrieNode* node;
+    TrieNode* run;
+    const char* from;
+    TrieNode* node = trieDescend(trie, word, true, &run, &from);
 
-    node = calloc(1, sizeof(*node));
+    if (!node) {
+        return (NULL);
+    }
 
-    node->frequency = 0;
-    node->index = -1;
+    *counted = (node->stamp != stamp);
+
+    if (*counted) {
+        node->stamp = stamp;
+        if (trieCount(trie, node, run, from) == -1) {
+            return (NULL);
+        }
+    }
 
     return (node);
 
 }
 
+/**
+ * @brief   determine if one query item ranks below another
+ * @details items rank by value and then in lexicographical order of their
+ *          text;  A subtree item ranks as if its prefix were followed by a
+ *          character larger than any letter, so that it is expanded before
+ *          any word of equal value which one of its words could outrank
+ * @param   queue the queue holding the item text
+ * @param   a the first item
+ * @param   b the second item
+ * @return  true - a ranks below b, false - otherwise
+ */
+static bool
+trieItemLess(const TrieQueue* queue,
+             const TrieItem* a,
+             const TrieItem* b)
+{
+
+    if (a->value != b->value) {
+        return (a->value < b->value);
+    }
+
+    uint32_t length = (a->length < b->length) ? a->length : b->length;
+    int compare = memcmp(queue->text->base + a->text,
+                         queue->text->base + b->text,
+                         length);
+
+    if (compare != 0) {
+        return (compare < 0);
+    }
+
+    /* One text is a prefix of the other. */
+    if (a->length == b->length) {
+        return (!a->subtree && b->subtree);
+    }
+
+    if (a->length < b->length) {
+        return (!a->subtree);
+    }
+
+    return (b->subtree);
+
+}
+
+/**
+ * @brief   take the node with the highest subtree maximum from a work list
+ * @param   work the work list, a binary heap by subtree maximum
+ * @param   count the number of nodes within the work list
+ * @return  the node and the pointer to it
+ */
+static TrieMove
+trieMovePop(TrieMove* work,
+            size_t* count)
+{
+
+    TrieMove top = work[0];
+    TrieMove last = work[--*count];
+    size_t parent = 0;
+
+    for (;;) {
+
+        size_t child = 2 * parent + 1;
+
+        if (child >= *count) {
+            break;
+        }
+
+        if (child + 1 < *count
+            && work[child+1].node->max > work[child].node->max) {
+            child++;
+        }
+
+        if (work[child].node->max <= last.node->max) {
+            break;
+        }
+
+        work[parent] = work[child];
+        parent = child;
+
+    }
+
+    if (*count > 0) {
+        work[parent] = last;
+    }
+
+    return (top);
+
+}
+
+/**
+ * @brief   add a node to a work list ordered by subtree maximum
+ * @param   work the work list, a binary heap by subtree maximum
+ * @param   count the number of nodes within the work list
+ * @param   node the node at its old address
+ * @param   slot the pointer to the node
+ * @return  none
+ */
+static void
+trieMovePush(TrieMove* work,
+             size_t* count,
+             TrieNode* node,
+             TrieNode** slot)
+{
+
+    size_t child = (*count)++;
+
+    while (child > 0 && work[(child - 1) / 2].node->max < node->max) {
+        work[child] = work[(child - 1) / 2];
+        child = (child - 1) / 2;
+    }
+
+    work[child] = (TrieMove) { .node = node, .slot = slot };
+
+}
+
+/**
+ * @brief   allocate a new, empty trie object
+ * @param   alphabet the letters of the words, kept by the caller for the
+ *          life of the trie
+ * @return  a pointer to the newly allocated trie object, NULL if memory
+ *          could not be allocated
+ */
+Trie*
+trieNew(const Alphabet* alphabet)
+{
+
+    return (trieAllocate(alphabet, false, false));
+
+}
+
+/**
+ * @brief   allocate a new, empty pooled trie object
+ * @details the nodes are handed out in turn from slabs which are kept
+ *          until the trie is released, so trieReset() empties the trie in
+ *          constant time by rewinding the slabs instead of releasing node
+ *          by node;  Suits counting many small inputs one after the other,
+ *          and taking the nodes from huge pages
+ * @param   alphabet the letters of the words, kept by the caller for the
+ *          life of the trie
+ * @param   huge true - map the slabs from huge pages, with fewer TLB misses
+ *          on the path of a word, false - allocate them
+ * @return  a pointer to the newly allocated trie object, NULL if memory
+ *          could not be allocated
+ */
+Trie*
+trieNewPooled(const Alphabet* alphabet,
+              bool huge)
+{
+
+    return (trieAllocate(alphabet, true, huge));
+
+}
+
+/**
+ * @brief   release a subtree of trie nodes
+ * @details the subtree is walked without recursion or extra memory by
+ *          temporarily reversing the child pointers (Deutsch-Schorr-Waite);
+ *          The frequency of each node on the path records which child is
+ *          being released, so words of any length can be released
+ * @param   trie the trie owning the nodes
+ * @param   node the root of the subtree to be released
+ * @param   keep true - keep the nodes for reuse, false - free them
+ * @return  none
+ */
+static void
+trieNodeFree(Trie* trie,
+             TrieNode* node,
+             bool keep)
+{
+
+    TrieNode* parent = NULL;
+
+    node->frequency = 0;
+
+    while (node) {
+
+        uint32_t i = node->frequency;
+
+        while (i < trie->alphabet->size && !node->child[i]) {
+            i++;
+        }
+
+        /* Descend into the next child, pointing it back at the parent. */
+        if (i < trie->alphabet->size) {
+
+            TrieNode* child = node->child[i];
+
+            node->child[i] = parent;
+            node->frequency = i;
+
+            parent = node;
+            node = child;
+            node->frequency = 0;
+
+            continue;
+
+        }
+
+        /* Every child has been released, release the node itself. */
+        if (keep) {
+            node->child[0] = trie->spare;
+            trie->spare = node;
+        }
+        else if (!trieNodeOwned(trie, node)) {
+            free(node);
+        }
+
+        trie->nodes--;
+
+        node = parent;
+
+        if (node) {
+            i = node->frequency;
+            parent = node->child[i];
+            node->child[i] = NULL;
+            node->frequency = i + 1;
+        }
+
+    }
+
+}
+
+/**
+ * @brief   allocate and initialize a new Trie Node from the heap
+ * @param   trie the trie the node belongs to
+ * @return  a pointer to a new Trie Node, NULL if memory could not be
+ *          allocated
+ */
+TrieNode*
+trieNodeNew(Trie* trie)
+{
+
+    TrieNode* node;
+
+    /* Reuse a released node when there is one. */
+    if (trie->spare) {
+        node = trie->spare;
+        trie->spare = node->child[0];
+        memset(node, 0, trie->nodeSize);
+    }
+    /* Then the room left in the block of the last re-layout. */
+    else if (trie->blockUsed < trie->blockSize) {
+        node = (TrieNode*) ((char*) trie->block
+                            + trie->blockUsed++ * trie->nodeSize);
+    }
+    /* Then the next node of the slabs, adding a larger slab if used up. */
+    else if (trie->pool) {
+
+        if (trie->slabUsed == trie->slab->size) {
+
+            if (!trie->slab->next) {
+
+                TrieSlab* slab = trieSlabNew(trie, 2 * trie->slab->size);
+
+                if (!slab) {
+                    return (NULL);
+                }
+
+                trie->slab->next = slab;
+
+            }
+
+            trie->slab = trie->slab->next;
+            trie->slabUsed = 0;
+
+        }
+
+        node = (TrieNode*) (trie->slab->node
+                            + trie->slabUsed++ * trie->nodeSize);
+        memset(node, 0, trie->nodeSize);
+
+    }
+    else {
+        node = calloc(1, trie->nodeSize);
+        if (!node) {
+            return (NULL);
+        }
+    }
+
+    node->frequency = 0;
+    node->index = -1;
+    node->word = 0;
+    node->max = 0;
+
+    trie->nodes++;
+
+    return (node);
+
+}
+
+/**
+ * @brief   determine if a node is released along with its trie
+ * @param   trie the trie
+ * @param   node the node
+ * @return  true - the node belongs to a slab or to the block of the last
+ *          re-layout, false - it was allocated on its own
+ */
+static bool
+trieNodeOwned(const Trie* trie,
+              const TrieNode* node)
+{
+
+    return (trie->pool || trieBlockHas(trie, node));
+
+}
+
+/**
+ * @brief   remove the highest ranking item from a query queue
+ * @param   queue the queue to be popped
+ * @param   item the removed item
+ * @return  none
+ */
+static void
+trieQueuePop(TrieQueue* queue,
+             TrieItem* item)
+{
+
+    *item = queue->vector[0];
+    queue->vector[0] = queue->vector[--queue->count];
+
+    uint32_t index = 0;
+
+    for (;;) {
+
+        uint32_t left = 2*index + 1;
+        uint32_t right = left + 1;
+        uint32_t maximum = index;
+
+        if (left < queue->count
+            && trieItemLess(queue, &queue->vector[maximum],
+                            &queue->vector[left])) {
+            maximum = left;
+        }
+
+        if (right < queue->count
+            && trieItemLess(queue, &queue->vector[maximum],
+                            &queue->vector[right])) {
+            maximum = right;
+        }
+
+        if (maximum == index) {
+            break;
+        }
+
+        TrieItem swap = queue->vector[maximum];
+        queue->vector[maximum] = queue->vector[index];
+        queue->vector[index] = swap;
+
+        index = maximum;
+
+    }
+
+}
+
+/**
+ * @brief   add an item to a query queue
+ * @param   queue the queue receiving the item
+ * @param   item the item to be added
+ * @return  0 - success, -1 - failure
+ */
+static int
+trieQueuePush(TrieQueue* queue,
+              const TrieItem* item)
+{
+
+    if (queue->count == queue->size) {
+
+        uint32_t size = (queue->size != 0) ? 2 * queue->size : 64;
+        TrieItem* vector = realloc(queue->vector, size * sizeof(*vector));
+
+        if (!vector) {
+            return (-1);
+        }
+
+        queue->size = size;
+        queue->vector = vector;
+
+    }
+
+    uint32_t index = queue->count++;
+
+    while (index != 0) {
+
+        uint32_t parent = (index - 1) / 2;
+
+        if (!trieItemLess(queue, &queue->vector[parent], item)) {
+            break;
+        }
+
+        queue->vector[index] = queue->vector[parent];
+        index = parent;
+
+    }
+
+    queue->vector[index] = *item;
+
+    return (0);
+
+}
+
+/**
+ * @brief   move every node of a trie into one block in a cache friendly order
+ * @details nodes are allocated as words arrive, so the nodes of the frequent
+ *          words end up scattered across the heap;  The nodes are copied into
+ *          a new block either level by level, or hottest first by subtree
+ *          maximum so that the nodes on the paths of the frequent words
+ *          share cache lines and pages.  The block has room
+ *          for a quarter more nodes, which are handed out before allocating
+ *          from the heap again
+ * @param   trie the trie
+ * @param   order the order of the nodes within the block
+ * @param   func the function called with every moved node which is in the
+ *          heap, so its entry can follow, NULL for none
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure, memory could not be allocated and the
+ *          trie is unchanged
+ */
+int
+trieRelayout(Trie* trie,
+             TrieOrder order,
+             TrieMoveFunc* func,
+             void* argument)
+{
+
+    /* The spare nodes are not part of the trie and are not moved. */
+    trieSpareFree(trie);
+
+    size_t count = trie->nodes;
+    size_t size = count + count / 4;
+    TrieNode* block = calloc(size, trie->nodeSize);
+    TrieMove* work = malloc(count * sizeof(*work));
+
+    if (!block || !work) {
+        free(block);
+        free(work);
+        return (-1);
+    }
+
+    /*
+     * The work list is a queue for the breadth first order and a priority
+     * queue by subtree maximum for the hot order.  Each node is copied when
+     * it is taken from the list, the pointer to it is updated and the old
+     * node is released.  A subtree maximum never exceeds the maximum of its
+     * parent, so the hot order places the nodes on the paths of the most
+     * frequent words first, packed into as few cache lines as possible.
+     */
+    size_t head = 0;
+    size_t tail = 0;
+    size_t used = 0;
+
+    trieMovePush(work, &tail, trie->root, &trie->root);
+
+    while (head < tail) {
+
+        TrieMove move = (order == TRIE_BREADTH) ? work[head++]
+                                                : trieMovePop(work, &tail);
+        TrieNode* node = (TrieNode*) ((char*) block + used++ * trie->nodeSize);
+
+        memcpy(node, move.node, trie->nodeSize);
+        *move.slot = node;
+
+        if (!trieNodeOwned(trie, move.node)) {
+            free(move.node);
+        }
+
+        if (node->index != -1 && func) {
+            func(argument, node);
+        }
+
+        for (uint32_t i = 0; i < trie->alphabet->size; i++) {
+            if (node->child[i]) {
+                if (order == TRIE_BREADTH) {
+                    work[tail++] = (TrieMove) {
+                        .node = node->child[i],
+                        .slot = &node->child[i],
+                    };
+                }
+                else {
+                    trieMovePush(work, &tail, node->child[i],
+                                 &node->child[i]);
+                }
+            }
+        }
+
+    }
+
+    assert(used == count);
+
+    free(work);
+    free(trie->block);
+
+    trie->block = block;
+    trie->blockSize = size;
+    trie->blockUsed = used;
+
+    return (0);
+
+}
+
+/**
+ * @brief   remove the nodes of a word which is no longer counted
+ * @details the word's node and the chain of nodes above it which hold no
+ *          other word and lead to no other word are released;  Nothing is
+ *          released while the word still has a frequency or a subtree
+ * @param   trie the trie
+ * @param   word pointer to the word to be removed
+ * @return  0 - success, -1 - failure, the word is not within the trie
+ */
+int
+trieRemove(Trie* trie,
+           const char* word)
+{
+
+    TrieNode* node = trie->root;
+
+    /* The lowest node on the path which must be kept and its branch. */
+    TrieNode* keep = node;
+    uint32_t branch = 0;
+
+    for (const char* traverse = word; *traverse != '\0'; traverse++) {
+
+        uint32_t i = alphabetIndex(trie->alphabet, *traverse);
+
+        if (i == ALPHABET_NONE || !node->child[i]) {
+            return (-1);
+        }
+
+        /* A node holding a word or leading to another word is kept. */
+        if (node == trie->root || node->frequency != 0) {
+            keep = node;
+            branch = i;
+        }
+        else {
+            for (uint32_t j = 0; j < trie->alphabet->size; j++) {
+                if (j != i && node->child[j]) {
+                    keep = node;
+                    branch = i;
+                    break;
+                }
+            }
+        }
+
+        node = node->child[i];
+
+    }
+
+    if (node == trie->root || node->frequency != 0) {
+        return (0);
+    }
+
+    for (uint32_t j = 0; j < trie->alphabet->size; j++) {
+        if (node->child[j]) {
+            return (0);
+        }
+    }
+
+    /* The released nodes form a single path, keep them for reuse. */
+    TrieNode* chain = keep->child[branch];
+
+    keep->child[branch] = NULL;
+
+    while (chain) {
+
+        TrieNode* next = NULL;
+
+        for (uint32_t j = 0; j < trie->alphabet->size && !next; j++) {
+            next = chain->child[j];
+        }
+
+        chain->child[0] = trie->spare;
+        trie->spare = chain;
+        trie->nodes--;
+
+        chain = next;
+
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   release every node of a trie, leaving an empty root
+ * @details the nodes are kept for reuse;  A pooled trie is emptied in
+ *          constant time by rewinding its slabs
+ * @param   trie the trie to be emptied
+ * @return  0 - success, -1 - failure
+ */
+int
+trieReset(Trie* trie)
+{
+
+    if (trie->pool) {
+
+        trie->spare = NULL;
+        trie->blockUsed = 0;
+        trie->slab = trie->pool;
+        trie->slabUsed = 0;
+        trie->nodes = 0;
+        trie->root = trieNodeNew(trie);
+
+        counterReset(&trie->wide);
+
+        return (0);
+
+    }
+
+    TrieNode* root = trie->root;
+
+    for (uint32_t i = 0; i < trie->alphabet->size; i++) {
+        if (root->child[i]) {
+            trieNodeFree(trie, root->child[i], true);
+            root->child[i] = NULL;
+        }
+    }
+
+    root->frequency = 0;
+    root->index = -1;
+    root->word = 0;
+    root->max = 0;
+
+    counterReset(&trie->wide);
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a slab of nodes
+ * @param   slab the slab
+ * @return  none
+ */
+static void
+trieSlabFree(TrieSlab* slab)
+{
+
+    if (slab->mapped) {
+        pageFree(slab, slab->mapped);
+    }
+    else {
+        free(slab);
+    }
+
+}
+
+/**
+ * @brief   allocate a slab of nodes for a pooled trie
+ * @details a slab mapped from huge pages holds as many nodes as fit its
+ *          whole pages
+ * @param   trie the trie
+ * @param   size the number of nodes needed
+ * @return  a pointer to the new slab, NULL if memory could not be allocated
+ */
+static TrieSlab*
+trieSlabNew(const Trie* trie,
+            size_t size)
+{
+
+    size_t bytes = sizeof(TrieSlab) + size * trie->nodeSize;
+    size_t mapped = 0;
+    TrieSlab* slab = trie->huge ? pageAlloc(bytes, &mapped) : malloc(bytes);
+
+    if (!slab) {
+        return (NULL);
+    }
+
+    slab->next = NULL;
+    slab->size = mapped ? (mapped - sizeof(*slab)) / trie->nodeSize : size;
+    slab->mapped = mapped;
+
+    return (slab);
+
+}
+
+/**
+ * @brief   release the nodes kept for reuse by trieRemove() and trieReset()
+ * @param   trie the trie
+ * @return  none
+ */
+static void
+trieSpareFree(Trie* trie)
+{
+
+    while (trie->spare) {
+        TrieNode* node = trie->spare;
+        trie->spare = node->child[0];
+        if (!trieNodeOwned(trie, node)) {
+            free(node);
+        }
+    }
+
+}
+
+/**
+ * @brief   report the most frequent words starting with a prefix
+ * @details performs a best-first search ordered by the subtree maxima, so
+ *          whole branches which cannot contain one of the top words are
+ *          never visited;  Words are reported by descending frequency and
+ *          words of equal frequency in reverse lexicographical order
+ * @param   trie the trie
+ * @param   prefix the prefix every reported word starts with, "" for all
+ * @param   count the maximum number of words to report
+ * @param   func the function called for each word, in rank order
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure
+ */
+int
+trieTop(Trie* trie,
+        const char* prefix,
+        uint32_t count,
+        TrieTopFunc* func,
+        void* argument)
+{
+
+    TrieNode* node = trie->root;
+
+    /* Find the subtree of the prefix, which may not be in the trie. */
+    for (const char* traverse = prefix; *traverse != '\0'; traverse++) {
+
+        if (alphabetIndex(trie->alphabet, *traverse) == ALPHABET_NONE) {
+            return (0);
+        }
+
+        node = node->child[alphabetIndex(trie->alphabet, *traverse)];
+
+        if (!node) {
+            return (0);
+        }
+
+    }
+
+    if (node->max == 0 || count == 0) {
+        return (0);
+    }
+
+    TrieQueue queue = {
+        .count = 0,
+        .size = 0,
+        .vector = NULL,
+        .text = arenaNew(4096),
+    };
+
+    /* Scratch space for composing the text of a child item. */
+    size_t length = strlen(prefix);
+    size_t scratchSize = length + 2;
+    char* scratch = malloc(scratchSize);
+
+    if (!queue.text || !scratch) {
+        free(scratch);
+        if (queue.text) {
+            arenaFree(queue.text);
+        }
+        return (-1);
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        scratch[i] = trie->alphabet->fold[(unsigned char) prefix[i]];
+    }
+
+    TrieItem item = {
+        .node = node,
+        .value = trieBound(node->max),
+        .text = arenaAppend(queue.text, scratch, length),
+        .length = length,
+        .subtree = true,
+    };
+
+    int status = (item.text != 0) ? trieQueuePush(&queue, &item) : -1;
+
+    while (count != 0 && queue.count != 0 && status == 0) {
+
+        trieQueuePop(&queue, &item);
+
+        /* A word outranks everything left in the queue, report it. */
+        if (!item.subtree) {
+            status = func(argument, queue.text->base + item.text,
+                          item.value);
+            count--;
+            continue;
+        }
+
+        /* Expand the subtree into its own word and its child subtrees. */
+        TrieNode* expand = item.node;
+
+        if (expand->frequency != 0) {
+            TrieItem word = item;
+            word.value = counterValue(&trie->wide, expand->frequency);
+            word.subtree = false;
+            status = trieQueuePush(&queue, &word);
+        }
+
+        if (item.length + 2 > scratchSize) {
+
+            char* grown = realloc(scratch, 2 * (item.length + 2));
+
+            if (!grown) {
+                status = -1;
+                break;
+            }
+
+            scratch = grown;
+            scratchSize = 2 * (item.length + 2);
+
+        }
+
+        memcpy(scratch, queue.text->base + item.text, item.length);
+
+        for (uint32_t i = 0; i < trie->alphabet->size && status == 0; i++) {
+
+            TrieNode* child = expand->child[i];
+
+            if (!child || child->max == 0) {
+                continue;
+            }
+
+            scratch[item.length] = trie->alphabet->letter[i];
+            length = item.length + 1;
+
+            /*
+             * Follow a chain of nodes without words and with a single
+             * child, so that long words are copied once rather than once
+             * per letter.
+             */
+            while (child->frequency == 0 && status == 0) {
+
+                uint32_t only = trie->alphabet->size;
+
+                for (uint32_t j = 0; j < trie->alphabet->size; j++) {
+                    if (child->child[j]) {
+                        if (only != trie->alphabet->size) {
+                            only = trie->alphabet->size;
+                            break;
+                        }
+                        only = j;
+                    }
+                }
+
+                if (only == trie->alphabet->size) {
+                    break;
+                }
+
+                if (length + 2 > scratchSize) {
+
+                    char* grown = realloc(scratch, 2 * (length + 2));
+
+                    if (!grown) {
+                        status = -1;
+                        break;
+                    }
+
+                    scratch = grown;
+                    scratchSize = 2 * (length + 2);
+
+                }
+
+                scratch[length++] = trie->alphabet->letter[only];
+                child = child->child[only];
+
+            }
+
+            if (status != 0) {
+                break;
+            }
+
+            TrieItem branch = {
+                .node = child,
+                .value = trieBound(child->max),
+                .text = arenaAppend(queue.text, scratch, length),
+                .length = length,
+                .subtree = true,
+            };
+
+            status = (branch.text != 0)
+                     ? trieQueuePush(&queue, &branch) : -1;
+
+        }
+
+    }
+
+    free(scratch);
+    free(queue.vector);
+    arenaFree(queue.text);
+
+    return (status);
+
+}
+
+/**
+ * @brief   visit every word of a trie in lexicographical order
+ * @details the walk keeps its own stack rather than recursing, so words
+ *          of any length can be visited
+ * @param   trie the trie
+ * @param   func the function called with each word and its frequency, the
+ *          walk stops when it fails
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure, memory could not be allocated or the
+ *          function failed
+ */
+int
+trieWalk(Trie* trie,
+         TrieTopFunc* func,
+         void* argument)
+{
+
+    /* Per level the node, the next child to visit and the letter. */
+    size_t size = 64;
+    TrieNode** stack = malloc(size * sizeof(*stack));
+    uint8_t* next = malloc(size);
+    char* word = malloc(size + 1);
+
+    int status = 0;
+
+    if (!stack || !next || !word) {
+        status = -1;
+    }
+
+    size_t depth = 0;
+
+    if (status == 0) {
+        stack[0] = trie->root;
+        next[0] = 0;
+    }
+
+    while (status == 0) {
+
+        TrieNode* node = stack[depth];
+        uint32_t i = next[depth];
+
+        while (i < trie->alphabet->size && !node->child[i]) {
+            i++;
+        }
+
+        /* Every child has been visited, return to the parent. */
+        if (i == trie->alphabet->size) {
+            if (depth == 0) {
+                break;
+            }
+            depth--;
+            continue;
+        }
+
+        next[depth] = i + 1;
+
+        if (depth + 1 == size) {
+
+            size *= 2;
+
+            TrieNode** grownStack = realloc(stack, size * sizeof(*stack));
+            if (grownStack) {
+                stack = grownStack;
+            }
+
+            uint8_t* grownNext = realloc(next, size);
+            if (grownNext) {
+                next = grownNext;
+            }
+
+            char* grownWord = realloc(word, size + 1);
+            if (grownWord) {
+                word = grownWord;
+            }
+
+            if (!grownStack || !grownNext || !grownWord) {
+                status = -1;
+                break;
+            }
+
+        }
+
+        word[depth++] = trie->alphabet->letter[i];
+        stack[depth] = node->child[i];
+        next[depth] = 0;
+
+        if (stack[depth]->frequency != 0) {
+            word[depth] = '\0';
+            status = func(argument, word,
+                          counterValue(&trie->wide, stack[depth]->frequency));
+        }
+
+    }
+
+    free(stack);
+    free(next);
+    free(word);
+
+    return (status);
+
+}
+
+/**
+ * @brief   visit every word of either of two tries in lexicographical order
+ * @details both tries are walked in lockstep, a child of one without its
+ *          counterpart in the other is walked on its own;  The tries must
+ *          share the alphabet, that of the first is used
+ * @param   first the first trie
+ * @param   second the second trie
+ * @param   func the function called with each word and its frequency in
+ *          each trie, 0 where it is missing, the walk stops when it fails
+ * @param   argument the argument passed through to the function
+ * @return  0 - success, -1 - failure, memory could not be allocated or the
+ *          function failed
+ */
+int
+trieWalkPair(Trie* first,
+             Trie* second,
+             TriePairFunc* func,
+             void* argument)
+{
+
+    /* Per level the node of each trie, the next child and the letter. */
+    size_t size = 64;
+    TrieNode** stack = malloc(2 * size * sizeof(*stack));
+    uint8_t* next = malloc(size);
+    char* word = malloc(size + 1);
+
+    int status = 0;
+
+    if (!stack || !next || !word) {
+        status = -1;
+    }
+
+    size_t depth = 0;
+
+    if (status == 0) {
+        stack[0] = first->root;
+        stack[1] = second->root;
+        next[0] = 0;
+    }
+
+    while (status == 0) {
+
+        TrieNode* one = stack[2 * depth];
+        TrieNode* two = stack[2 * depth + 1];
+        uint32_t i = next[depth];
+
+        while (i < first->alphabet->size && !(one && one->child[i])
+               && !(two && two->child[i])) {
+            i++;
+        }
+
+        /* Every child has been visited, return to the parent. */
+        if (i == first->alphabet->size) {
+            if (depth == 0) {
+                break;
+            }
+            depth--;
+            continue;
+        }
+
+        next[depth] = i + 1;
+
+        if (depth + 1 == size) {
+
+            size *= 2;
+
+            TrieNode** grownStack = realloc(stack,
+                                            2 * size * sizeof(*stack));
+            if (grownStack) {
+                stack = grownStack;
+            }
+
+            uint8_t* grownNext = realloc(next, size);
+            if (grownNext) {
+                next = grownNext;
+            }
+
+            char* grownWord = realloc(word, size + 1);
+            if (grownWord) {
+                word = grownWord;
+            }
+
+            if (!grownStack || !grownNext || !grownWord) {
+                status = -1;
+                break;
+            }
+
+        }
+
+        word[depth++] = first->alphabet->letter[i];
+        one = stack[2 * depth] = one ? one->child[i] : NULL;
+        two = stack[2 * depth + 1] = two ? two->child[i] : NULL;
+        next[depth] = 0;
+
+        uint64_t frequency[2] = {
+            one ? counterValue(&first->wide, one->frequency) : 0,
+            two ? counterValue(&second->wide, two->frequency) : 0,
+        };
+
+        if (frequency[0] != 0 || frequency[1] != 0) {
+            word[depth] = '\0';
+            status = func(argument, word, frequency[0], frequency[1]);
+        }
+
+    }
+
+    free(stack);
+    free(next);
+    free(word);
+
+    return (status);
+
+}
+
 /*
  * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
  */
@@ -44,33 +44,223 @@
 
 #pragma once
 
+#include <alphabet.h>
+#include <counter.h>
+
+/**
+ * @brief   order of the nodes after a re-layout
+ */
+typedef enum {
+    TRIE_BREADTH = 0,   /** level by level, in lexicographical order */
+    TRIE_HOT,           /** by descending subtree maximum */
+} TrieOrder;
+
 enum {
-    TRIE_SIZE = 26                          /** maximum trie size */
+    TRIE_SLAB = 4096,   /** nodes in the first slab of a pooled trie */
+    TRIE_BATCH = 16,    /** words walked together by default */
+    TRIE_BATCH_MAX = 64,/** words walked together at most */
 };
 
+typedef struct Trie Trie;
 typedef struct TrieNode TrieNode;
+typedef struct TrieSlab TrieSlab;
+
+/**
+ * @brief   trie node move callback function prototype
+ */
+typedef void (TrieMoveFunc)(void* argument,
+                            TrieNode* node);
+
+/**
+ * @brief   trie query result callback function prototype
+ */
+typedef int (TrieTopFunc)(void* argument,
+                          const char* word,
+                          uint64_t frequency);
+
+/**
+ * @brief   paired trie walk callback function prototype
+ */
+typedef int (TriePairFunc)(void* argument,
+                           const char* word,
+                           uint64_t first,
+                           uint64_t second);
 
 /**
  * @brief   object representing a trie node
  */
 struct TrieNode {
-    uint32_t frequency;                     /** word frequency */
-    int32_t index;                          /** word index in heap */
-    TrieNode* child[TRIE_SIZE];             /** child nodes */
+    uint32_t frequency;                     /** word frequency, see Counter */
+    union {
+        int32_t index;                      /** word index in heap */
+        uint32_t stamp;                     /** last stamp, trieInsertOnce() */
+    };
+    union {
+        uint32_t word;                      /** word offset in heap arena */
+        uint32_t term;                      /** term number of a document */
+    };
+    uint32_t max;                           /** maximum frequency in subtree,
+                                                UINT32_MAX once promoted */
+    TrieNode* child[];                      /** child nodes, one per letter
+                                                of the alphabet */
+};
+
+/**
+ * @brief   object representing a slab of nodes of a pooled trie
+ */
+struct TrieSlab {
+    TrieSlab* next;                         /** next slab, NULL for none */
+    size_t size;                            /** number of nodes */
+    size_t mapped;                          /** bytes mapped from huge pages,
+                                                0 if allocated */
+    char node[];                            /** the nodes, each of the
+                                                trie's node size */
+};
+
+/**
+ * @brief   object representing a trie
+ */
+struct Trie {
+    const Alphabet* alphabet;               /** letters of the words, one
+                                                child per letter */
+    TrieNode* root;                         /** root node */
+    size_t nodes;                           /** number of nodes allocated */
+    size_t nodeSize;                        /** bytes of a node, with one
+                                                child per letter */
+    TrieNode* spare;                        /** removed nodes kept for reuse */
+    TrieNode* block;                        /** nodes of the last re-layout */
+    size_t blockSize;                       /** number of nodes in the block */
+    size_t blockUsed;                       /** block nodes handed out */
+    TrieSlab* pool;                         /** slabs of a pooled trie, NULL
+                                                if allocated node by node */
+    TrieSlab* slab;                         /** slab handing out nodes */
+    bool huge;                              /** slabs mapped from huge
+                                                pages */
+    size_t slabUsed;                        /** nodes of the slab handed
+                                                out */
+    Counter wide;                           /** frequencies beyond 31 bits */
 };
 
 /**
  * @brief   function prototype
  */
 TrieNode*
-trieInsert(TrieNode* trie,
+trieAdd(Trie* trie,
+        const char* word,
+        uint64_t count);
+
+/**
+ * @brief   function prototype
+ */
+TrieNode*
+trieFind(Trie* trie,
+         const char* word);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieFree(Trie* trie);
+
+/**
+ * @brief   function prototype
+ */
+TrieNode*
+trieInsert(Trie* trie,
            const char* word);
 
+/**
+ * @brief   function prototype
+ */
+int
+trieInsertBatch(Trie* trie,
+                const char* const* words,
+                uint32_t count,
+                TrieNode** nodes);
+
+/**
+ * @brief   function prototype
+ */
+TrieNode*
+trieInsertFound(Trie* trie,
+                const char* word);
+
 /**
  * @brief   function prototype
  */
 TrieNode*
-trieNodeNew(void);
+trieInsertOnce(Trie* trie,
+               const char* word,
+               uint32_t stamp,
+               bool* counted);
+
+/**
+ * @brief   function prototype
+ */
+Trie*
+trieNew(const Alphabet* alphabet);
+
+/**
+ * @brief   function prototype
+ */
+Trie*
+trieNewPooled(const Alphabet* alphabet,
+              bool huge);
+
+/**
+ * @brief   function prototype
+ */
+TrieNode*
+trieNodeNew(Trie* trie);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieRelayout(Trie* trie,
+             TrieOrder order,
+             TrieMoveFunc* func,
+             void* argument);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieRemove(Trie* trie,
+           const char* word);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieReset(Trie* trie);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieTop(Trie* trie,
+        const char* prefix,
+        uint32_t count,
+        TrieTopFunc* func,
+        void* argument);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieWalk(Trie* trie,
+         TrieTopFunc* func,
+         void* argument);
+
+/**
+ * @brief   function prototype
+ */
+int
+trieWalkPair(Trie* first,
+             Trie* second,
+             TriePairFunc* func,
+             void* argument);
 
 /*
  * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
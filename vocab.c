@@ -0,0 +1,817 @@
+/**
+ * @file vocab.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for counting against a fixed vocabulary
+ *
+ * The vocabulary is read at startup and placed under a minimal perfect hash
+ * by hash and displace (CHD):  The words are spread over buckets, and the
+ * buckets, largest first, each search for a seed which sends all of their
+ * words to free slots.  The input is then counted in this process, without
+ * the squeeze and count jobs, hashing each word as it is filtered
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <alphabet.h>
+#include <arena.h>
+#include <count.h>
+#include <heap.h>
+#include <input.h>
+#include <rank.h>
+#include <vocab.h>
+
+/**
+ * @brief   the file listing the vocabulary, NULL for none - Global
+ */
+const char* vocabFile = NULL;
+
+/*
+ * function prototypes
+ */
+static inline uint32_t
+vocabBucket(const Vocab* vocab,
+            uint64_t key);
+
+static int
+vocabBuild(Vocab* vocab,
+           VocabSlot* keys);
+
+static int
+vocabCompare(const void* a,
+             const void* b);
+
+static int
+vocabDump(Vocab* vocab,
+          FILE* ofp);
+
+static inline uint64_t
+vocabHash(uint64_t hash,
+          unsigned char letter);
+
+static inline uint64_t
+vocabKey(const Vocab* vocab,
+         uint64_t hash);
+
+static inline uint64_t
+vocabMix(uint64_t value);
+
+static inline uint32_t
+vocabPlace(const Vocab* vocab,
+           uint64_t key,
+           uint32_t seed);
+
+static inline uint32_t
+vocabRange(uint32_t value,
+           uint32_t range);
+
+static inline uint32_t
+vocabSlot(const Vocab* vocab,
+          uint64_t hash);
+
+static inline void
+vocabTally(Vocab* vocab,
+           const char* word,
+           size_t length,
+           uint64_t hash);
+
+static int
+vocabWordCompare(const void* a,
+                 const void* b);
+
+/**
+ * @brief   the FNV-1a offset basis, the hash of the empty word
+ */
+static const uint64_t vocabBasis = 14695981039346656037ULL;
+
+/**
+ * @brief   find the bucket of a word
+ * @param   vocab the vocabulary
+ * @param   key the salted key of the word
+ * @return  the bucket of the word
+ */
+static inline uint32_t
+vocabBucket(const Vocab* vocab,
+            uint64_t key)
+{
+
+    return (vocabRange(key >> 32, vocab->buckets));
+
+}
+
+/**
+ * @brief   search the seed of every bucket, placing each word at its slot
+ * @details buckets are placed largest first, while the most slots are
+ *          free;  Should a bucket find no seed, the buckets are salted
+ *          anew and placed again
+ * @param   vocab the vocabulary, its words in order of their hashes
+ * @param   keys the words of the vocabulary, placed into the slots
+ * @return  0 - success, -1 - failure
+ */
+static int
+vocabBuild(Vocab* vocab,
+           VocabSlot* keys)
+{
+
+    uint32_t n = vocab->count;
+    uint32_t* start = calloc(vocab->buckets + 1, sizeof(*start));
+    uint32_t* member = malloc(n * sizeof(*member));
+    uint32_t* order = malloc(vocab->buckets * sizeof(*order));
+    uint32_t* position = malloc(n * sizeof(*position));
+    bool* taken = malloc(n ? n : 1);
+
+    int status = -1;
+    uint32_t attempt = 0;
+
+    /* The table is not whole until every bucket found a seed. */
+    if (!start || !member || !order || !position || !taken) {
+        attempt = VOCAB_SALTS;
+    }
+
+    for (; status == -1 && attempt < VOCAB_SALTS; attempt++) {
+
+        vocab->salt = vocabMix(attempt + 1);
+
+        /* Gather the words of each bucket, start[b] ends up at its first. */
+        memset(start, 0, (vocab->buckets + 1) * sizeof(*start));
+
+        for (uint32_t i = 0; i < n; i++) {
+            start[vocabBucket(vocab, vocabKey(vocab, keys[i].hash))]++;
+        }
+
+        uint32_t largest = 0;
+
+        for (uint32_t b = 0; b < vocab->buckets; b++) {
+            largest = (start[b] > largest) ? start[b] : largest;
+            start[b] += (b > 0) ? start[b - 1] : 0;
+        }
+
+        start[vocab->buckets] = n;
+
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t b = vocabBucket(vocab, vocabKey(vocab, keys[i].hash));
+            member[--start[b]] = i;
+        }
+
+        /* Order the buckets by size, largest first. */
+        uint32_t next = 0;
+
+        for (uint32_t size = largest; size > 0; size--) {
+            for (uint32_t b = 0; b < vocab->buckets; b++) {
+                if (start[b + 1] - start[b] == size) {
+                    order[next++] = b;
+                }
+            }
+        }
+
+        memset(taken, 0, n);
+        status = 0;
+
+        for (uint32_t j = 0; j < next && status == 0; j++) {
+
+            uint32_t b = order[j];
+            uint32_t size = start[b + 1] - start[b];
+            uint32_t seed;
+
+            for (seed = 0; seed < VOCAB_SEEDS; seed++) {
+
+                uint32_t placed = 0;
+
+                /* Every word of the bucket needs a slot of its own. */
+                while (placed < size) {
+
+                    uint64_t hash = keys[member[start[b] + placed]].hash;
+                    uint32_t slot = vocabPlace(vocab, vocabKey(vocab, hash),
+                                               seed);
+
+                    if (taken[slot]) {
+                        break;
+                    }
+
+                    taken[slot] = true;
+                    position[placed++] = slot;
+
+                }
+
+                if (placed == size) {
+                    break;
+                }
+
+                while (placed > 0) {
+                    taken[position[--placed]] = false;
+                }
+
+            }
+
+            if (seed == VOCAB_SEEDS) {
+                status = -1;
+                break;
+            }
+
+            vocab->seed[b] = seed;
+
+            for (uint32_t i = 0; i < size; i++) {
+                vocab->slot[position[i]] = keys[member[start[b] + i]];
+            }
+
+        }
+
+    }
+
+    free(start);
+    free(member);
+    free(order);
+    free(position);
+    free(taken);
+
+    return (status);
+
+}
+
+/**
+ * @brief   order two words of the vocabulary by hash, then by text
+ * @param   a the first word
+ * @param   b the second word
+ * @return  less than, equal to or greater than zero as the first word
+ *          sorts before, with or after the second
+ */
+static int
+vocabCompare(const void* a,
+             const void* b)
+{
+
+    const VocabSlot* first = a;
+    const VocabSlot* second = b;
+
+    if (first->hash != second->hash) {
+        return ((first->hash < second->hash) ? -1 : 1);
+    }
+
+    if (first->length != second->length) {
+        return ((first->length < second->length) ? -1 : 1);
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   count the words of an input against the vocabulary and display
+ *          the most frequent ones
+ * @details each word is hashed while it is filtered, then counted with one
+ *          slot lookup, one compare and one increment;  Words outside the
+ *          vocabulary are only counted in total
+ * @param   fd the input file descriptor
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+int
+vocabCount(int fd,
+           FILE* ofp)
+{
+
+    struct timespec start;
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    Vocab* vocab = vocabNew(vocabFile);
+
+    if (!vocab) {
+        return (-1);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    Input* input = inputNew(fd, inputMode);
+    InputBuffer* buffer;
+
+    /* Words longer than the longest of the vocabulary are not kept. */
+    char* word = malloc(vocab->longest + 1);
+    size_t length = 0;
+    uint64_t hash = vocabBasis;
+
+    assert(input && word);
+
+    while ((buffer = inputNext(input)) != NULL) {
+
+        for (size_t i = 0; i < buffer->length; i++) {
+
+            unsigned char letter = alphabet.fold[(unsigned char)
+                                                 buffer->data[i]];
+
+            if (letter != 0) {
+
+                if (length < vocab->longest) {
+                    word[length] = letter;
+                }
+
+                hash = vocabHash(hash, letter);
+                length++;
+
+            }
+
+            else if (length != 0) {
+
+                vocabTally(vocab, word, length, hash);
+
+                length = 0;
+                hash = vocabBasis;
+
+            }
+
+        }
+
+        inputRelease(input, buffer);
+
+    }
+
+    /* If a valid word was in process count it as well. */
+    if (length != 0) {
+        vocabTally(vocab, word, length, hash);
+    }
+
+    int status = inputFree(input);
+
+    if (status == 0) {
+        status = vocabDump(vocab, ofp);
+    }
+
+    if (countStats) {
+
+        uint64_t words = vocab->other;
+
+        for (uint32_t i = 0; i < vocab->count; i++) {
+            words += vocab->frequency[i];
+        }
+
+        fprintf(stderr, "wf: %" PRIu32 " vocabulary words in %zu bytes, "
+                "built in %.1f ms\n", vocab->count,
+                vocab->buckets * sizeof(*vocab->seed)
+                + vocab->count * (sizeof(*vocab->slot)
+                                  + sizeof(*vocab->frequency))
+                + vocab->words->used,
+                (end.tv_sec - start.tv_sec) * 1e3
+                + (end.tv_nsec - start.tv_nsec) / 1e6);
+        fprintf(stderr, "wf: %" PRIu64 " words, %" PRIu64
+                " outside the vocabulary\n", words, vocab->other);
+
+    }
+
+    free(word);
+    vocabFree(vocab);
+
+    return (status);
+
+}
+
+/**
+ * @brief   display the counted words of the vocabulary in ranked order
+ * @param   vocab the vocabulary
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+static int
+vocabDump(Vocab* vocab,
+          FILE* ofp)
+{
+
+    size_t prefix = frequencyPrefix ? strlen(frequencyPrefix) : 0;
+    Rank* rank = frequencyAll ? rankNew() : NULL;
+    Heap* heap = frequencyAll ? NULL : heapNew(frequencyCount);
+    const char** seen = malloc((vocab->count ? vocab->count : 1)
+                               * sizeof(*seen));
+    uint32_t count = 0;
+
+    int status = ((rank || heap) && seen) ? 0 : -1;
+
+    /* Only the words seen with the prefix are displayed. */
+    for (uint32_t i = 0; i < vocab->count && status == 0; i++) {
+
+        const char* word = vocab->words->base + vocab->slot[i].word;
+
+        if (vocab->frequency[i] == 0
+            || (prefix && strncmp(word, frequencyPrefix, prefix) != 0)) {
+            continue;
+        }
+
+        if (heap) {
+            status = heapOffer(heap, word, vocab->frequency[i]);
+        }
+
+        seen[count++] = word;
+
+    }
+
+    /*
+     * The full ranking breaks ties by the order the words are added in,
+     * which is byte order as from the trie.  The frequency of a word is
+     * found again at its slot.
+     */
+    if (status == 0 && rank) {
+
+        qsort(seen, count, sizeof(*seen), vocabWordCompare);
+
+        for (uint32_t i = 0; i < count && status == 0; i++) {
+
+            uint64_t hash = vocabBasis;
+
+            for (const char* letter = seen[i]; *letter != '\0'; letter++) {
+                hash = vocabHash(hash, *letter);
+            }
+
+            status = rankAdd(rank, seen[i],
+                             vocab->frequency[vocabSlot(vocab, hash)]);
+
+        }
+
+    }
+
+    if (status == 0 && rank) {
+        fflush(ofp);
+        status = rankDump(rank, fileno(ofp));
+    }
+    else if (status == 0) {
+        heapSort(heap);
+        heapDump(heap, ofp);
+    }
+
+    if (rank) {
+        rankFree(rank);
+    }
+
+    if (heap) {
+        heapFree(heap);
+    }
+
+    free(seen);
+
+    return (status);
+
+}
+
+/**
+ * @brief   release a vocabulary
+ * @param   vocab the vocabulary to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+vocabFree(Vocab* vocab)
+{
+
+    if (vocab->words) {
+        arenaFree(vocab->words);
+    }
+
+    free(vocab->seed);
+    free(vocab->slot);
+    free(vocab->frequency);
+    free(vocab);
+
+    return (0);
+
+}
+
+/**
+ * @brief   add a letter to the hash of a word
+ * @param   hash the hash of the word so far
+ * @param   letter the next letter of the word
+ * @return  the hash of the word with the letter
+ */
+static inline uint64_t
+vocabHash(uint64_t hash,
+          unsigned char letter)
+{
+
+    return ((hash ^ letter) * 1099511628211ULL);
+
+}
+
+/**
+ * @brief   salt the hash of a word
+ * @param   vocab the vocabulary
+ * @param   hash the hash of the word
+ * @return  the key of the word, placing it under the current salt
+ */
+static inline uint64_t
+vocabKey(const Vocab* vocab,
+         uint64_t hash)
+{
+
+    return (vocabMix(hash ^ vocab->salt));
+
+}
+
+/**
+ * @brief   scramble the bits of a value (the SplitMix64 finalizer)
+ * @param   value the value
+ * @return  the scrambled value
+ */
+static inline uint64_t
+vocabMix(uint64_t value)
+{
+
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+
+    return (value);
+
+}
+
+/**
+ * @brief   find the slot a seed sends a word to
+ * @param   vocab the vocabulary
+ * @param   key the salted key of the word
+ * @param   seed the seed of the bucket of the word
+ * @return  the slot of the word
+ */
+static inline uint32_t
+vocabPlace(const Vocab* vocab,
+           uint64_t key,
+           uint32_t seed)
+{
+
+    return (vocabRange(vocabMix(key + seed), vocab->count));
+
+}
+
+/**
+ * @brief   read a vocabulary and place it under a minimal perfect hash
+ * @details the file lists a word per line, folded onto the letters of the
+ *          alphabet;  Empty lines and repeated words are skipped
+ * @param   path the path of the file
+ * @return  a pointer to the new vocabulary, NULL on failure, which is
+ *          reported
+ */
+Vocab*
+vocabNew(const char* path)
+{
+
+    FILE* ifp = fopen(path, "r");
+
+    if (!ifp) {
+        fprintf(stderr, "wf: cannot open %s: %s\n", path, strerror(errno));
+        return (NULL);
+    }
+
+    Vocab* vocab = calloc(1, sizeof(*vocab));
+    size_t size = 1024;
+    VocabSlot* keys = malloc(size * sizeof(*keys));
+
+    if (vocab) {
+        vocab->words = arenaNew(4096);
+    }
+
+    int status = (vocab && keys && vocab->words) ? 0 : -1;
+
+    char* line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+    uint32_t number = 0;
+
+    while (status == 0 && (length = getline(&line, &line_size, ifp)) != -1) {
+
+        number++;
+
+        if (length > 0 && line[length - 1] == '\n') {
+            line[--length] = '\0';
+        }
+
+        if (length == 0) {
+            continue;
+        }
+
+        uint64_t hash = vocabBasis;
+
+        for (ssize_t i = 0; i < length; i++) {
+
+            line[i] = alphabet.fold[(unsigned char) line[i]];
+
+            if (line[i] == 0) {
+                fprintf(stderr, "wf: %s:%" PRIu32 ": not a word\n", path,
+                        number);
+                status = -1;
+                break;
+            }
+
+            hash = vocabHash(hash, line[i]);
+
+        }
+
+        if (status == -1) {
+            break;
+        }
+
+        if (vocab->count == size) {
+
+            VocabSlot* grown = realloc(keys, 2 * size * sizeof(*keys));
+
+            if (!grown) {
+                status = -1;
+                break;
+            }
+
+            keys = grown;
+            size *= 2;
+
+        }
+
+        uint32_t offset = arenaAppend(vocab->words, line, length);
+
+        if (offset == 0 || length > UINT32_MAX) {
+            status = -1;
+            break;
+        }
+
+        keys[vocab->count++] = (VocabSlot) {
+            .hash = hash,
+            .word = offset,
+            .length = length,
+        };
+
+        if (length > vocab->longest) {
+            vocab->longest = length;
+        }
+
+    }
+
+    free(line);
+
+    if (ferror(ifp)) {
+        fprintf(stderr, "wf: cannot read %s: %s\n", path, strerror(errno));
+        status = -1;
+    }
+
+    fclose(ifp);
+
+    /* Repeated words sort next to each other, keep the first. */
+    if (status == 0) {
+
+        qsort(keys, vocab->count, sizeof(*keys), vocabCompare);
+
+        uint32_t unique = 0;
+
+        for (uint32_t i = 0; i < vocab->count; i++) {
+
+            if (unique > 0 && vocabCompare(&keys[unique - 1], &keys[i]) == 0
+                && memcmp(vocab->words->base + keys[unique - 1].word,
+                          vocab->words->base + keys[i].word,
+                          keys[i].length) == 0) {
+                continue;
+            }
+
+            keys[unique++] = keys[i];
+
+        }
+
+        vocab->count = unique;
+        vocab->buckets = vocab->count / VOCAB_BUCKET + 1;
+        vocab->seed = calloc(vocab->buckets, sizeof(*vocab->seed));
+        vocab->slot = calloc(vocab->count ? vocab->count : 1,
+                             sizeof(*vocab->slot));
+        vocab->frequency = calloc(vocab->count ? vocab->count : 1,
+                                  sizeof(*vocab->frequency));
+
+        if (!vocab->seed || !vocab->slot || !vocab->frequency) {
+            status = -1;
+        }
+        else if (vocabBuild(vocab, keys) == -1) {
+            fprintf(stderr, "wf: cannot hash the vocabulary of %s\n", path);
+            status = -1;
+        }
+
+    }
+
+    free(keys);
+
+    if (status == -1) {
+        if (vocab) {
+            vocabFree(vocab);
+        }
+        return (NULL);
+    }
+
+    return (vocab);
+
+}
+
+/**
+ * @brief   map a value onto a range without a division
+ * @param   value the value, uniformly spread over 32 bits
+ * @param   range the size of the range
+ * @return  the value within 0 and the range, excluded
+ */
+static inline uint32_t
+vocabRange(uint32_t value,
+           uint32_t range)
+{
+
+    return (((uint64_t) value * range) >> 32);
+
+}
+
+/**
+ * @brief   find the only slot which may hold a word
+ * @param   vocab the vocabulary
+ * @param   hash the hash of the word
+ * @return  the slot of the word, if it is in the vocabulary
+ */
+static inline uint32_t
+vocabSlot(const Vocab* vocab,
+          uint64_t hash)
+{
+
+    uint64_t key = vocabKey(vocab, hash);
+
+    return (vocabPlace(vocab, key, vocab->seed[vocabBucket(vocab, key)]));
+
+}
+
+/**
+ * @brief   count a word of the text, in the vocabulary or outside of it
+ * @param   vocab the vocabulary
+ * @param   word the word, only its first letters if it is longer than the
+ *          longest word of the vocabulary
+ * @param   length the length of the word
+ * @param   hash the hash of the word
+ * @return  none
+ */
+static inline void
+vocabTally(Vocab* vocab,
+           const char* word,
+           size_t length,
+           uint64_t hash)
+{
+
+    uint32_t slot = vocabSlot(vocab, hash);
+    const VocabSlot* entry = &vocab->slot[slot];
+
+    if (entry->hash == hash && entry->length == length
+        && memcmp(vocab->words->base + entry->word, word, length) == 0) {
+        vocab->frequency[slot]++;
+    }
+    else {
+        vocab->other++;
+    }
+
+}
+
+/**
+ * @brief   compare two words for sorting in byte order
+ * @param   a pointer to the first word
+ * @param   b pointer to the second word
+ * @return  less than, equal to or greater than zero as the first word
+ *          sorts before, with or after the second
+ */
+static int
+vocabWordCompare(const void* a,
+                 const void* b)
+{
+
+    return (strcmp(*(const char* const*) a, *(const char* const*) b));
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
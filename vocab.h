@@ -0,0 +1,120 @@
+/**
+ * @file vocab.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for counting against a fixed vocabulary
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+
+enum {
+    VOCAB_BUCKET = 4,                       /** average words per bucket of
+                                                the perfect hash */
+    VOCAB_SEEDS = 1 << 24,                  /** seeds tried per bucket before
+                                                the hash is salted anew */
+    VOCAB_SALTS = 8,                        /** salts tried before giving
+                                                up on the vocabulary */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Vocab Vocab;
+typedef struct VocabSlot VocabSlot;
+
+/**
+ * @brief   object representing a word of the vocabulary at its slot
+ */
+struct VocabSlot {
+    uint64_t hash;                          /** hash of the word */
+    uint32_t word;                          /** offset of the word in the
+                                                arena */
+    uint32_t length;                        /** length of the word */
+};
+
+/**
+ * @brief   object representing a vocabulary under a minimal perfect hash
+ * @details every word hashes to a bucket, and the seed of the bucket sends
+ *          each of its words to a slot of its own;  There are as many slots
+ *          as words, so a word is counted with one hash, one compare and one
+ *          increment
+ */
+struct Vocab {
+    uint32_t count;                         /** number of words and slots */
+    uint32_t buckets;                       /** number of buckets */
+    uint32_t longest;                       /** length of the longest word */
+    uint64_t salt;                          /** salt of the word hashes */
+    uint32_t* seed;                         /** seed of each bucket */
+    VocabSlot* slot;                        /** word of each slot */
+    uint64_t* frequency;                    /** frequency of each slot */
+    uint64_t other;                         /** words outside the
+                                                vocabulary */
+    Arena* words;                           /** text of the words */
+};
+
+/**
+ * @brief   the file listing the vocabulary, NULL for none - Global
+ */
+extern const char* vocabFile;
+
+/**
+ * @brief   function prototype
+ */
+int
+vocabCount(int fd,
+           FILE* ofp);
+
+/**
+ * @brief   function prototype
+ */
+int
+vocabFree(Vocab* vocab);
+
+/**
+ * @brief   function prototype
+ */
+Vocab*
+vocabNew(const char* path);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
@@ -51,8 +51,21 @@
 
 #include <wf.h>
 
+#include <alphabet.h>
+#include <compare.h>
 #include <count.h>
+#include <document.h>
+#include <input.h>
+#include <page.h>
+#include <perfile.h>
+#include <sample.h>
+#include <serve.h>
+#include <spill.h>
 #include <squeeze.h>
+#include <stem.h>
+#include <trace.h>
+#include <vocab.h>
+#include <window.h>
 
 /*
  * forward declarations
@@ -78,6 +91,9 @@ struct Job {
 static JobFunc jobCount;
 static JobFunc jobSqueeze;
 
+static void
+usage(const char* name) __attribute__ ((noreturn));
+
 /**
  * @brief   vector of the jobs for processing the text word frequencies
  */
@@ -96,6 +112,59 @@ static uint32_t jobMax = sizeof(jobVector) / sizeof(jobVector[0]);
  */
 uint32_t frequencyCount = 20;
 
+/**
+ * @brief   display every word instead of the top words - Global
+ */
+bool frequencyAll = false;
+
+/**
+ * @brief   the prefix of the words to be displayed - Global
+ */
+const char* frequencyPrefix = NULL;
+
+/**
+ * @brief   the alphabet selected on the command line - Global
+ */
+Alphabet alphabet;
+
+/**
+ * @brief   the letters of the alphabet selected on the command line, for
+ *          the contexts of the library - Global
+ */
+const char* alphabetLetters = ALPHABET_DEFAULT;
+
+/**
+ * @brief   the long command line options
+ */
+static struct option optionVector[] = {
+    { "all",            no_argument,        NULL,   'a' },
+    { "alphabet",       required_argument,  NULL,   'A' },
+    { "batch",          optional_argument,  NULL,   'b' },
+    { "compare",        optional_argument,  NULL,   'C' },
+    { "connect",        required_argument,  NULL,   'c' },
+    { "count",          required_argument,  NULL,   'n' },
+    { "df",             no_argument,        NULL,   'd' },
+    { "engine",         required_argument,  NULL,   'e' },
+    { "hapax",          no_argument,        NULL,   'H' },
+    { "huge-pages",     no_argument,        NULL,   'G' },
+    { "input",          required_argument,  NULL,   'i' },
+    { "memory-budget",  required_argument,  NULL,   'm' },
+    { "per-file",       no_argument,        NULL,   'f' },
+    { "prefix",         required_argument,  NULL,   'p' },
+    { "relayout",       required_argument,  NULL,   'r' },
+    { "relayout-after", required_argument,  NULL,   'R' },
+    { "sample",         optional_argument,  NULL,   's' },
+    { "serve",          required_argument,  NULL,   'z' },
+    { "stats",          no_argument,        NULL,   'S' },
+    { "stem",           no_argument,        NULL,   'P' },
+    { "terms",          required_argument,  NULL,   't' },
+    { "tfidf",          no_argument,        NULL,   'T' },
+    { "trace",          required_argument,  NULL,   'X' },
+    { "vocab",          required_argument,  NULL,   'V' },
+    { "window",         required_argument,  NULL,   'w' },
+    { NULL,             0,                  NULL,   0 },
+};
+
 /**
  * @brief   entry point for the word frequency count job
  * @param   job the job entry details
@@ -108,6 +177,8 @@ jobCount(Job* job)
 
     int fd; /* input file descriptor */
 
+    traceName("count");
+
     /* The count job only reads from the pipe input, close the output. */
     close(job->channel[1]);
 
@@ -139,6 +210,8 @@ jobSqueeze(Job* job)
 
     int fd; /* output file descriptor */
 
+    traceName("squeeze");
+
     /* The squeeze job only writes to the pipe output, close the input. */
     close(job->channel[0]);
 
@@ -146,6 +219,49 @@ jobSqueeze(Job* job)
     fd = dup2(job->channel[1], STDOUT_FILENO);
     assert(fd != -1);
 
+    /*
+     * Each document is filtered in turn and ended by an empty line.  A
+     * document which cannot be opened is reported and still ended, so the
+     * documents keep their numbers.
+     */
+    if (documentRank != DOCUMENT_NONE && documentNameCount != 0) {
+
+        int status = 0;
+
+        for (uint32_t i = 0; i < documentNameCount; i++) {
+
+            FILE* ifp = (strcmp(documentNames[i], "-") == 0)
+                        ? stdin : fopen(documentNames[i], "r");
+
+            if (!ifp) {
+                fprintf(stderr, "wf: cannot open %s: %s\n",
+                        documentNames[i], strerror(errno));
+                status = -1;
+            }
+            else {
+                if (squeeze(ifp, stdout) == -1) {
+                    status = -1;
+                }
+                if (ifp != stdin) {
+                    fclose(ifp);
+                }
+            }
+
+            fputc('\n', stdout);
+
+        }
+
+        exit((fflush(stdout) == 0) ? status : -1);
+
+    }
+
+    /* A single document read from standard input is ended the same way. */
+    if (documentRank != DOCUMENT_NONE) {
+        int status = squeeze(stdin, stdout);
+        fputc('\n', stdout);
+        exit((fflush(stdout) == 0) ? status : -1);
+    }
+
     /*
      * Exit the child process with the return status from squeeze().
      * Upon exiting the child process the input and output file streams
@@ -158,6 +274,42 @@ jobSqueeze(Job* job)
 
 }
 
+/**
+ * @brief   display the command line usage and terminate
+ * @param   name the program name
+ * @return  none
+ */
+static void
+usage(const char* name)
+{
+
+    fprintf(stderr,
+            "usage: %s [ -n <COUNT> | --all ]\n"
+            "          [ --prefix=<PREFIX> | --window=<LENGTH> ]\n"
+            "          [ --memory-budget=<SIZE> | --sample[=<ROUNDS>] ]\n"
+            "          [ --input=auto|uring|thread|sync ]\n"
+            "          [ --engine=trie|radix|auto|packed ] [ --huge-pages ]\n"
+            "          [ --alphabet=<LETTERS> ] [ --relayout=bfs|hot ]\n"
+            "          [ --relayout-after=<WORDS> ] [ --batch[=<WORDS>] ]\n"
+            "          [ --vocab=<FILE> ]\n"
+            "          [ --df | --tfidf ] [ --terms=<FILE> ]\n"
+            "          [ --hapax ] [ --stem ] [ --stats ] [ --trace=<FILE> ]\n"
+            "          [ <FILE> | \"-\" ]\n"
+            "       %s --df | --tfidf [ <OPTIONS> ] <FILE> ...\n"
+            "       %s --per-file [ -n <COUNT> ] [ --prefix=<PREFIX> ]\n"
+            "          [ --alphabet=<LETTERS> ] [ <FILE> ... ]\n"
+            "       %s --serve=<SOCKET> [ --alphabet=<LETTERS> ] [ --stats ]\n"
+            "       %s --connect=<SOCKET> [ -n <COUNT> ] [ --prefix=<PREFIX> ]\n"
+            "          [ <FILE> | \"-\" ]\n"
+            "       %s --compare[=absolute|relative] [ -n <COUNT> ]\n"
+            "          [ --prefix=<PREFIX> ] [ --alphabet=<LETTERS> ]\n"
+            "          [ --huge-pages ] <FILE> <FILE>\n",
+            name, name, name, name, name, name);
+
+    exit (4);
+
+}
+
 /**
  * @brief   entry point for the "wf" program
  * @details the main() function is the entry point for the "wf" program;  It
@@ -176,37 +328,470 @@ main(int argc,
      char** argv)
 {
 
+    /* The default alphabet holds until one is given on the command line. */
+    if (alphabetParse(ALPHABET_DEFAULT, &alphabet) == -1) {
+        return (4);
+    }
+
+    /* Process any command line options. */
+    int option;
+
+    while ((option = getopt_long(argc, argv, "n:", optionVector, NULL)) != -1) {
+
+        switch (option) {
+
+            /* Number of top frequency words to be displayed. */
+            case 'n': {
+                char* end;
+                unsigned long count = strtoul(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || count == 0
+                    || count > INT32_MAX) {
+                    usage(basename(argv[0]));
+                }
+                frequencyCount = count;
+                break;
+            }
+
+            /* Rank the changes of the words between two inputs. */
+            case 'C': {
+                compareMode = COMPARE_ABSOLUTE;
+                if (optarg && compareModeParse(optarg, &compareMode) == -1) {
+                    usage(basename(argv[0]));
+                }
+                break;
+            }
+
+            /* Rank the words by the number of documents containing them. */
+            case 'd': {
+                documentRank = DOCUMENT_FREQUENCY;
+                break;
+            }
+
+            /* Rank the words by their occurrences weighted by rarity. */
+            case 'T': {
+                documentRank = DOCUMENT_TFIDF;
+                break;
+            }
+
+            /* Write out the term counts of each document. */
+            case 't': {
+                documentTerms = optarg;
+                break;
+            }
+
+            /* Display every word in ranked order. */
+            case 'a': {
+                frequencyAll = true;
+                break;
+            }
+
+            /* Insert the words into the trie a batch at a time. */
+            case 'b': {
+                countBatch = TRIE_BATCH;
+                if (optarg) {
+                    char* end;
+                    unsigned long words = strtoul(optarg, &end, 10);
+                    if (*optarg == '\0' || *end != '\0' || words == 0
+                        || words > TRIE_BATCH_MAX) {
+                        usage(basename(argv[0]));
+                    }
+                    countBatch = words;
+                }
+                break;
+            }
+
+            /* Count into and query a running server. */
+            case 'c': {
+                serveConnect = optarg;
+                break;
+            }
+
+            /* Letters the words are made of. */
+            case 'A': {
+                if (alphabetParse(optarg, &alphabet) == -1) {
+                    usage(basename(argv[0]));
+                }
+                alphabetLetters = optarg;
+                break;
+            }
+
+            /* Rank the words of each input on its own. */
+            case 'f': {
+                perFileEnabled = true;
+                break;
+            }
+
+            /* Only display words starting with the prefix. */
+            case 'p': {
+                frequencyPrefix = optarg;
+                break;
+            }
+
+            /* Structure counting the words. */
+            case 'e': {
+                if (countEngineParse(optarg, &countEngine) == -1) {
+                    usage(basename(argv[0]));
+                }
+                break;
+            }
+
+            /* Keep the words seen once out of the trie. */
+            case 'H': {
+                countHapax = true;
+                break;
+            }
+
+            /* Read-ahead strategy for the input. */
+            case 'i': {
+                if (inputModeParse(optarg, &inputMode) == -1) {
+                    usage(basename(argv[0]));
+                }
+                break;
+            }
+
+            /* Spill the counted words to disk beyond a memory budget. */
+            case 'm': {
+                if (spillBudgetParse(optarg, &spillBudget) == -1) {
+                    usage(basename(argv[0]));
+                }
+                break;
+            }
+
+            /* Order of the trie nodes after the re-layout. */
+            case 'r': {
+                if (countOrderParse(optarg, &countRelayoutOrder) == -1) {
+                    usage(basename(argv[0]));
+                }
+                if (countRelayoutAfter == 0) {
+                    countRelayoutAfter = COUNT_RELAYOUT_AFTER;
+                }
+                break;
+            }
+
+            /* Number of words counted before the trie is re-laid out. */
+            case 'R': {
+                char* end;
+                unsigned long long words = strtoull(optarg, &end, 10);
+                if (*optarg == '\0' || *end != '\0' || words == 0
+                    || words == ULLONG_MAX) {
+                    usage(basename(argv[0]));
+                }
+                countRelayoutAfter = words;
+                break;
+            }
+
+            /* Report the counting statistics. */
+            case 'S': {
+                countStats = true;
+                break;
+            }
+
+            /* Estimate from random blocks until the ranking is stable. */
+            case 's': {
+                sampleRounds = SAMPLE_STABLE;
+                if (optarg) {
+                    char* end;
+                    unsigned long rounds = strtoul(optarg, &end, 10);
+                    if (*optarg == '\0' || *end != '\0' || rounds == 0
+                        || rounds > UINT32_MAX) {
+                        usage(basename(argv[0]));
+                    }
+                    sampleRounds = rounds;
+                }
+                break;
+            }
+
+            /* Serve the counted words on a socket. */
+            case 'z': {
+                serveSocket = optarg;
+                break;
+            }
+
+            /* Record a timeline of the jobs into a trace file. */
+            case 'X': {
+                traceFile = optarg;
+                break;
+            }
+
+            /* Count the words by their stem. */
+            case 'P': {
+                stemEnabled = true;
+                break;
+            }
+
+            /* Take the trie nodes from huge pages. */
+            case 'G': {
+                countHugePages = true;
+                break;
+            }
+
+            /* Only count the words of a fixed vocabulary. */
+            case 'V': {
+                vocabFile = optarg;
+                break;
+            }
+
+            /* Only count the most recent words or time interval. */
+            case 'w': {
+                if (windowSpanParse(optarg, &windowSpan) == -1) {
+                    usage(basename(argv[0]));
+                }
+                break;
+            }
+
+            /* Error - unknown option. */
+            default: {
+                usage(basename(argv[0]));
+                break;
+            }
+
+        }
+
+    }
+
+    /*
+     * Prefix queries and spilled runs need the counts since the start of
+     * the input.
+     */
+    if (windowSpan.length != 0 && (frequencyPrefix || spillBudget != 0)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Only the trie supports removing words as they leave the window. */
+    if (windowSpan.length != 0 && countEngine != COUNT_TRIE) {
+        usage(basename(argv[0]));
+    }
+
+    /*
+     * The engine is only chosen for the words counted in memory, where the
+     * packed words are counted as well.
+     */
+    if ((countEngine == COUNT_AUTO || countEngine == COUNT_PACKED)
+        && spillBudget != 0) {
+        usage(basename(argv[0]));
+    }
+
+    /* Only the nodes of the tries are taken from huge pages. */
+    if (countHugePages && countEngine == COUNT_RADIX) {
+        usage(basename(argv[0]));
+    }
+
+    /* The pages the nodes got are reported by each process as it exits. */
+    if (countHugePages && countStats) {
+        pageReportAtExit();
+    }
+
+    /* Only the plain trie, counted to the end in memory, is re-laid out. */
+    if (countRelayoutAfter != 0
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Only the plain trie, counted to the end in memory, has a hapax set. */
+    if (countHapax
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || documentRank != DOCUMENT_NONE)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Only the plain trie, counted to the end in memory, takes batches. */
+    if (countBatch > 1
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countHapax
+            || documentRank != DOCUMENT_NONE || perFileEnabled
+            || serveSocket || serveConnect)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Sampling reads the mapped input itself, it has no memory budget. */
+    if (sampleRounds != 0 && (windowSpan.length != 0 || spillBudget != 0)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Only complete counts are ranked in full. */
+    if (frequencyAll && (windowSpan.length != 0 || sampleRounds != 0)) {
+        usage(basename(argv[0]));
+    }
+
+    /*
+     * Documents are counted by the trie to the end in memory, each one
+     * ranked in full or in part.
+     */
+    if (documentRank != DOCUMENT_NONE
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0)) {
+        usage(basename(argv[0]));
+    }
+
+    /* The weighted scores are only kept for the top words. */
+    if (documentRank == DOCUMENT_TFIDF && frequencyAll) {
+        usage(basename(argv[0]));
+    }
+
+    /* Term counts are only written out per document. */
+    if (documentTerms && documentRank == DOCUMENT_NONE) {
+        usage(basename(argv[0]));
+    }
+
+    /*
+     * A fixed vocabulary is counted in this process under a perfect hash,
+     * the words outside of it are only counted in total.
+     */
+    if (vocabFile
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0
+            || countHapax || documentRank != DOCUMENT_NONE || countBatch > 1
+            || perFileEnabled || serveSocket || serveConnect)) {
+        usage(basename(argv[0]));
+    }
+
+    /*
+     * The count job counts the surface words in the trie as usual, then
+     * folds each distinct word once into a second trie of stems at the
+     * end of the input.
+     */
+    if (stemEnabled
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0
+            || countHapax || documentRank != DOCUMENT_NONE || countBatch > 1
+            || vocabFile || compareMode != COMPARE_NONE || perFileEnabled
+            || serveSocket || serveConnect)) {
+        usage(basename(argv[0]));
+    }
+
+    /* The trace is written once this process and its jobs have exited. */
+    if (traceFile) {
+        int status = traceOpen(traceFile);
+        assert(status != -1);
+    }
+
+    /*
+     * Both inputs are counted in this process, into tries walked together
+     * once complete, and only the top changes are ranked.
+     */
+    if (compareMode != COMPARE_NONE
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0
+            || countHapax || documentRank != DOCUMENT_NONE || countBatch > 1
+            || vocabFile || frequencyAll || perFileEnabled || serveSocket
+            || serveConnect || argc - optind != 2)) {
+        usage(basename(argv[0]));
+    }
+
+    if (compareMode != COMPARE_NONE) {
+        return ((compareCount(argv[optind], argv[optind + 1],
+                              stdout) == 0) ? 0 : 2);
+    }
+
+    /*
+     * Each input is counted in this process by a pooled trie which is
+     * emptied between the inputs, and ranked in part.
+     */
+    if (perFileEnabled
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0
+            || countHapax || documentRank != DOCUMENT_NONE || frequencyAll
+            || serveSocket || serveConnect)) {
+        usage(basename(argv[0]));
+    }
+
+    /* Any number of inputs, or a manifest of their names. */
+    if (perFileEnabled) {
+        return ((perFileCount(&argv[optind], argc - optind,
+                              STDOUT_FILENO) == 0) ? 0 : 2);
+    }
+
+    /*
+     * The server counts everything it is sent in one trie, it is queried
+     * for the top words by its clients.
+     */
+    if ((serveSocket || serveConnect)
+        && (windowSpan.length != 0 || spillBudget != 0 || sampleRounds != 0
+            || countEngine != COUNT_TRIE || countRelayoutAfter != 0
+            || countHapax || documentRank != DOCUMENT_NONE || frequencyAll)) {
+        usage(basename(argv[0]));
+    }
+
+    /* The server reads from its producers only. */
+    if (serveSocket
+        && (serveConnect || frequencyPrefix || argc - optind != 0)) {
+        usage(basename(argv[0]));
+    }
+
+    if (serveSocket) {
+        return ((serve(serveSocket) == 0) ? 0 : 2);
+    }
+
+    /* A client sends at most one file to the server before its query. */
+    if (serveConnect) {
+        if (argc - optind > 1) {
+            usage(basename(argv[0]));
+        }
+        return ((serveClient(serveConnect,
+                             (argc - optind == 1) ? argv[optind] : NULL,
+                             stdout) == 0) ? 0 : 2);
+    }
+
+    /* Any number of documents are read by the squeeze job in turn. */
+    if (documentRank != DOCUMENT_NONE) {
+        documentNames = &argv[optind];
+        documentNameCount = argc - optind;
+    }
+
     /* Process any command line arguments. */
-    switch (argc) {
+    switch (argc - optind) {
 
-        /* Error - zero or one command line argument only! */
+        /* Error - zero or one command line argument only, unless documents! */
         default: {
-            fprintf(stderr,
-                    "usage: %s [ <FILE> | \"-\" ]\n",
-                    basename(argv[0]));
-            exit (4);
+            if (documentRank == DOCUMENT_NONE) {
+                usage(basename(argv[0]));
+            }
             break;
         }
 
         /* No command line arguments provided. */
-        case 1: {
+        case 0: {
             /* Input in from standard input. */
             break;
         }
 
         /* A single command line argument provided. */
-        case 2: {
-            /* "-" as the file name indicates standard input. */
-            if (strncmp(argv[1], "-", strlen("-")) != 0) {
-                fclose(stdin);
-                stdin = fopen(argv[1], "r");
-                assert(stdin);
+        case 1: {
+            /* Documents are opened by the squeeze job in turn. */
+            if (documentRank != DOCUMENT_NONE) {
+                break;
+            }
+            /*
+             * "-" as the file name indicates standard input.  Otherwise
+             * the file replaces standard input so that the squeeze job
+             * reads it through the read-ahead input layer.
+             */
+            if (strcmp(argv[optind], "-") != 0) {
+                int fd = open(argv[optind], O_RDONLY);
+                assert(fd != -1);
+                int copy = dup2(fd, STDIN_FILENO);
+                assert(copy != -1);
+                close(fd);
             }
             break;
         }
 
     }
 
+    /*
+     * A sampled estimate maps the input and counts it in this process,
+     * the filtering and frequency analysis jobs are not needed.
+     */
+    if (sampleRounds != 0) {
+        return ((sample(STDIN_FILENO, stdout) == 0) ? 0 : 2);
+    }
+
+    /* So is counting against a fixed vocabulary. */
+    if (vocabFile) {
+        return ((vocabCount(STDIN_FILENO, stdout) == 0) ? 0 : 2);
+    }
+
     /*
      * Create a pipe for IPC between the child processes.  Copy
      * the channel object into each of the jobs for pipeline setup.
@@ -44,18 +44,33 @@
 
 #pragma once
 
+#include <config.h>
+
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
 #include <libgen.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 /**
@@ -63,6 +78,16 @@
  */
 extern uint32_t frequencyCount;
 
+/**
+ * @brief   true to report every word instead of the top words
+ */
+extern bool frequencyAll;
+
+/**
+ * @brief   prefix of the reported words, NULL to report all words
+ */
+extern const char* frequencyPrefix;
+
 /*
  * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
  */
@@ -0,0 +1,799 @@
+/**
+ * @file window.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the sliding window object
+ *
+ * Words are counted per interval and the window keeps the most recent
+ * intervals;  When an interval expires its counts are subtracted again.
+ * The words are ranked by two heaps, a min-heap holding the reported words
+ * and a max-heap holding every other word, so that a count may rise or fall
+ * at a cost logarithmic in the number of words.  The max-heap is not bounded
+ * to the words which could enter the report:  When a reported word falls,
+ * the best of the others takes its place straight from the max-heap, where
+ * a bounded heap would have to find it by a scan of every word.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <arena.h>
+#include <count.h>
+#include <trie.h>
+#include <window.h>
+
+/**
+ * @brief   the sliding window selected on the command line - Global
+ */
+WindowSpan windowSpan = { 0, false };
+
+/*
+ * function prototypes
+ */
+static int
+windowBalance(Window* window);
+
+static bool
+windowBetter(const Window* window,
+             uint32_t a,
+             uint32_t b);
+
+static uint64_t
+windowClock(void);
+
+static int
+windowCompact(Window* window);
+
+static int
+windowExpire(Window* window,
+             WindowBucket* bucket);
+
+static int
+windowHeapPush(Window* window,
+               WindowHeap* heap,
+               uint32_t entry);
+
+static void
+windowHeapSift(Window* window,
+               WindowHeap* heap,
+               uint32_t position);
+
+static uint32_t
+windowHeapTake(Window* window,
+               WindowHeap* heap,
+               uint32_t position);
+
+static int
+windowRemove(Window* window,
+             uint32_t entry);
+
+static int
+windowRotate(Window* window,
+             uint32_t count);
+
+/**
+ * @brief   restore the split between the reported and the other words
+ * @details the top heap is kept full and every word within it must rank
+ *          above every other word;  After a single count changed at most
+ *          one word has to move in each direction
+ * @param   window the window
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowBalance(Window* window)
+{
+
+    WindowHeap* top = &window->top;
+    WindowHeap* rest = &window->rest;
+
+    while (top->count < window->size && rest->count > 0) {
+
+        uint32_t entry = windowHeapTake(window, rest, 0);
+
+        if (windowHeapPush(window, top, entry) == -1) {
+            return (-1);
+        }
+
+    }
+
+    if (top->count == 0 || rest->count == 0
+        || !windowBetter(window, rest->vector[0], top->vector[0])) {
+        return (0);
+    }
+
+    /* Exchange the lowest reported word and the highest other word. */
+    uint32_t low = top->vector[0];
+    uint32_t high = rest->vector[0];
+
+    top->vector[0] = high;
+    window->entries[high].top = true;
+    window->entries[high].position = 0;
+
+    rest->vector[0] = low;
+    window->entries[low].top = false;
+    window->entries[low].position = 0;
+
+    windowHeapSift(window, top, 0);
+    windowHeapSift(window, rest, 0);
+
+    return (0);
+
+}
+
+/**
+ * @brief   determine if one word ranks above another
+ * @details words rank by frequency and then in reverse lexicographical
+ *          order, matching the order of the report
+ * @param   window the window
+ * @param   a the entry of the first word
+ * @param   b the entry of the second word
+ * @return  true - a ranks above b, false - otherwise
+ */
+static bool
+windowBetter(const Window* window,
+             uint32_t a,
+             uint32_t b)
+{
+
+    const WindowEntry* x = &window->entries[a];
+    const WindowEntry* y = &window->entries[b];
+    const Counter* wide = &window->trie->wide;
+    uint64_t xFrequency = counterValue(wide, x->node->frequency);
+    uint64_t yFrequency = counterValue(wide, y->node->frequency);
+
+    if (xFrequency != yFrequency) {
+        return (xFrequency > yFrequency);
+    }
+
+    return (strcmp(window->words->base + x->word,
+                   window->words->base + y->word) > 0);
+
+}
+
+/**
+ * @brief   read the clock which times the intervals
+ * @param   none
+ * @return  the monotonic time in nanoseconds
+ */
+static uint64_t
+windowClock(void)
+{
+
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+
+    return ((uint64_t) now.tv_sec * 1000000000 + now.tv_nsec);
+
+}
+
+/**
+ * @brief   copy the counted words into a new arena, dropping expired words
+ * @param   window the window
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowCompact(Window* window)
+{
+
+    Arena* words = arenaNew(2 * window->live);
+
+    if (!words) {
+        return (-1);
+    }
+
+    for (uint32_t i = 0; i < window->entryCount; i++) {
+
+        WindowEntry* entry = &window->entries[i];
+
+        if (!entry->node) {
+            continue;
+        }
+
+        entry->word = arenaAppend(words, window->words->base + entry->word,
+                                  entry->length);
+
+        if (entry->word == 0) {
+            arenaFree(words);
+            return (-1);
+        }
+
+    }
+
+    arenaFree(window->words);
+    window->words = words;
+
+    return (0);
+
+}
+
+/**
+ * @brief   display the frequency count and word of the reported words
+ * @details the top heap is emptied in ascending order and then refilled,
+ *          so the window may continue counting afterwards
+ * @param   window the window
+ * @param   ofp the output stream for the frequency count and word display
+ * @return  0 - success, -1 - failure
+ */
+int
+windowDump(Window* window,
+           FILE* ofp)
+{
+
+    WindowHeap* top = &window->top;
+    uint32_t count = top->count;
+    uint32_t* order = malloc((count ? count : 1) * sizeof(*order));
+
+    if (!order) {
+        return (-1);
+    }
+
+    for (uint32_t i = count; i-- > 0; ) {
+        order[i] = windowHeapTake(window, top, 0);
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+
+        WindowEntry* entry = &window->entries[order[i]];
+
+        fprintf(ofp, "%" PRIu64 " %s\n",
+                counterValue(&window->trie->wide, entry->node->frequency),
+                window->words->base + entry->word);
+
+        /* The heap shrank above, so pushing back cannot fail. */
+        windowHeapPush(window, top, order[i]);
+
+    }
+
+    free(order);
+
+    return (0);
+
+}
+
+/**
+ * @brief   subtract the counts of an expired interval
+ * @param   window the window
+ * @param   bucket the interval which left the window
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowExpire(Window* window,
+             WindowBucket* bucket)
+{
+
+    for (uint32_t i = 0; i < bucket->count; i++) {
+
+        uint32_t entry = bucket->vector[i].entry;
+        WindowEntry* expire = &window->entries[entry];
+
+        counterSubtract(&window->trie->wide, &expire->node->frequency,
+                        bucket->vector[i].count);
+
+        if (expire->node->frequency == 0) {
+            if (windowRemove(window, entry) == -1) {
+                return (-1);
+            }
+            continue;
+        }
+
+        windowHeapSift(window, expire->top ? &window->top : &window->rest,
+                       expire->position);
+
+        if (windowBalance(window) == -1) {
+            return (-1);
+        }
+
+    }
+
+    bucket->count = 0;
+
+    /* Keep the dead words from growing the arena without bound. */
+    if (window->words->used > 2 * window->live + 65536) {
+        return (windowCompact(window));
+    }
+
+    return (0);
+
+}
+
+/**
+ * @brief   release a window object and everything it counted
+ * @param   window the window to be released
+ * @return  0 - success, -1 - failure
+ */
+int
+windowFree(Window* window)
+{
+
+    for (uint32_t i = 0; i < WINDOW_BUCKETS; i++) {
+        free(window->bucket[i].vector);
+    }
+
+    if (window->trie) {
+        trieFree(window->trie);
+    }
+
+    if (window->words) {
+        arenaFree(window->words);
+    }
+
+    free(window->entries);
+    free(window->top.vector);
+    free(window->rest.vector);
+    free(window);
+
+    return (0);
+
+}
+
+/**
+ * @brief   add an entry to one of the ranking heaps
+ * @param   window the window
+ * @param   heap the heap receiving the entry
+ * @param   entry the entry to be added
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowHeapPush(Window* window,
+               WindowHeap* heap,
+               uint32_t entry)
+{
+
+    if (heap->count == heap->size) {
+
+        uint32_t size = heap->size ? 2 * heap->size : 64;
+        uint32_t* vector = realloc(heap->vector, size * sizeof(*vector));
+
+        if (!vector) {
+            return (-1);
+        }
+
+        heap->vector = vector;
+        heap->size = size;
+
+    }
+
+    heap->vector[heap->count] = entry;
+    window->entries[entry].top = (heap == &window->top);
+    window->entries[entry].position = heap->count;
+    heap->count++;
+
+    windowHeapSift(window, heap, heap->count - 1);
+
+    return (0);
+
+}
+
+/**
+ * @brief   move an entry whose count changed to its place within a heap
+ * @details the top heap keeps its lowest ranking word at the root and the
+ *          rest heap its highest ranking word, so the entry is moved up or
+ *          down depending on the heap and the direction of the change
+ * @param   window the window
+ * @param   heap the heap holding the entry
+ * @param   position the position of the entry within the heap
+ * @return  none
+ */
+static void
+windowHeapSift(Window* window,
+               WindowHeap* heap,
+               uint32_t position)
+{
+
+    bool top = (heap == &window->top);
+    uint32_t* vector = heap->vector;
+    uint32_t entry = vector[position];
+
+    /* Move towards the root while the entry belongs above its parent. */
+    while (position > 0) {
+
+        uint32_t parent = (position - 1) / 2;
+
+        if (top ? !windowBetter(window, vector[parent], entry)
+                : !windowBetter(window, entry, vector[parent])) {
+            break;
+        }
+
+        vector[position] = vector[parent];
+        window->entries[vector[position]].position = position;
+        position = parent;
+
+    }
+
+    /* Move away from the root while a child belongs above the entry. */
+    for (;;) {
+
+        uint32_t child = 2 * position + 1;
+
+        if (child >= heap->count) {
+            break;
+        }
+
+        if (child + 1 < heap->count
+            && (top ? windowBetter(window, vector[child], vector[child + 1])
+                    : windowBetter(window, vector[child + 1], vector[child]))) {
+            child++;
+        }
+
+        if (top ? !windowBetter(window, entry, vector[child])
+                : !windowBetter(window, vector[child], entry)) {
+            break;
+        }
+
+        vector[position] = vector[child];
+        window->entries[vector[position]].position = position;
+        position = child;
+
+    }
+
+    vector[position] = entry;
+    window->entries[entry].position = position;
+
+}
+
+/**
+ * @brief   remove the entry at a position from one of the ranking heaps
+ * @param   window the window
+ * @param   heap the heap holding the entry
+ * @param   position the position of the entry within the heap
+ * @return  the removed entry
+ */
+static uint32_t
+windowHeapTake(Window* window,
+               WindowHeap* heap,
+               uint32_t position)
+{
+
+    uint32_t entry = heap->vector[position];
+
+    heap->count--;
+
+    if (position < heap->count) {
+        heap->vector[position] = heap->vector[heap->count];
+        window->entries[heap->vector[position]].position = position;
+        windowHeapSift(window, heap, position);
+    }
+
+    return (entry);
+
+}
+
+/**
+ * @brief   count a word within the current interval of the window
+ * @details intervals which ended before the word arrived are expired
+ *          first;  For a timed window the words of the window are reported
+ *          at the end of each interval when a report stream is set
+ * @param   window the window
+ * @param   word pointer to the word to be counted
+ * @return  0 - success, -1 - failure
+ */
+int
+windowInsert(Window* window,
+             const char* word)
+{
+
+    if (window->span.time) {
+
+        uint64_t now = windowClock();
+
+        if (now - window->start >= window->width) {
+
+            uint64_t elapsed = (now - window->start) / window->width;
+
+            if (window->report) {
+                windowDump(window, window->report);
+                fputc('\n', window->report);
+                fflush(window->report);
+            }
+
+            if (windowRotate(window, elapsed < window->buckets
+                                     ? elapsed : window->buckets) == -1) {
+                return (-1);
+            }
+
+            window->start += elapsed * window->width;
+
+        }
+
+    }
+    else if (window->filled == window->width) {
+
+        if (windowRotate(window, 1) == -1) {
+            return (-1);
+        }
+
+    }
+
+    window->filled++;
+
+    TrieNode* node = trieInsert(window->trie, word);
+
+    if (!node) {
+        return (-1);
+    }
+
+    /* A new word needs an entry and a place within the ranking. */
+    if (node->index == -1) {
+
+        if (window->unused == UINT32_MAX) {
+
+            if (window->entryCount == window->entrySize) {
+
+                uint32_t size = window->entrySize ? 2 * window->entrySize : 64;
+                WindowEntry* entries = realloc(window->entries,
+                                               size * sizeof(*entries));
+
+                if (!entries) {
+                    return (-1);
+                }
+
+                window->entries = entries;
+                window->entrySize = size;
+
+            }
+
+            window->unused = window->entryCount++;
+            window->entries[window->unused].position = UINT32_MAX;
+
+        }
+
+        uint32_t entry = window->unused;
+        WindowEntry* added = &window->entries[entry];
+
+        window->unused = added->position;
+
+        added->node = node;
+        added->length = strlen(word);
+        added->word = arenaAppend(window->words, word, added->length);
+        added->stamp = window->sequence - 1;
+
+        if (added->word == 0) {
+            added->node = NULL;
+            added->position = window->unused;
+            window->unused = entry;
+            return (-1);
+        }
+
+        node->index = entry;
+        window->live += added->length + 1;
+
+        if (windowHeapPush(window, &window->rest, entry) == -1) {
+            return (-1);
+        }
+
+    }
+    else {
+
+        WindowEntry* entry = &window->entries[node->index];
+
+        windowHeapSift(window, entry->top ? &window->top : &window->rest,
+                       entry->position);
+
+    }
+
+    if (windowBalance(window) == -1) {
+        return (-1);
+    }
+
+    /* Record the occurrence within the current interval. */
+    WindowEntry* entry = &window->entries[node->index];
+    WindowBucket* bucket = &window->bucket[window->current];
+
+    if (entry->stamp == window->sequence) {
+        bucket->vector[entry->slot].count++;
+        return (0);
+    }
+
+    if (bucket->count == bucket->size) {
+
+        uint32_t size = bucket->size ? 2 * bucket->size : 64;
+        WindowDelta* vector = realloc(bucket->vector, size * sizeof(*vector));
+
+        if (!vector) {
+            return (-1);
+        }
+
+        bucket->vector = vector;
+        bucket->size = size;
+
+    }
+
+    entry->stamp = window->sequence;
+    entry->slot = bucket->count;
+    bucket->vector[bucket->count].entry = node->index;
+    bucket->vector[bucket->count].count = 1;
+    bucket->count++;
+
+    return (0);
+
+}
+
+/**
+ * @brief   allocate a new, empty window object
+ * @param   span the length of the window
+ * @param   size the number of words to be reported
+ * @param   report the stream for the report at the end of each interval of
+ *          a timed window, NULL for none
+ * @return  a pointer to the newly allocated window object, NULL if memory
+ *          could not be allocated
+ */
+Window*
+windowNew(const WindowSpan* span,
+          uint32_t size,
+          FILE* report)
+{
+
+    Window* window;
+
+    window = calloc(1, sizeof(*window));
+    if (!window) {
+        return (NULL);
+    }
+
+    window->span = *span;
+    window->buckets = (span->length < WINDOW_BUCKETS)
+                      ? span->length : WINDOW_BUCKETS;
+    /* Intervals round up, so that the full window is never shorter. */
+    window->width = (span->length + window->buckets - 1) / window->buckets;
+    window->start = span->time ? windowClock() : 0;
+    window->sequence = 1;
+    window->unused = UINT32_MAX;
+    window->size = size;
+    window->report = report;
+    window->trie = countTrieNew();
+    window->words = arenaNew(4096);
+
+    if (!window->trie || !window->words) {
+        windowFree(window);
+        return (NULL);
+    }
+
+    return (window);
+
+}
+
+/**
+ * @brief   drop a word whose count fell to zero
+ * @details the word leaves the ranking and its nodes leave the trie, so
+ *          memory follows the words within the window and not the stream
+ * @param   window the window
+ * @param   entry the entry of the word
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowRemove(Window* window,
+             uint32_t entry)
+{
+
+    WindowEntry* removed = &window->entries[entry];
+
+    windowHeapTake(window, removed->top ? &window->top : &window->rest,
+                   removed->position);
+
+    removed->node->index = -1;
+
+    trieRemove(window->trie, window->words->base + removed->word);
+
+    window->live -= removed->length + 1;
+
+    removed->node = NULL;
+    removed->position = window->unused;
+    window->unused = entry;
+
+    return (windowBalance(window));
+
+}
+
+/**
+ * @brief   start new intervals, expiring the oldest ones
+ * @param   window the window
+ * @param   count the number of intervals to be started
+ * @return  0 - success, -1 - failure
+ */
+static int
+windowRotate(Window* window,
+             uint32_t count)
+{
+
+    for (uint32_t i = 0; i < count; i++) {
+
+        window->current = (window->current + 1) % window->buckets;
+        window->sequence++;
+
+        if (windowExpire(window, &window->bucket[window->current]) == -1) {
+            return (-1);
+        }
+
+    }
+
+    window->filled = 0;
+
+    return (0);
+
+}
+
+/**
+ * @brief   parse the length of a sliding window
+ * @details a number of words, or a time when followed by "s", "m" or "h"
+ *          for seconds, minutes or hours
+ * @param   spec the window specification
+ * @param   span the parsed window length
+ * @return  0 - success, -1 - failure
+ */
+int
+windowSpanParse(const char* spec,
+                WindowSpan* span)
+{
+
+    char* end;
+    unsigned long long length = strtoull(spec, &end, 10);
+
+    if (!isdigit((unsigned char) *spec) || length == 0) {
+        return (-1);
+    }
+
+    uint64_t scale = 0;
+
+    switch (*end) {
+        case '\0': scale = 1; break;
+        case 's': scale = 1000000000ULL; break;
+        case 'm': scale = 60 * 1000000000ULL; break;
+        case 'h': scale = 3600 * 1000000000ULL; break;
+        default: return (-1);
+    }
+
+    if (*end != '\0' && end[1] != '\0') {
+        return (-1);
+    }
+
+    if (length > UINT64_MAX / scale) {
+        return (-1);
+    }
+
+    span->length = length * scale;
+    span->time = (*end != '\0');
+
+    return (0);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
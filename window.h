@@ -0,0 +1,178 @@
+/**
+ * @file window.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the sliding window object
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+#include <arena.h>
+#include <trie.h>
+
+enum {
+    WINDOW_BUCKETS = 8,                     /** intervals within a window */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Window Window;
+typedef struct WindowBucket WindowBucket;
+typedef struct WindowDelta WindowDelta;
+typedef struct WindowEntry WindowEntry;
+typedef struct WindowHeap WindowHeap;
+typedef struct WindowSpan WindowSpan;
+
+/**
+ * @brief   object representing the length of a sliding window
+ */
+struct WindowSpan {
+    uint64_t length;        /** words or nanoseconds, 0 - no window */
+    bool time;              /** true - length is a time, false - words */
+};
+
+/**
+ * @brief   object representing the count of a word within one interval
+ */
+struct WindowDelta {
+    uint32_t entry;         /** index of the word's entry */
+    uint64_t count;         /** occurrences of the word within the interval */
+};
+
+/**
+ * @brief   object representing the word counts of one interval
+ */
+struct WindowBucket {
+    uint32_t count;         /** number of distinct words counted */
+    uint32_t size;          /** allocated size of the vector */
+    WindowDelta* vector;    /** dynamically allocated vector of counts */
+};
+
+/**
+ * @brief   object representing a word counted within the window
+ */
+struct WindowEntry {
+    TrieNode* node;         /** trie node of the word, NULL if unused */
+    uint32_t word;          /** offset of the word within the word arena */
+    uint32_t length;        /** length of the word */
+    uint32_t stamp;         /** sequence of the last interval counting it */
+    uint32_t slot;          /** index of its count within that interval */
+    uint32_t position;      /** position within its heap, or next unused */
+    bool top;               /** true - within the top heap, false - rest */
+};
+
+/**
+ * @brief   object representing one of the two ranking heaps
+ */
+struct WindowHeap {
+    uint32_t count;         /** number of entries within the heap */
+    uint32_t size;          /** allocated size of the vector */
+    uint32_t* vector;       /** dynamically allocated vector of entries */
+};
+
+/**
+ * @brief   object representing word frequencies over a sliding window
+ */
+struct Window {
+    WindowSpan span;        /** length of the window */
+    uint32_t buckets;       /** number of intervals within the window */
+    uint64_t width;         /** words or nanoseconds of one interval */
+    uint64_t start;         /** start time of the current interval */
+    uint64_t filled;        /** words counted within the current interval */
+    uint32_t current;       /** index of the current interval */
+    uint32_t sequence;      /** sequence number of the current interval */
+    WindowBucket bucket[WINDOW_BUCKETS];    /** counts of each interval */
+    Trie* trie;             /** words counted within the window */
+    Arena* words;           /** text of the counted words */
+    size_t live;            /** arena bytes of the counted words */
+    WindowEntry* entries;   /** dynamically allocated vector of entries */
+    uint32_t entryCount;    /** number of entries ever used */
+    uint32_t entrySize;     /** allocated size of the entry vector */
+    uint32_t unused;        /** first unused entry, UINT32_MAX if none */
+    uint32_t size;          /** number of words to be reported */
+    WindowHeap top;         /** min-heap of the reported words */
+    WindowHeap rest;        /** max-heap of every other word */
+    FILE* report;           /** stream for interval reports, NULL if none */
+};
+
+/**
+ * @brief   the sliding window selected on the command line - Global
+ */
+extern WindowSpan windowSpan;
+
+/**
+ * @brief   function prototype
+ */
+int
+windowDump(Window* window,
+           FILE* ofp);
+
+/**
+ * @brief   function prototype
+ */
+int
+windowFree(Window* window);
+
+/**
+ * @brief   function prototype
+ */
+int
+windowInsert(Window* window,
+             const char* word);
+
+/**
+ * @brief   function prototype
+ */
+Window*
+windowNew(const WindowSpan* span,
+          uint32_t size,
+          FILE* report);
+
+/**
+ * @brief   function prototype
+ */
+int
+windowSpanParse(const char* spec,
+                WindowSpan* span);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
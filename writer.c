@@ -0,0 +1,227 @@
+/**
+ * @file writer.c
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Implementation module for the buffered output writer
+ *
+ * Output is gathered in one large buffer and handed to write() when full,
+ * and integers are formatted two digits at a time, avoiding the per-record
+ * cost of the stdio formatting functions.
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#include <wf.h>
+
+#include <writer.h>
+
+/**
+ * @brief   the decimal digits of every number from 0 to 99
+ */
+static const char writerDigits[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * @brief   write out everything waiting in the buffer
+ * @param   writer the writer
+ * @return  0 - success, -1 - failure
+ */
+int
+writerFlush(Writer* writer)
+{
+
+    size_t done = 0;
+
+    while (done < writer->used && writer->error == 0) {
+
+        ssize_t count = write(writer->fd, writer->buffer + done,
+                              writer->used - done);
+
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            writer->error = (count == -1) ? errno : EIO;
+            break;
+        }
+
+        done += count;
+
+    }
+
+    writer->used = 0;
+
+    return ((writer->error == 0) ? 0 : -1);
+
+}
+
+/**
+ * @brief   flush and release a writer object
+ * @param   writer the writer to be released
+ * @return  0 - success, -1 - failure, a write failed
+ */
+int
+writerFree(Writer* writer)
+{
+
+    int status = writerFlush(writer);
+
+    free(writer->buffer);
+    free(writer);
+
+    return (status);
+
+}
+
+/**
+ * @brief   allocate a new writer object
+ * @param   fd the output file descriptor
+ * @param   size the size of the output buffer
+ * @return  a pointer to the newly allocated writer object, NULL if memory
+ *          could not be allocated
+ */
+Writer*
+writerNew(int fd,
+          size_t size)
+{
+
+    Writer* writer;
+
+    writer = calloc(1, sizeof(*writer));
+    if (!writer) {
+        return (NULL);
+    }
+
+    writer->size = (size != 0) ? size : WRITER_BUFFER_SIZE;
+    writer->buffer = malloc(writer->size);
+
+    if (!writer->buffer) {
+        free(writer);
+        return (NULL);
+    }
+
+    writer->fd = fd;
+    writer->used = 0;
+    writer->error = 0;
+
+    return (writer);
+
+}
+
+/**
+ * @brief   append an unsigned integer in decimal
+ * @param   writer the writer
+ * @param   value the integer
+ * @return  0 - success, -1 - failure
+ */
+int
+writerUnsigned(Writer* writer,
+               uint64_t value)
+{
+
+    char digits[20];
+    char* out = digits + sizeof(digits);
+
+    while (value >= 100) {
+        uint32_t pair = (value % 100) * 2;
+        value /= 100;
+        *--out = writerDigits[pair + 1];
+        *--out = writerDigits[pair];
+    }
+
+    if (value >= 10) {
+        *--out = writerDigits[value * 2 + 1];
+        *--out = writerDigits[value * 2];
+    }
+    else {
+        *--out = '0' + value;
+    }
+
+    return (writerWrite(writer, out, digits + sizeof(digits) - out));
+
+}
+
+/**
+ * @brief   append bytes to the buffer, writing it out when full
+ * @param   writer the writer
+ * @param   data the bytes
+ * @param   length the number of bytes
+ * @return  0 - success, -1 - failure
+ */
+int
+writerWrite(Writer* writer,
+            const char* data,
+            size_t length)
+{
+
+    while (length > 0) {
+
+        if (writer->used == writer->size && writerFlush(writer) == -1) {
+            return (-1);
+        }
+
+        size_t copy = writer->size - writer->used;
+
+        if (copy > length) {
+            copy = length;
+        }
+
+        memcpy(writer->buffer + writer->used, data, copy);
+        writer->used += copy;
+        data += copy;
+        length -= copy;
+
+    }
+
+    return ((writer->error == 0) ? 0 : -1);
+
+}
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */
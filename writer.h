@@ -0,0 +1,103 @@
+/**
+ * @file writer.h
+ *
+ * @author Robert A. Getschmann <rob@getschmann.net>
+ *
+ * @section DESCRIPTION
+ *
+ * Interface module for the buffered output writer
+ *
+ * @section LICENSE
+ *
+ * ===========================================================================
+ *
+ * Copyright © 2018, Robert A. Getschmann <rob@getschmann.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. All advertising materials mentioning features or use of this software
+ *    must display the following acknowledgement:
+ *    This product includes software developed by the <organization>.
+ * 4. Neither the name of the <organization> nor the
+ *    names of its contributors may be used to endorse or promote products
+ *    derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL <COPYRIGHT HOLDER> BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * ===========================================================================
+ */
+
+#pragma once
+
+enum {
+    WRITER_BUFFER_SIZE = 1024 * 1024,       /** size of the output buffer */
+};
+
+/*
+ * forward declarations
+ */
+typedef struct Writer Writer;
+
+/**
+ * @brief   object representing a large output buffer over a descriptor
+ */
+struct Writer {
+    int fd;             /** output file descriptor */
+    char* buffer;       /** dynamically allocated output buffer */
+    size_t size;        /** size of the output buffer */
+    size_t used;        /** number of bytes waiting in the buffer */
+    int error;          /** errno of a failed write, 0 if none */
+};
+
+/**
+ * @brief   function prototype
+ */
+int
+writerFlush(Writer* writer);
+
+/**
+ * @brief   function prototype
+ */
+int
+writerFree(Writer* writer);
+
+/**
+ * @brief   function prototype
+ */
+Writer*
+writerNew(int fd,
+          size_t size);
+
+/**
+ * @brief   function prototype
+ */
+int
+writerUnsigned(Writer* writer,
+               uint64_t value);
+
+/**
+ * @brief   function prototype
+ */
+int
+writerWrite(Writer* writer,
+            const char* data,
+            size_t length);
+
+/*
+ * vim: cindent:cinoptions+={0,>1s,(0,t0,l1,^0:expandtab:smartindent:sw=4:ts=4:tw=0
+ */